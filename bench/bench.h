@@ -0,0 +1,44 @@
+/* Helpers shared by benchmarks */
+
+#ifndef SEALLOC_BENCH_H_
+#define SEALLOC_BENCH_H_
+
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_UNIT "cycles"
+#elif defined(__aarch64__)
+#define BENCH_UNIT "ticks"
+#else
+#define BENCH_UNIT "ns"
+#endif
+
+/*!
+ * @brief Reads cheapest available timestamp counter.
+ *
+ * TSC on x86, virtual counter on aarch64, monotonic clock otherwise.
+ */
+static inline uint64_t bench_now(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#elif defined(__aarch64__)
+  uint64_t val;
+  __asm__ volatile("mrs %0, cntvct_el0" : "=r"(val));
+  return val;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/*!
+ * @brief Prevents compiler from optimizing away computation of ptr.
+ */
+static inline void bench_escape(void *ptr) {
+  __asm__ volatile("" : : "g"(ptr) : "memory");
+}
+
+#endif /* SEALLOC_BENCH_H_ */
@@ -0,0 +1,67 @@
+/*
+ * Compares request-scoped teardown by freeing every region with destroying
+ * the whole arena.
+ *
+ * For every object count, objects of mixed sizes are allocated from a fresh
+ * arena. Column "free" releases them with sealloc_free() one by one, column
+ * "destroy" calls arena_destroy(). Only teardown is measured.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "sealloc/arena.h"
+#include "sealloc/random.h"
+#include "sealloc/sealloc.h"
+
+#define ROUNDS 10
+
+static const size_t sizes[] = {16, 48, 128, 512, 2048, 8192};
+
+static void fill(arena_t *arena, void **ptrs, size_t n) {
+  arena->is_initialized = 0;
+  arena_init(arena);
+  for (size_t i = 0; i < n; i++)
+    ptrs[i] = sealloc_malloc(arena, sizes[i % (sizeof(sizes) / sizeof(sizes[0]))]);
+}
+
+static double bench_free(void **ptrs, size_t n) {
+  arena_t arena;
+  uint64_t total = 0, start;
+  for (unsigned r = 0; r < ROUNDS; r++) {
+    fill(&arena, ptrs, n);
+    start = bench_now();
+    for (size_t i = 0; i < n; i++) sealloc_free(&arena, ptrs[i]);
+    total += bench_now() - start;
+    arena_destroy(&arena);
+  }
+  return (double)total / ROUNDS;
+}
+
+static double bench_destroy(void **ptrs, size_t n) {
+  arena_t arena;
+  uint64_t total = 0, start;
+  for (unsigned r = 0; r < ROUNDS; r++) {
+    fill(&arena, ptrs, n);
+    start = bench_now();
+    arena_destroy(&arena);
+    total += bench_now() - start;
+  }
+  return (double)total / ROUNDS;
+}
+
+int main(void) {
+  const size_t counts[] = {1000, 10000, 100000};
+  void **ptrs = malloc(sizeof(void *) * counts[2]);
+  if (ptrs == NULL) return 1;
+  printf("%8s %14s %14s  (%s per teardown)\n", "objects", "free", "destroy",
+         BENCH_UNIT);
+  for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+    double f = bench_free(ptrs, counts[i]);
+    double d = bench_destroy(ptrs, counts[i]);
+    printf("%8zu %14.0f %14.0f\n", counts[i], f, d);
+  }
+  free(ptrs);
+  return 0;
+}
@@ -0,0 +1,73 @@
+/*
+ * Compares batch allocation API with per-call loops.
+ *
+ * For every size, BATCH regions are allocated and then freed in shuffled
+ * order. Column "loop" uses sealloc_malloc()/sealloc_free() for each region,
+ * column "batch" uses sealloc_batch_malloc()/sealloc_batch_free().
+ */
+
+#include <stdio.h>
+
+#include "bench.h"
+#include "sealloc/arena.h"
+#include "sealloc/random.h"
+#include "sealloc/sealloc.h"
+
+#define BATCH 1024
+#define ROUNDS 50
+
+static void *ptrs[BATCH];
+
+static void shuffle(void **arr, size_t n) {
+  for (size_t i = n - 1; i > 0; i--) {
+    size_t j = splitmix32() % (i + 1);
+    void *tmp = arr[i];
+    arr[i] = arr[j];
+    arr[j] = tmp;
+  }
+}
+
+static double bench_loop(size_t size) {
+  arena_t arena = {0};
+  uint64_t total = 0, start;
+  arena_init(&arena);
+  for (unsigned r = 0; r < ROUNDS; r++) {
+    start = bench_now();
+    for (size_t i = 0; i < BATCH; i++) ptrs[i] = sealloc_malloc(&arena, size);
+    total += bench_now() - start;
+    shuffle(ptrs, BATCH);
+    start = bench_now();
+    for (size_t i = 0; i < BATCH; i++) sealloc_free(&arena, ptrs[i]);
+    total += bench_now() - start;
+  }
+  return (double)total / (ROUNDS * BATCH);
+}
+
+static double bench_batch(size_t size) {
+  arena_t arena = {0};
+  uint64_t total = 0, start;
+  arena_init(&arena);
+  for (unsigned r = 0; r < ROUNDS; r++) {
+    start = bench_now();
+    sealloc_batch_malloc(&arena, size, BATCH, ptrs);
+    total += bench_now() - start;
+    shuffle(ptrs, BATCH);
+    start = bench_now();
+    sealloc_batch_free(&arena, ptrs, BATCH);
+    total += bench_now() - start;
+  }
+  return (double)total / (ROUNDS * BATCH);
+}
+
+int main(void) {
+  const size_t sizes[] = {16, 64, 256, 512, 1024, 4096, 8192};
+  init_splitmix32(1);
+  printf("%8s %12s %12s  (%s per region, malloc + free)\n", "size", "loop",
+         "batch", BENCH_UNIT);
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    double loop = bench_loop(sizes[i]);
+    double batch = bench_batch(sizes[i]);
+    printf("%8zu %12.1f %12.1f\n", sizes[i], loop, batch);
+  }
+  return 0;
+}
@@ -0,0 +1,59 @@
+/*
+ * Measures bulk bitset kernels on bitsets sized like run bitmaps.
+ *
+ * Every implementation supported by the CPU is run over the same random
+ * bitsets. Largest small-class run has 1024 regions, which is 16 words.
+ */
+
+#include <stdio.h>
+
+#include "bench.h"
+#include "sealloc/bitset.h"
+#include "sealloc/random.h"
+
+#define ITERATIONS 200000
+#define MAX_WORDS 16
+
+static const char *impl_names[] = {"generic", "popcnt", "avx2"};
+
+static uint64_t set_a[MAX_WORDS], set_b[MAX_WORDS];
+
+static double bench_count(size_t words) {
+  uint64_t start = bench_now();
+  size_t acc = 0;
+  for (unsigned i = 0; i < ITERATIONS; i++)
+    acc += bitset_count_andnot(set_a, set_b, words);
+  bench_escape(&acc);
+  return (double)(bench_now() - start) / ITERATIONS;
+}
+
+static double bench_walk(size_t words) {
+  uint64_t start = bench_now();
+  size_t acc = 0;
+  for (unsigned i = 0; i < ITERATIONS / 100; i++) {
+    for (size_t idx = bitset_find_next_andnot(set_a, set_b, words, 0);
+         idx != SIZE_MAX;
+         idx = bitset_find_next_andnot(set_a, set_b, words, idx + 1))
+      acc += idx;
+  }
+  bench_escape(&acc);
+  return (double)(bench_now() - start) / (ITERATIONS / 100);
+}
+
+int main(void) {
+  init_splitmix64(1);
+  for (size_t i = 0; i < MAX_WORDS; i++) {
+    set_a[i] = splitmix64();
+    // Sparse live set, as in a mostly freed run
+    set_b[i] = ~(splitmix64() & splitmix64() & splitmix64());
+  }
+  printf("%-8s %6s %12s %12s  (%s per call / per walk)\n", "impl", "words",
+         "count", "walk", BENCH_UNIT);
+  for (int impl = BITSET_IMPL_GENERIC; impl <= BITSET_IMPL_AVX2; impl++) {
+    if (!bitset_select_impl((bitset_impl_t)impl)) continue;
+    for (size_t words = 1; words <= MAX_WORDS; words *= 2)
+      printf("%-8s %6zu %12.1f %12.1f\n", impl_names[impl], words,
+             bench_count(words), bench_walk(words));
+  }
+  return 0;
+}
@@ -0,0 +1,73 @@
+/*
+ * Compares sized free with plain free at a realistic number of live objects.
+ *
+ * For every size, LIVE regions are kept allocated. Each round frees BATCH of
+ * them picked at random and allocates them again, only the frees are timed.
+ * Column "free" uses sealloc_free(), column "free_sized" uses
+ * sealloc_free_sized(). Regions are spread over thousands of runs, so lookups
+ * which walk runs of a bin show up here.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "bench.h"
+#include "sealloc/arena.h"
+#include "sealloc/random.h"
+#include "sealloc/sealloc.h"
+
+#define LIVE 200000
+#define BATCH 20000
+#define ROUNDS 10
+
+static void *ptrs[LIVE];
+static unsigned slots[LIVE];
+
+static void shuffle(unsigned *arr, size_t n) {
+  for (size_t i = n - 1; i > 0; i--) {
+    size_t j = splitmix32() % (i + 1);
+    unsigned tmp = arr[i];
+    arr[i] = arr[j];
+    arr[j] = tmp;
+  }
+}
+
+static double bench_free(size_t size, bool sized) {
+  arena_t arena = {0};
+  uint64_t total = 0, start;
+  void *ptr;
+  arena_init(&arena);
+  for (unsigned i = 0; i < LIVE; i++) {
+    ptrs[i] = sealloc_malloc(&arena, size);
+    slots[i] = i;
+  }
+  for (unsigned r = 0; r < ROUNDS; r++) {
+    shuffle(slots, LIVE);
+    start = bench_now();
+    for (unsigned i = 0; i < BATCH; i++) {
+      ptr = ptrs[slots[i]];
+      if (sized)
+        sealloc_free_sized(&arena, ptr, size);
+      else
+        sealloc_free(&arena, ptr);
+    }
+    total += bench_now() - start;
+    for (unsigned i = 0; i < BATCH; i++)
+      ptrs[slots[i]] = sealloc_malloc(&arena, size);
+  }
+  arena_destroy(&arena);
+  return (double)total / (ROUNDS * BATCH);
+}
+
+int main(void) {
+  const size_t sizes[] = {32, 512, 4096};
+  init_splitmix32(1);
+  printf("%8s %12s %12s  (%s per free, %u live objects)\n", "size", "free",
+         "free_sized", BENCH_UNIT, LIVE);
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    double plain = bench_free(sizes[i], false);
+    double sized = bench_free(sizes[i], true);
+    printf("%8zu %12.1f %12.1f\n", sizes[i], plain, sized);
+  }
+  return 0;
+}
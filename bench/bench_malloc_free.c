@@ -0,0 +1,85 @@
+/*
+ * Measures cost of a malloc/free pair for every size class.
+ *
+ * Column "run" exercises only run_allocate()/run_deallocate() on a single run,
+ * which isolates region index computation. Column "arena" goes through
+ * sealloc_malloc()/sealloc_free() and includes metadata lookup, run retirement
+ * and release of memory back to the chunk.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "sealloc/arena.h"
+#include "sealloc/bin.h"
+#include "sealloc/random.h"
+#include "sealloc/run.h"
+#include "sealloc/sealloc.h"
+#include "sealloc/size_class.h"
+#include "sealloc/utils.h"
+
+#define PAIRS_REGULAR 200000
+#define PAIRS_LARGE 20000
+
+static double bench_run(unsigned reg_size, unsigned pairs) {
+  bin_t bin;
+  bin_init(&bin, reg_size);
+  void *heap = malloc(bin.run_size_pages * PAGE_SIZE);
+  run_t *run = malloc(run_metadata_size(&bin));
+  uint64_t total = 0, start;
+  void *ptr;
+
+  run_init(run, &bin, heap);
+  for (unsigned i = 0; i < pairs; i++) {
+    if (run_is_depleted(run)) run_init(run, &bin, heap);
+    start = bench_now();
+    ptr = run_allocate(run, &bin);
+    bench_escape(ptr);
+    run_deallocate(run, &bin, ptr);
+    total += bench_now() - start;
+  }
+  free(run);
+  free(heap);
+  return (double)total / pairs;
+}
+
+static double bench_arena(unsigned reg_size, unsigned pairs) {
+  arena_t arena = {0};
+  uint64_t start, end;
+  void *ptr;
+
+  arena_init(&arena);
+  // Warm up, so that bin is supplied with runs
+  sealloc_free(&arena, sealloc_malloc(&arena, reg_size));
+  start = bench_now();
+  for (unsigned i = 0; i < pairs; i++) {
+    ptr = sealloc_malloc(&arena, reg_size);
+    bench_escape(ptr);
+    sealloc_free(&arena, ptr);
+  }
+  end = bench_now();
+  return (double)(end - start) / pairs;
+}
+
+static void bench_class(const char *class, unsigned reg_size, unsigned pairs) {
+  double run = bench_run(reg_size, pairs);
+  double arena = bench_arena(reg_size, pairs);
+  printf("%-6s %8u %12.1f %12.1f\n", class, reg_size, run, arena);
+}
+
+int main(void) {
+  init_splitmix32(1);
+  printf("%-6s %8s %12s %12s  (%s per pair)\n", "class", "reg_size", "run",
+         "arena", BENCH_UNIT);
+  for (unsigned size = SMALL_SIZE_MIN_REGION; size <= SMALL_SIZE_MAX_REGION;
+       size += SMALL_SIZE_CLASS_ALIGNMENT)
+    bench_class("small", size, PAIRS_REGULAR);
+  for (unsigned size = MEDIUM_SIZE_MIN_REGION; size <= MEDIUM_SIZE_MAX_REGION;
+       size *= 2)
+    bench_class("medium", size, PAIRS_REGULAR);
+  for (unsigned size = LARGE_SIZE_MIN_REGION; size <= LARGE_SIZE_MAX_REGION;
+       size *= 2)
+    bench_class("large", size, PAIRS_LARGE);
+  return 0;
+}
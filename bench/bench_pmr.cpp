@@ -0,0 +1,79 @@
+/*
+ * Compares containers on a sealloc memory resource with containers on the
+ * default resource.
+ *
+ * For every element count, a std::pmr::vector is grown by push_back and a
+ * std::pmr::unordered_map is filled, then both are destroyed. Column "default"
+ * uses std::pmr::new_delete_resource(), column "sealloc" uses
+ * sealloc::memory_resource with its own arena. Column "release" does the same
+ * on sealloc resource, but skips destructors of containers, so their memory is
+ * released together with the arena. Arena creation and destruction are
+ * measured in both sealloc columns.
+ */
+
+#include <cstdio>
+#include <memory_resource>
+#include <new>
+#include <sealloc_pmr.hpp>
+#include <unordered_map>
+#include <vector>
+
+#include "bench.h"
+
+#define ROUNDS 10
+
+using vec_t = std::pmr::vector<long>;
+using map_t = std::pmr::unordered_map<long, long>;
+
+static void fill(std::pmr::memory_resource *mr, size_t n, bool destroy) {
+  alignas(vec_t) unsigned char vec_storage[sizeof(vec_t)];
+  alignas(map_t) unsigned char map_storage[sizeof(map_t)];
+  vec_t *vec = new (vec_storage) vec_t(mr);
+  map_t *map = new (map_storage) map_t(mr);
+  for (size_t i = 0; i < n; i++) {
+    vec->push_back((long)i);
+    map->emplace((long)i, (long)i);
+  }
+  bench_escape(vec->data());
+  bench_escape(map);
+  if (destroy) {
+    vec->~vec_t();
+    map->~map_t();
+  }
+}
+
+static double bench_default(size_t n) {
+  uint64_t total = 0, start;
+  for (unsigned r = 0; r < ROUNDS; r++) {
+    start = bench_now();
+    fill(std::pmr::new_delete_resource(), n, true);
+    total += bench_now() - start;
+  }
+  return (double)total / (ROUNDS * n);
+}
+
+static double bench_sealloc(size_t n, bool destroy) {
+  uint64_t total = 0, start;
+  for (unsigned r = 0; r < ROUNDS; r++) {
+    start = bench_now();
+    {
+      sealloc::memory_resource mr;
+      fill(&mr, n, destroy);
+    }
+    total += bench_now() - start;
+  }
+  return (double)total / (ROUNDS * n);
+}
+
+int main(void) {
+  const size_t counts[] = {1000, 10000, 100000};
+  printf("%8s %10s %10s %10s  (%s per element)\n", "elements", "default",
+         "sealloc", "release", BENCH_UNIT);
+  for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+    double d = bench_default(counts[i]);
+    double s = bench_sealloc(counts[i], true);
+    double r = bench_sealloc(counts[i], false);
+    printf("%8zu %10.0f %10.0f %10.0f\n", counts[i], d, s, r);
+  }
+  return 0;
+}
@@ -0,0 +1,83 @@
+/*
+ * Compares object pools with plain malloc for fixed-size objects.
+ *
+ * For every object size, COUNT objects are allocated and then freed in
+ * shuffled order. Column "malloc" uses sealloc_malloc()/sealloc_free(), column
+ * "pool" uses a pool created for that size. Memory column shows run memory
+ * used per object.
+ */
+
+#include <stdio.h>
+
+#include "bench.h"
+#include "sealloc/arena.h"
+#include "sealloc/pool.h"
+#include "sealloc/random.h"
+#include "sealloc/run.h"
+#include "sealloc/sealloc.h"
+
+#define COUNT 200000
+#define ROUNDS 10
+
+static void *ptrs[COUNT];
+
+static void shuffle(void **arr, size_t n) {
+  for (size_t i = n - 1; i > 0; i--) {
+    size_t j = splitmix32() % (i + 1);
+    void *tmp = arr[i];
+    arr[i] = arr[j];
+    arr[j] = tmp;
+  }
+}
+
+static double bench_malloc(size_t size) {
+  arena_t arena = {0};
+  uint64_t total = 0, start;
+  arena_init(&arena);
+  for (unsigned r = 0; r < ROUNDS; r++) {
+    start = bench_now();
+    for (size_t i = 0; i < COUNT; i++) ptrs[i] = sealloc_malloc(&arena, size);
+    total += bench_now() - start;
+    shuffle(ptrs, COUNT);
+    start = bench_now();
+    for (size_t i = 0; i < COUNT; i++) sealloc_free(&arena, ptrs[i]);
+    total += bench_now() - start;
+  }
+  return (double)total / (ROUNDS * COUNT);
+}
+
+static double bench_pool(size_t size) {
+  arena_t arena = {0};
+  uint64_t total = 0, start;
+  arena_init(&arena);
+  pool_t *pool = sealloc_create_pool(&arena, size, 8);
+  for (unsigned r = 0; r < ROUNDS; r++) {
+    start = bench_now();
+    for (size_t i = 0; i < COUNT; i++) ptrs[i] = sealloc_malloc_from_pool(pool);
+    total += bench_now() - start;
+    shuffle(ptrs, COUNT);
+    start = bench_now();
+    for (size_t i = 0; i < COUNT; i++) sealloc_free_to_pool(pool, ptrs[i]);
+    total += bench_now() - start;
+  }
+  sealloc_destroy_pool(pool);
+  return (double)total / (ROUNDS * COUNT);
+}
+
+int main(void) {
+  const size_t sizes[] = {24, 48, 200};
+  init_splitmix32(1);
+  printf("%8s %12s %12s %14s %14s  (%s per object, malloc + free)\n", "size",
+         "malloc", "pool", "malloc bytes", "pool bytes", BENCH_UNIT);
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    double m = bench_malloc(sizes[i]);
+    double p = bench_pool(sizes[i]);
+    unsigned class_size = alignup_size(sizes[i]);
+    unsigned reg_size = pool_reg_size(sizes[i], 8);
+    unsigned run_size = pool_run_size_pages(reg_size) * PAGE_SIZE;
+    printf("%8zu %12.1f %12.1f %14.1f %14.1f\n", sizes[i], m, p,
+           (double)RUN_SIZE_SMALL_BYTES / (RUN_SIZE_SMALL_BYTES / class_size),
+           (double)run_size / (run_size / reg_size));
+  }
+  return 0;
+}
@@ -0,0 +1,98 @@
+/*
+ * Measures overhead of heap profiler sampling.
+ *
+ * The same sequence of operations is replayed against fresh arenas with
+ * profiling off, with prof_interval of 512 KiB and with interval 64 times
+ * shorter, which lifts cost of a single sample above noise. Working set of
+ * regions of random small and medium sizes is kept, each operation frees a
+ * random slot, alternating sealloc_free() and sealloc_free_sized(), and
+ * allocates it again. Configurations are interleaved and the fastest of
+ * several rounds is kept, so that frequency scaling affects all the same way.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "sealloc/arena.h"
+#include "sealloc/ctl.h"
+#include "sealloc/random.h"
+#include "sealloc/sealloc.h"
+#include "sealloc/size_class.h"
+
+#define SLOTS 4096
+#define OPS 1000000
+#define ROUNDS 15
+#define PROF_INTERVAL 524288
+#define PROF_DENSE_INTERVAL 8192
+
+static unsigned sizes[OPS];
+static unsigned slots[OPS];
+
+static double bench_workload(unsigned interval, size_t *nsamples) {
+  static void *ptrs[SLOTS];
+  static unsigned ptr_sizes[SLOTS];
+  arena_t arena = {0};
+  uint64_t start, end;
+  unsigned slot;
+
+  arena_init(&arena);
+  ctl_by_name(&arena, "arena.0.conf.prof_interval", NULL, NULL, &interval,
+              sizeof(interval));
+  for (unsigned i = 0; i < SLOTS; i++) {
+    ptr_sizes[i] = sizes[i];
+    ptrs[i] = sealloc_malloc(&arena, ptr_sizes[i]);
+  }
+  start = bench_now();
+  for (unsigned i = 0; i < OPS; i++) {
+    slot = slots[i];
+    if (i % 2 == 0)
+      sealloc_free(&arena, ptrs[slot]);
+    else
+      sealloc_free_sized(&arena, ptrs[slot], ptr_sizes[slot]);
+    ptr_sizes[slot] = sizes[i];
+    ptrs[slot] = sealloc_malloc(&arena, sizes[i]);
+    bench_escape(ptrs[slot]);
+  }
+  end = bench_now();
+  *nsamples = arena.prof.nsamples;
+  for (unsigned i = 0; i < SLOTS; i++) sealloc_free(&arena, ptrs[i]);
+  arena_destroy(&arena);
+  return (double)(end - start) / OPS;
+}
+
+int main(void) {
+  double off = 0, on = 0, dense = 0, cost, per_sample;
+  size_t nsamples, ndense;
+
+  init_splitmix32(1);
+  // Mostly small sizes, like typical programs
+  for (unsigned i = 0; i < OPS; i++) {
+    sizes[i] = splitmix32() % 4 == 0
+                   ? (unsigned)MEDIUM_SIZE_MIN_REGION << (splitmix32() % 4)
+                   : 1 + splitmix32() % SMALL_SIZE_MAX_REGION;
+    slots[i] = splitmix32() % SLOTS;
+  }
+  for (unsigned r = 0; r < ROUNDS; r++) {
+    cost = bench_workload(0, &nsamples);
+    if (r == 0 || cost < off) off = cost;
+    cost = bench_workload(PROF_INTERVAL, &nsamples);
+    if (r == 0 || cost < on) on = cost;
+    cost = bench_workload(PROF_DENSE_INTERVAL, &ndense);
+    if (r == 0 || cost < dense) dense = cost;
+  }
+  // Difference at the real interval is within noise of a single core, cost
+  // of one sample is measured with many more of them
+  per_sample = (dense - off) * OPS / (double)ndense;
+  printf("%-22s %12s  (%s per free+malloc)\n", "prof_interval", "cost",
+         BENCH_UNIT);
+  printf("%-22s %12.1f\n", "off", off);
+  printf("%-22u %12.1f\n", PROF_INTERVAL, on);
+  printf("%-22u %12.1f\n", PROF_DENSE_INTERVAL, dense);
+  printf("%.0f %s per sample, %zu samples at %u\n", per_sample, BENCH_UNIT,
+         nsamples, PROF_INTERVAL);
+  printf("overhead at %u: %.2f%% measured, %.2f%% from cost per sample\n",
+         PROF_INTERVAL, 100.0 * (on - off) / off,
+         100.0 * per_sample * nsamples / (off * OPS));
+  return 0;
+}
@@ -0,0 +1,305 @@
+/*
+ * Replays allocation trace recorded with SEALLOC_TRACE_FILE.
+ *
+ * Events are replayed in recorded order on a single thread, against private
+ * sealloc arena or against glibc malloc with --glibc. Arena is seeded from
+ * SEALLOC_SEED, or from random seed which is printed, so that the run can be
+ * repeated with exactly the same heap layout.
+ *
+ * One byte of every page of each new allocation is written outside of timed
+ * section, so that resident memory is comparable between allocators. Reported
+ * peak RSS and VMA count are relative to the state before replay.
+ */
+
+#include <fcntl.h>
+#include <malloc.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sealloc/arena.h"
+#include "sealloc/platform_api.h"
+#include "sealloc/sealloc.h"
+#include "sealloc/trace.h"
+#include "sealloc/utils.h"
+
+// Records replayed between samples of VMA count
+#define REPLAY_VMA_INTERVAL 4096
+
+// Records replayed before consumed part of trace is dropped from memory
+#define REPLAY_DROP_INTERVAL 65536
+
+typedef struct replay_slot {
+  uint64_t id;
+  void *ptr; /* NULL once freed */
+} replay_slot_t;
+
+typedef struct replay {
+  int use_glibc;
+  arena_t arena;
+  replay_slot_t *table;
+  size_t table_mask;
+  uint32_t *latency; /* Nanoseconds per event */
+  size_t nops;
+  size_t nskipped;
+  long vmas_max;
+} replay_t;
+
+static void *replay_map(size_t len) {
+  void *ptr = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+  if (ptr == MAP_FAILED) {
+    perror("mmap");
+    exit(1);
+  }
+  return ptr;
+}
+
+static uint64_t replay_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Counts lines of /proc/self/maps without allocating
+static long replay_count_vmas(void) {
+  char buf[4096];
+  ssize_t len;
+  long cnt = 0;
+  int fd = open("/proc/self/maps", O_RDONLY);
+  if (fd < 0) return -1;
+  while ((len = read(fd, buf, sizeof(buf))) > 0) {
+    for (ssize_t i = 0; i < len; i++) cnt += buf[i] == '\n';
+  }
+  close(fd);
+  return cnt;
+}
+
+static long replay_max_rss_kb(void) {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+// Slot holding id, or empty slot where it belongs
+static replay_slot_t *replay_slot(replay_t *rp, uint64_t id) {
+  size_t idx = (size_t)((id >> 4) * UINT64_C(0x9E3779B97F4A7C15)) &
+               rp->table_mask;
+  while (rp->table[idx].id != 0 && rp->table[idx].id != id)
+    idx = (idx + 1) & rp->table_mask;
+  return &rp->table[idx];
+}
+
+// Pointer replaying allocation id, NULL if it is unknown or freed
+static void *replay_lookup(replay_t *rp, uint64_t id) {
+  if (id == 0) return NULL;
+  return replay_slot(rp, id)->ptr;
+}
+
+static void replay_touch(void *ptr, size_t size) {
+  volatile char *mem = ptr;
+  for (size_t off = 0; off < size; off += PAGE_SIZE) mem[off] = 1;
+}
+
+// Bytes allocated by the record, calloc records hold element size and count
+static size_t replay_size(const trace_record_t *rec) {
+  if (rec->op != TRACE_OP_CALLOC) return rec->size;
+  // Replayed calloc would have failed on overflow
+  if (rec->arg != 0 && rec->size > SIZE_MAX / rec->arg) return 0;
+  return rec->size * rec->arg;
+}
+
+static void *replay_alloc(replay_t *rp, const trace_record_t *rec,
+                          void *old) {
+  switch (rec->op) {
+    case TRACE_OP_MALLOC:
+      return rp->use_glibc ? malloc(rec->size)
+                           : sealloc_malloc(&rp->arena, rec->size);
+    case TRACE_OP_CALLOC:
+      return rp->use_glibc ? calloc(rec->arg, rec->size)
+                           : sealloc_calloc(&rp->arena, rec->arg, rec->size);
+    case TRACE_OP_REALLOC:
+      return rp->use_glibc ? realloc(old, rec->size)
+                           : sealloc_realloc(&rp->arena, old, rec->size);
+    default:
+      return rp->use_glibc
+                 ? memalign(rec->arg, rec->size)
+                 : sealloc_aligned_alloc(&rp->arena, rec->arg, rec->size);
+  }
+}
+
+static void replay_free(replay_t *rp, const trace_record_t *rec, void *ptr) {
+  if (rp->use_glibc)
+    free(ptr);
+  else if (rec->size == 0)
+    sealloc_free(&rp->arena, ptr);
+  else if (rec->arg == 0)
+    sealloc_free_sized(&rp->arena, ptr, rec->size);
+  else
+    sealloc_free_aligned_sized(&rp->arena, ptr, rec->arg, rec->size);
+}
+
+static void replay_record(replay_t *rp, const trace_record_t *rec) {
+  replay_slot_t *slot;
+  void *old = NULL, *ptr;
+  uint64_t start;
+
+  if (rec->op == TRACE_OP_FREE) {
+    slot = replay_slot(rp, rec->id);
+    // Allocated before tracing started
+    if (slot->ptr == NULL) {
+      rp->nskipped++;
+      return;
+    }
+    start = replay_now();
+    replay_free(rp, rec, slot->ptr);
+    rp->latency[rp->nops++] = (uint32_t)(replay_now() - start);
+    slot->ptr = NULL;
+    return;
+  }
+
+  // Failed allocations are not replayed
+  if (rec->id == 0) {
+    rp->nskipped++;
+    return;
+  }
+  if (rec->op == TRACE_OP_REALLOC) old = replay_lookup(rp, rec->arg);
+  start = replay_now();
+  ptr = replay_alloc(rp, rec, old);
+  rp->latency[rp->nops++] = (uint32_t)(replay_now() - start);
+  // glibc frees on realloc to 0 bytes
+  if (ptr == NULL && rec->op == TRACE_OP_REALLOC && rec->size == 0) {
+    if (old != NULL) replay_slot(rp, rec->arg)->ptr = NULL;
+    return;
+  }
+  if (ptr == NULL) {
+    fprintf(stderr, "Allocation of %zu bytes failed\n", (size_t)rec->size);
+    exit(1);
+  }
+  if (old != NULL) replay_slot(rp, rec->arg)->ptr = NULL;
+  slot = replay_slot(rp, rec->id);
+  slot->id = rec->id;
+  slot->ptr = ptr;
+  replay_touch(ptr, replay_size(rec));
+}
+
+static int replay_cmp(const void *a, const void *b) {
+  uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+  return (x > y) - (x < y);
+}
+
+static uint32_t replay_percentile(const replay_t *rp, double pct) {
+  size_t idx = (size_t)(pct / 100.0 * (double)(rp->nops - 1));
+  return rp->latency[idx];
+}
+
+static void usage(const char *prog) {
+  fprintf(stderr, "Usage: %s [--glibc] TRACE\n", prog);
+  exit(2);
+}
+
+int main(int argc, char **argv) {
+  static replay_t rp;
+  const char *path = NULL, *seed_str;
+  const trace_header_t *header;
+  const trace_record_t *recs;
+  struct stat st;
+  size_t nrecs, cap, i;
+  uint64_t total_ns = 0;
+  uint32_t seed;
+  long rss_base, vmas_base, vmas;
+  int fd;
+
+  for (int k = 1; k < argc; k++) {
+    if (strcmp(argv[k], "--glibc") == 0)
+      rp.use_glibc = 1;
+    else if (path == NULL)
+      path = argv[k];
+    else
+      usage(argv[0]);
+  }
+  if (path == NULL) usage(argv[0]);
+
+  fd = open(path, O_RDONLY);
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    perror(path);
+    return 1;
+  }
+  if ((size_t)st.st_size < sizeof(trace_header_t)) {
+    fprintf(stderr, "%s: not a trace\n", path);
+    return 1;
+  }
+  header = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (header == MAP_FAILED) {
+    perror("mmap");
+    return 1;
+  }
+  close(fd);
+  if (memcmp(header->magic, TRACE_MAGIC, sizeof(header->magic)) != 0 ||
+      header->version != TRACE_FORMAT_VERSION ||
+      header->record_size != sizeof(trace_record_t)) {
+    fprintf(stderr, "%s: unsupported trace\n", path);
+    return 1;
+  }
+  recs = (const trace_record_t *)header + 1;
+  nrecs = (size_t)st.st_size / sizeof(trace_record_t) - 1;
+
+  for (cap = 1024; cap < 2 * nrecs; cap *= 2);
+  rp.table = replay_map(cap * sizeof(replay_slot_t));
+  rp.table_mask = cap - 1;
+  rp.latency = replay_map((nrecs + 1) * sizeof(uint32_t));
+
+  seed_str = getenv("SEALLOC_SEED");
+  if (seed_str != NULL) {
+    seed = str2u32(seed_str);
+  } else if (platform_get_random(&seed) != PLATFORM_STATUS_OK) {
+    fprintf(stderr, "Failed to get random seed\n");
+    return 1;
+  }
+  if (!rp.use_glibc) arena_init_seeded(&rp.arena, seed);
+
+  rss_base = replay_max_rss_kb();
+  vmas_base = replay_count_vmas();
+  rp.vmas_max = vmas_base;
+  for (i = 0; i < nrecs && recs[i].op != TRACE_OP_NONE; i++) {
+    replay_record(&rp, &recs[i]);
+    if (i % REPLAY_VMA_INTERVAL == REPLAY_VMA_INTERVAL - 1) {
+      vmas = replay_count_vmas();
+      if (vmas > rp.vmas_max) rp.vmas_max = vmas;
+    }
+    // Replayed records should not count as resident memory
+    if (i % REPLAY_DROP_INTERVAL == REPLAY_DROP_INTERVAL - 1)
+      madvise((void *)header,
+              ((uintptr_t)&recs[i] & ~(uintptr_t)PAGE_MASK) -
+                  (uintptr_t)header,
+              MADV_DONTNEED);
+  }
+  vmas = replay_count_vmas();
+  if (vmas > rp.vmas_max) rp.vmas_max = vmas;
+
+  if (rp.nops == 0) {
+    printf("No events to replay\n");
+    return 0;
+  }
+  for (size_t k = 0; k < rp.nops; k++) total_ns += rp.latency[k];
+  qsort(rp.latency, rp.nops, sizeof(uint32_t), replay_cmp);
+
+  printf("allocator    %s\n", rp.use_glibc ? "glibc" : "sealloc");
+  if (!rp.use_glibc) printf("seed         %u\n", seed);
+  printf("events       %zu (%zu skipped)\n", rp.nops, rp.nskipped);
+  printf("throughput   %.0f ops/s\n",
+         total_ns == 0 ? 0.0 : (double)rp.nops * 1e9 / (double)total_ns);
+  printf("latency ns   p50 %u  p90 %u  p99 %u  p99.9 %u  max %u\n",
+         replay_percentile(&rp, 50), replay_percentile(&rp, 90),
+         replay_percentile(&rp, 99), replay_percentile(&rp, 99.9),
+         rp.latency[rp.nops - 1]);
+  printf("peak RSS     %ld KiB\n", replay_max_rss_kb() - rss_base);
+  printf("peak VMAs    %ld\n", rp.vmas_max - vmas_base);
+  return 0;
+}
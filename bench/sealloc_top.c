@@ -0,0 +1,203 @@
+/*
+ * Shows statistics published by process running with SEALLOC_LIVE_STATS.
+ *
+ * Segment of the process is mapped read-only, so the viewer never stops or
+ * slows the process down. Rates are computed from the two latest snapshots,
+ * over time which passed between them in the process, so they are exact even
+ * if the process publishes less often than the viewer refreshes. Process which
+ * makes no allocator calls publishes nothing, age of the snapshot shows that.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sealloc/live_stats.h"
+#include "sealloc/utils.h"
+
+// Attempts to read consistent snapshot before giving up
+#define TOP_READ_RETRIES 1000
+
+#define MIB (1024.0 * 1024.0)
+
+static uint64_t top_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void top_sleep(uint64_t ns) {
+  struct timespec ts = {.tv_sec = (time_t)(ns / 1000000000ULL),
+                        .tv_nsec = (long)(ns % 1000000000ULL)};
+  while (nanosleep(&ts, &ts) != 0 && errno == EINTR);
+}
+
+static const live_segment_t *top_attach(unsigned pid) {
+  char path[LIVE_PATH_MAX];
+  const live_segment_t *seg;
+  struct stat st;
+  int fd;
+  live_stats_path(pid, path);
+  fd = open(path, O_RDONLY);
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    perror(path);
+    return NULL;
+  }
+  if ((size_t)st.st_size < sizeof(live_segment_t)) {
+    fprintf(stderr, "%s: not a statistics segment\n", path);
+    close(fd);
+    return NULL;
+  }
+  seg = mmap(NULL, sizeof(live_segment_t), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (seg == MAP_FAILED) {
+    perror("mmap");
+    return NULL;
+  }
+  if (memcmp(seg->magic, LIVE_MAGIC, sizeof(seg->magic)) != 0 ||
+      __atomic_load_n(&seg->version, __ATOMIC_ACQUIRE) !=
+          LIVE_FORMAT_VERSION ||
+      seg->size != sizeof(live_segment_t)) {
+    fprintf(stderr, "%s: unsupported segment\n", path);
+    return NULL;
+  }
+  return seg;
+}
+
+// Copies snapshot, false if writer never left the write section
+static bool top_read(const live_segment_t *seg, live_segment_t *snap) {
+  uint64_t seq;
+  for (unsigned i = 0; i < TOP_READ_RETRIES; i++) {
+    seq = __atomic_load_n(&seg->seq, __ATOMIC_ACQUIRE);
+    if (seq % 2 == 0) {
+      memcpy(snap, seg, sizeof(*snap));
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+      if (__atomic_load_n(&seg->seq, __ATOMIC_RELAXED) == seq) return true;
+    }
+    top_sleep(1000000);
+  }
+  return false;
+}
+
+static double top_rate(size_t cur, size_t prev, double secs) {
+  return secs > 0 ? (double)(cur - prev) / secs : 0.0;
+}
+
+static void top_show(const live_segment_t *cur, const live_segment_t *prev,
+                     bool clear) {
+  const arena_stats_t *s = &cur->stats, *p = &prev->stats;
+  const bin_stats_t *bin;
+  double secs = (double)(cur->timestamp - prev->timestamp) / 1e9;
+  double age = (double)(top_now() - cur->timestamp) / 1e9;
+  size_t held;
+
+  // Cursor home and clear screen
+  if (clear) printf("\033[H\033[2J");
+  printf("pid %u  interval %u ms  snapshot %.1f s old\n\n", cur->pid,
+         cur->interval_ms, age);
+  printf("calls/s      alloc %.0f  free %.0f\n",
+         top_rate(cur->nallocs, prev->nallocs, secs),
+         top_rate(cur->nfrees, prev->nfrees, secs));
+  printf("syscalls/s   map %.1f  probe %.1f (retry %.1f)  unmap %.1f  "
+         "guard %.1f  unguard %.1f  expand %.1f\n",
+         top_rate(s->platform.nmap, p->platform.nmap, secs),
+         top_rate(s->platform.nprobe, p->platform.nprobe, secs),
+         top_rate(s->platform.nprobe_retry, p->platform.nprobe_retry, secs),
+         top_rate(s->platform.nunmap, p->platform.nunmap, secs),
+         top_rate(s->platform.nguard, p->platform.nguard, secs),
+         top_rate(s->platform.nunguard, p->platform.nunguard, secs),
+         top_rate(s->platform.nexpand, p->platform.nexpand, secs));
+  printf("live MiB     small %.2f  medium %.2f  large %.2f  huge %.2f\n",
+         s->small_bytes / MIB, s->medium_bytes / MIB, s->large_bytes / MIB,
+         s->huge_bytes / MIB);
+  printf("mapped MiB   total %.2f  chunks %.2f  depleted %.2f  cached %.2f  "
+         "metadata %.2f  guard %.2f\n",
+         s->mapped_bytes / MIB, s->chunk_mapped_bytes / MIB,
+         s->chunk_depleted_bytes / MIB, s->chunk_cached_bytes / MIB,
+         s->internal_mapped_bytes / MIB, s->guard_bytes / MIB);
+  printf("unmapped MiB %.2f  chunks %zu  huge %zu  VMAs <= %zu\n\n",
+         s->chunk_unmapped_bytes / MIB, s->nchunks, s->nhuge, s->nvmas);
+
+  // Freed regions are never reused, so they count against occupancy
+  printf("%8s %8s %6s %6s %10s %10s %10s %6s %10s %10s\n", "size", "run",
+         "active", "retir", "live", "avail", "freed", "occ%", "allocs/s",
+         "frees/s");
+  for (unsigned i = 0; i < ARENA_NO_BINS; i++) {
+    bin = &s->bins[i];
+    if (bin->nallocs == 0) continue;
+    held = bin->nregs_live + bin->nregs_avail + bin->nregs_freed;
+    printf("%8u %8u %6zu %6zu %10zu %10zu %10zu %6.1f %10.0f %10.0f\n",
+           bin->reg_size, bin->run_size, bin->nruns_active,
+           bin->nruns_inactive, bin->nregs_live, bin->nregs_avail,
+           bin->nregs_freed,
+           held == 0 ? 0.0 : 100.0 * (double)bin->nregs_live / (double)held,
+           top_rate(bin->nallocs, p->bins[i].nallocs, secs),
+           top_rate(bin->nfrees, p->bins[i].nfrees, secs));
+  }
+  fflush(stdout);
+}
+
+static void usage(const char *prog) {
+  fprintf(stderr, "Usage: %s [-i SECONDS] [-n ITERATIONS] PID\n", prog);
+  exit(2);
+}
+
+int main(int argc, char **argv) {
+  static live_segment_t cur, last, base;
+  const live_segment_t *seg;
+  double interval = 1.0;
+  long iterations = -1;
+  unsigned pid;
+  bool clear = isatty(STDOUT_FILENO);
+  int opt;
+
+  while ((opt = getopt(argc, argv, "i:n:")) != -1) {
+    switch (opt) {
+      case 'i':
+        interval = atof(optarg);
+        if (interval <= 0) usage(argv[0]);
+        break;
+      case 'n':
+        iterations = atol(optarg);
+        if (iterations <= 0) usage(argv[0]);
+        break;
+      default:
+        usage(argv[0]);
+    }
+  }
+  if (optind != argc - 1) usage(argv[0]);
+  pid = str2u32(argv[optind]);
+
+  seg = top_attach(pid);
+  if (seg == NULL) return 1;
+  if (!top_read(seg, &last)) {
+    fprintf(stderr, "Couldn't read consistent snapshot\n");
+    return 1;
+  }
+  base = last;
+  for (long i = 0; iterations < 0 || i < iterations; i++) {
+    top_sleep((uint64_t)(interval * 1e9));
+    // Segment outlives a killed process, so check it is still there
+    if (kill((pid_t)pid, 0) != 0 && errno == ESRCH) {
+      fprintf(stderr, "Process %u exited\n", pid);
+      return 0;
+    }
+    if (!top_read(seg, &cur)) {
+      fprintf(stderr, "Couldn't read consistent snapshot\n");
+      return 1;
+    }
+    if (cur.timestamp != last.timestamp) {
+      base = last;
+      last = cur;
+    }
+    top_show(&last, &base, clear);
+  }
+  return 0;
+}
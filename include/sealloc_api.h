@@ -3,10 +3,216 @@
 
 #include <sealloc/sealloc_export.h>
 #include <stddef.h>
+#include <stdio.h>
 
-SEALLOC_EXPORT void *malloc(size_t size);
-SEALLOC_EXPORT void free(void *ptr);
-SEALLOC_EXPORT void *calloc(size_t nmemb, size_t size);
-SEALLOC_EXPORT void *realloc(void *ptr, size_t size);
+// Declarations of libc functions have to match ones from libc headers in C++
+#ifdef __cplusplus
+#define SEALLOC_NOTHROW noexcept
+extern "C" {
+#else
+#define SEALLOC_NOTHROW
+#endif
+
+SEALLOC_EXPORT void *malloc(size_t size) SEALLOC_NOTHROW;
+SEALLOC_EXPORT void free(void *ptr) SEALLOC_NOTHROW;
+SEALLOC_EXPORT void *calloc(size_t nmemb, size_t size) SEALLOC_NOTHROW;
+SEALLOC_EXPORT void *realloc(void *ptr, size_t size) SEALLOC_NOTHROW;
+SEALLOC_EXPORT int posix_memalign(void **memptr, size_t alignment,
+                                  size_t size) SEALLOC_NOTHROW;
+SEALLOC_EXPORT void *aligned_alloc(size_t alignment,
+                                   size_t size) SEALLOC_NOTHROW;
+SEALLOC_EXPORT void *memalign(size_t alignment, size_t size) SEALLOC_NOTHROW;
+SEALLOC_EXPORT void *valloc(size_t size) SEALLOC_NOTHROW;
+SEALLOC_EXPORT void *pvalloc(size_t size) SEALLOC_NOTHROW;
+SEALLOC_EXPORT void free_sized(void *ptr, size_t size) SEALLOC_NOTHROW;
+SEALLOC_EXPORT void free_aligned_sized(void *ptr, size_t alignment,
+                                       size_t size) SEALLOC_NOTHROW;
+SEALLOC_EXPORT size_t malloc_usable_size(void *ptr) SEALLOC_NOTHROW;
+
+/*
+ * glibc introspection, struct mallinfo2 is defined in <malloc.h>. Numbers
+ * describe sealloc heap: arena is mapped chunk memory, uordblks live bytes in
+ * chunks, hblks and hblkhd huge mappings and keepcost memory malloc_trim()
+ * would release. malloc_trim() unmaps freed runs kept mapped, unused chunks
+ * and empty metadata units, pad is ignored. malloc_info() writes per-bin XML.
+ */
+SEALLOC_EXPORT struct mallinfo2 mallinfo2(void) SEALLOC_NOTHROW;
+SEALLOC_EXPORT int malloc_trim(size_t pad) SEALLOC_NOTHROW;
+SEALLOC_EXPORT int malloc_info(int options, FILE *fp) SEALLOC_NOTHROW;
+
+/*
+ * Returns size of region malloc(size) would return, without allocating.
+ * Returns 0 if size is too big to be ever allocated.
+ */
+SEALLOC_EXPORT size_t sealloc_nallocx(size_t size);
+
+/*
+ * Grows region to at least min_size bytes without moving it, taking up to
+ * max_size bytes if possible. Returns new usable size of the region, which is
+ * below min_size if region could not grow. Sized free of grown region takes
+ * size from its new size class.
+ */
+SEALLOC_EXPORT size_t sealloc_try_expand(void *ptr, size_t min_size,
+                                         size_t max_size);
+
+/*
+ * Reads or writes allocator setting addressed by dot separated name, like
+ * "arena.0.bins.12.min_regions". Current value is copied to oldp if it is not
+ * NULL, new value is taken from newp if it is not NULL, *oldlenp and newlen
+ * must equal the size of the value. Returns 0 on success or ENOENT, EINVAL,
+ * EPERM error number.
+ */
+SEALLOC_EXPORT int sealloc_ctl(const char *name, void *oldp, size_t *oldlenp,
+                               void *newp, size_t newlen);
+
+/*
+ * Heap statistics of the default arena. Bins are indexed by size class, like
+ * names of sealloc_ctl(), chunk runs by buddy order, runs of order k span
+ * 16 KiB << k. Counters of allocations, frees and released runs are kept
+ * from arena initialization, other values are current.
+ */
+#define SEALLOC_STATS_NBINS 43
+#define SEALLOC_STATS_NORDERS 12
+
+struct sealloc_bin_stats {
+  size_t reg_size;       /* Size of single region */
+  size_t run_size;       /* Size of run in bytes */
+  size_t nallocs;        /* Regions allocated */
+  size_t nfrees;         /* Regions freed */
+  size_t nruns_active;   /* Runs servicing allocations */
+  size_t nruns_inactive; /* Depleted runs waiting for frees */
+  size_t nruns_released; /* Runs given back to chunks */
+  size_t avail_regs;     /* Regions never allocated yet */
+  size_t live_regs;      /* Regions in use */
+  size_t lost_regs;      /* Freed regions of held runs, never reused */
+};
+
+struct sealloc_chunk_stats {
+  size_t nruns[SEALLOC_STATS_NORDERS]; /* Runs in use of each order */
+  size_t run_bytes;                    /* Memory of runs in use */
+  size_t depleted_bytes; /* Memory of freed runs still mapped */
+  size_t unmapped_bytes; /* Memory of freed runs returned to system */
+};
+
+struct sealloc_stats {
+  struct sealloc_bin_stats bins[SEALLOC_STATS_NBINS];
+  size_t nchunks;
+  struct sealloc_chunk_stats chunks; /* Sum over all chunks */
+  size_t chunk_cached_bytes; /* Mapped chunks not handed out yet */
+  size_t nhuge;              /* Huge mappings */
+  size_t huge_bytes;
+  size_t metadata_mapped_bytes;
+  size_t metadata_used_bytes;
+  size_t mapped_bytes; /* All memory mapped by the arena, guards included */
+  size_t guard_bytes;  /* PROT_NONE pages after chunks */
+  size_t nvmas; /* Upper bound of VMAs backing the arena, kernel may merge
+                   adjacent ones, compare with vm.max_map_count */
+  /* Process-wide calls of mapping functions, failed ones included */
+  size_t nmap_calls;     /* mmap() at any address */
+  size_t nprobe_calls;   /* mmap() at probed address */
+  size_t nprobe_retries; /* Probes which hit existing mapping */
+  size_t nunmap_calls;   /* munmap() */
+  size_t nguard_calls;   /* mprotect() to PROT_NONE */
+  size_t nunguard_calls; /* mprotect() back to read-write */
+  size_t nexpand_calls;  /* mremap() growing huge mapping */
+};
+
+/*
+ * Fills stats with current statistics. Collecting walks all chunks and runs,
+ * it is meant for tuning and monitoring, not for hot paths.
+ */
+SEALLOC_EXPORT void sealloc_stats_get(struct sealloc_stats *stats);
+
+/*
+ * Fills stats with usage of chunk idx, chunks are numbered from 0 to nchunks -
+ * 1 in arena order. Returns 0 on success or ENOENT if there is no such chunk.
+ */
+SEALLOC_EXPORT int sealloc_stats_get_chunk(size_t idx,
+                                           struct sealloc_chunk_stats *stats);
+
+/*
+ * Writes statistics as single JSON document with bins that were ever used,
+ * each chunk and totals. Returns 0 on success or EINVAL if fp is NULL.
+ */
+SEALLOC_EXPORT int sealloc_stats_write_json(FILE *fp);
+
+/*
+ * Writes binary layout of the heap to fd: buddy tree of each chunk, region
+ * states of each run and huge mappings, format is described in
+ * src/sealloc/heap_dump.h. Dumps may be appended to the same file to follow
+ * the heap over time. Does not allocate. Returns 0 on success, EINVAL if fd is
+ * negative or EIO if writing failed.
+ */
+SEALLOC_EXPORT int sealloc_dump_heap(int fd);
+
+/*
+ * Allocates n regions of the same size into out, returns number of regions
+ * allocated, which is less than n only when memory is exhausted.
+ */
+SEALLOC_EXPORT size_t sealloc_malloc_batch(size_t size, size_t n, void **out);
+
+/*
+ * Frees n pointers, NULL entries are skipped. Same as calling free() on each of
+ * them, but shares metadata lookups between pointers from the same run.
+ */
+SEALLOC_EXPORT void sealloc_free_batch(void **ptrs, size_t n);
+
+/*
+ * Arena handle, allocations made from it live until sealloc_arena_destroy()
+ * or sealloc_arena_free().
+ */
+typedef struct arena_state sealloc_arena_t;
+
+/*
+ * Creates new arena with its own chunks, huge mappings and metadata. Returns
+ * NULL if memory for the arena could not be mapped.
+ */
+SEALLOC_EXPORT sealloc_arena_t *sealloc_arena_create(void);
+SEALLOC_EXPORT void *sealloc_arena_malloc(sealloc_arena_t *a, size_t size);
+SEALLOC_EXPORT void sealloc_arena_free(sealloc_arena_t *a, void *ptr);
+
+/*
+ * Aligned allocation and sized free within the arena, same rules as
+ * aligned_alloc() and free_aligned_sized(). Returns NULL if alignment is not
+ * a power of 2.
+ */
+SEALLOC_EXPORT void *sealloc_arena_aligned_alloc(sealloc_arena_t *a,
+                                                 size_t alignment, size_t size);
+SEALLOC_EXPORT void sealloc_arena_free_aligned_sized(sealloc_arena_t *a,
+                                                     void *ptr,
+                                                     size_t alignment,
+                                                     size_t size);
+
+/*
+ * Releases all memory of the arena by unmapping whole mappings, regions are
+ * not freed one by one. Every pointer allocated from the arena becomes invalid.
+ */
+SEALLOC_EXPORT void sealloc_arena_destroy(sealloc_arena_t *a);
+
+/*
+ * Pool of objects of single size, objects are packed tighter than in size
+ * classes and do not share runs with malloc(). Pool objects must be freed
+ * with sealloc_pool_free() of their pool.
+ */
+typedef struct pool_state sealloc_pool_t;
+
+/*
+ * Creates pool of objects of obj_size bytes aligned to align, which is a power
+ * of 2 up to page size or 0 for 8 bytes. Returns NULL if obj_size is 0 or
+ * bigger than 8 KiB, or if align is invalid.
+ */
+SEALLOC_EXPORT sealloc_pool_t *sealloc_pool_create(size_t obj_size,
+                                                   size_t align);
+SEALLOC_EXPORT void *sealloc_pool_alloc(sealloc_pool_t *pool);
+SEALLOC_EXPORT void sealloc_pool_free(sealloc_pool_t *pool, void *ptr);
+
+/*
+ * Releases pool together with all its objects.
+ */
+SEALLOC_EXPORT void sealloc_pool_destroy(sealloc_pool_t *pool);
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif /* SEALLOC_API_H_ */
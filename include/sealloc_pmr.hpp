@@ -0,0 +1,110 @@
+#ifndef SEALLOC_PMR_HPP_
+#define SEALLOC_PMR_HPP_
+
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <sealloc_api.h>
+
+namespace sealloc {
+
+/*
+ * Arena shared by all owners, destroyed together with its allocations when
+ * the last owner goes away.
+ */
+using arena_ptr = std::shared_ptr<sealloc_arena_t>;
+
+inline arena_ptr make_arena() {
+  sealloc_arena_t *a = sealloc_arena_create();
+  if (a == nullptr) throw std::bad_alloc();
+  return arena_ptr(a, sealloc_arena_destroy);
+}
+
+/*
+ * Memory resource with its own arena. Deallocation passes size and alignment
+ * down, so only runs of the size class are searched. Memory which was not
+ * deallocated is released at once when the resource is destroyed.
+ */
+class memory_resource : public std::pmr::memory_resource {
+ public:
+  memory_resource() : arena_(make_arena()) {}
+  explicit memory_resource(arena_ptr arena) : arena_(std::move(arena)) {}
+  memory_resource(const memory_resource &) = delete;
+  memory_resource &operator=(const memory_resource &) = delete;
+
+  const arena_ptr &arena() const noexcept { return arena_; }
+
+ private:
+  void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+    void *ptr = sealloc_arena_aligned_alloc(arena_.get(), alignment, bytes);
+    if (ptr == nullptr) throw std::bad_alloc();
+    return ptr;
+  }
+
+  void do_deallocate(void *ptr, std::size_t bytes,
+                     std::size_t alignment) override {
+    sealloc_arena_free_aligned_sized(arena_.get(), ptr, alignment, bytes);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource &other)
+      const noexcept override {
+    auto *o = dynamic_cast<const memory_resource *>(&other);
+    return o != nullptr && o->arena_ == arena_;
+  }
+
+  arena_ptr arena_;
+};
+
+/*
+ * Allocator with its own arena, copies and rebinds share the arena. Two
+ * allocators are equal if they allocate from the same arena.
+ */
+template <class T>
+class allocator {
+ public:
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  allocator() : arena_(make_arena()) {}
+  explicit allocator(arena_ptr arena) noexcept : arena_(std::move(arena)) {}
+  explicit allocator(const memory_resource &mr) noexcept
+      : arena_(mr.arena()) {}
+  template <class U>
+  allocator(const allocator<U> &other) noexcept : arena_(other.arena()) {}
+
+  T *allocate(std::size_t n) {
+    if (n > std::numeric_limits<std::size_t>::max() / sizeof(T))
+      throw std::bad_array_new_length();
+    void *ptr =
+        sealloc_arena_aligned_alloc(arena_.get(), alignof(T), n * sizeof(T));
+    if (ptr == nullptr) throw std::bad_alloc();
+    return static_cast<T *>(ptr);
+  }
+
+  void deallocate(T *ptr, std::size_t n) noexcept {
+    sealloc_arena_free_aligned_sized(arena_.get(), ptr, alignof(T),
+                                     n * sizeof(T));
+  }
+
+  const arena_ptr &arena() const noexcept { return arena_; }
+
+  template <class U>
+  bool operator==(const allocator<U> &other) const noexcept {
+    return arena_ == other.arena();
+  }
+  template <class U>
+  bool operator!=(const allocator<U> &other) const noexcept {
+    return arena_ != other.arena();
+  }
+
+ private:
+  arena_ptr arena_;
+};
+
+}  // namespace sealloc
+
+#endif /* SEALLOC_PMR_HPP_ */
@@ -0,0 +1,65 @@
+#!/usr/bin/env python
+
+import json
+import sys
+from pathlib import Path
+
+PERCENTILES = [50, 90, 99, 99.9, 99.99]
+
+
+def parse(file):
+    # Each line is one dump, the last one holds the most recent counters
+    dumps = [json.loads(line) for line in file.read_text().splitlines() if line]
+    for dump in dumps:
+        if dump["version"] != 1:
+            raise ValueError(f"Unsupported version {dump['version']}")
+    return dumps
+
+
+def percentile(buckets, count, pct):
+    # Lower bound of the bucket holding given rank
+    rank = pct / 100 * count
+    seen = 0
+    for lower, cnt in buckets:
+        seen += cnt
+        if seen >= rank:
+            return lower
+    return buckets[-1][0]
+
+
+def report(dump):
+    ticks_per_ns = dump["ticks_per_sec"] / 1e9 if dump["ticks_per_sec"] else 0
+    unit = "ns" if ticks_per_ns else "ticks"
+    header = ["phase", "count"] + [f"p{p}" for p in PERCENTILES] + ["max"]
+    print(f"\npid {dump['pid']}, values in {unit}")
+    print("".join(f"{col:>22}" if i == 0 else f"{col:>12}"
+                  for i, col in enumerate(header)))
+    for name, phase in dump["phases"].items():
+        buckets, count = phase["buckets"], phase["count"]
+        if count == 0:
+            continue
+        values = [percentile(buckets, count, p) for p in PERCENTILES]
+        values.append(buckets[-1][0])
+        if ticks_per_ns:
+            values = [v / ticks_per_ns for v in values]
+        print(f"{name:>22}{count:>12}" + "".join(f"{v:>12.0f}" for v in values))
+
+
+def main():
+    if len(sys.argv) not in (2, 3):
+        print(f"Usage: {sys.argv[0]} LATENCY_FILE [PID]")
+        sys.exit(2)
+    dumps = parse(Path(sys.argv[1]))
+    if len(sys.argv) == 3:
+        dumps = [dump for dump in dumps if dump["pid"] == int(sys.argv[2])]
+    # Children of the process dump into the same file, keep last dump of each
+    last = {dump["pid"]: dump for dump in dumps}
+    if not last:
+        print("No dumps found")
+        sys.exit(1)
+    for dump in last.values():
+        report(dump)
+
+
+if __name__ == "__main__":
+    main()
@@ -1,27 +1,29 @@
 #!/usr/bin/env python
 
+import json
 import sys
-from collections import Counter
 from pathlib import Path
 
-import matplotlib.patches as mpatches
 import matplotlib.pyplot as plt
-import numpy as np
 
-COLOR_MAP = {"S": "r", "M": "g", "L": "b", "H": "k"}
-CLASS_MAP = {"r": "S", "g": "M", "b": "L", "k": "H"}
+CLASSES = ["small", "medium", "large", "huge"]
+COLORS = ["r", "g", "b", "k"]
+LABELS = ["Small", "Medium", "Large", "Huge"]
 
-HANDLES = [
-    mpatches.Patch(color="red", label="Small"),
-    mpatches.Patch(color="green", label="Medium"),
-    mpatches.Patch(color="blue", label="Large"),
-    mpatches.Patch(color="black", label="Huge"),
-]
 
+def parse(file):
+    # Each line is one dump, the last one holds the most recent counters
+    dumps = [json.loads(line) for line in file.read_text().splitlines() if line]
+    for dump in dumps:
+        if dump["version"] != 1:
+            raise ValueError(f"Unsupported version {dump['version']}")
+    return dumps
 
-def parse(line):
-    s = line.split()
-    return COLOR_MAP[s[0]], int(s[1])
+
+def bucket_label(idx):
+    if idx == 0:
+        return "0"
+    return f"2^{idx - 1}"
 
 
 def main():
@@ -29,33 +31,48 @@ def main():
     if data_path.is_file():
         files = [data_path]
     elif data_path.is_dir():
-        files = list(data_path.glob("alloc_stats.*"))
+        files = list(data_path.glob("heap_stats.sealloc*"))
     else:
         files = []
     print("Detected files:\n" + "\n".join(map(str, files)))
     for file in files:
         print(f"Processing {file.name}...")
         print("Reading data...")
-        allocs = list(map(parse, file.read_text().splitlines()))
-        colors = list(map(lambda x: x[0], allocs))
-        sizes = list(map(lambda x: x[1], allocs))
-        x_axis = list(range(1, len(sizes) + 1))
-        size_mb = file.stat().st_size / 2**20
+        dumps = parse(file)
+        if not dumps:
+            print("No dumps found, skipping")
+            continue
+        dump = dumps[-1]
+        buckets = dump["log2_buckets"]
+        # Trim empty tail of histogram
+        last = max((i for i, cnt in enumerate(buckets) if cnt > 0), default=0)
+        buckets = buckets[: last + 1]
+        counts = [dump["classes"][c]["count"] for c in CLASSES]
         print(
-            f"Read total of {len(allocs)} samples ({size_mb:.2f} MB). "
-            "Creating the plot..."
+            f"Read {len(dumps)} dumps of pid {dump['pid']}, "
+            f"{sum(counts)} allocations. Creating the plot..."
+        )
+        fig, (hist_axs, class_axs) = plt.subplots(1, 2, figsize=(12, 5))
+
+        # Log2 histogram of requested sizes
+        hist_axs.bar(range(len(buckets)), buckets)
+        hist_axs.set_yscale("log")
+        hist_axs.set_xticks(range(len(buckets)))
+        hist_axs.set_xticklabels(
+            [bucket_label(i) for i in range(len(buckets))], rotation=90
         )
-        fig, axs = plt.subplots()
+        hist_axs.set_xlabel("Rozmiar")
+        hist_axs.set_ylabel("Liczba alokacji")
+
+        # Allocations per size class
+        class_axs.bar(LABELS, counts, color=COLORS)
+        class_axs.set_yscale("log")
+        class_axs.set_xlabel("Klasa alokacji")
+        class_axs.set_ylabel("Liczba alokacji")
 
-        # Set scatter chart
-        plt.yscale("log")
-        scatter = axs.scatter(x=x_axis, y=sizes, c=colors, s=0.1)
-        legend = axs.legend(handles=HANDLES, loc="upper left", title="Klasa alokacji")
-        axs.add_artist(legend)
-        axs.set_xlabel("Czas (w alokacjach)")
-        axs.set_ylabel("Rozmiar")
-        out_file = file.name.split(".")[1]
+        out_file = file.name.replace(".", "_")
         print("Saving...")
+        fig.tight_layout()
         fig.savefig(out_file)
         print(f"Saved to {out_file}.png")
         plt.close()
@@ -0,0 +1,246 @@
+#!/usr/bin/env python
+
+import struct
+import sys
+from datetime import datetime
+from pathlib import Path
+
+import matplotlib.pyplot as plt
+import numpy as np
+from matplotlib.colors import ListedColormap
+
+# Layout of src/sealloc/heap_dump.h
+HEADER = struct.Struct("=8sIIQIIIIII")
+RECORD = struct.Struct("=II")
+RUN = struct.Struct("=QIIII")
+HUGE = struct.Struct("=QQ")
+END, CHUNK, RUN_REC, HUGE_REC = range(4)
+
+NODE_FREE, NODE_USED, NODE_DEPLETED, NODE_UNMAPPED = range(4)
+STATE_ALLOC = 1
+REG_MARK_BAD_VALUE = 0xFFFF
+REG_MARK_LARGE = 0x8000
+REG_MARK_LARGE_ORDER_MASK = 0x00FF
+REG_MARK_POOL = 0x4000
+
+# Leaf categories of occupancy map
+LEAF_FREE, LEAF_RUN, LEAF_LARGE, LEAF_POOL, LEAF_DEPLETED, LEAF_UNMAPPED = range(6)
+LEAF_COLORS = ["white", "tab:green", "tab:blue", "tab:purple", "tab:orange", "lightgray"]
+LEAF_LABELS = [
+    "Wolne",
+    "Run small/medium",
+    "Region large",
+    "Run puli",
+    "Zwolnione, zmapowane",
+    "Odmapowane",
+]
+
+
+def parse(data):
+    dumps = []
+    off = 0
+    while off < len(data):
+        magic, version, pid, timestamp, page_size, chunk_size, leaf_size, depth, chunks_left, _ = (
+            HEADER.unpack_from(data, off)
+        )
+        if magic.rstrip(b"\0") != b"SEAHEAP" or version != 1:
+            raise ValueError(f"Unsupported dump at offset {off}")
+        off += HEADER.size
+        dump = {
+            "pid": pid,
+            "time": timestamp / 1e9,
+            "chunk_size": chunk_size,
+            "leaf_size": leaf_size,
+            "depth": depth,
+            "chunks_left": chunks_left,
+            "chunks": [],
+            "runs": [],
+            "huge": [],
+        }
+        nleaves = chunk_size // leaf_size
+        tree_bytes = ((2 * nleaves - 1) * 2 + 7) // 8
+        while True:
+            rtype, rlen = RECORD.unpack_from(data, off)
+            off += RECORD.size
+            payload = data[off : off + rlen]
+            off += rlen
+            if rtype == END:
+                break
+            if rtype == CHUNK:
+                (addr,) = struct.unpack_from("=Q", payload)
+                tree = payload[8 : 8 + tree_bytes]
+                marks = struct.unpack_from(f"={nleaves}H", payload, 8 + tree_bytes)
+                dump["chunks"].append((addr, tree, marks))
+            elif rtype == RUN_REC:
+                addr, reg_size, nregs, run_size, retired = RUN.unpack_from(payload)
+                states = payload[RUN.size :]
+                live = sum(
+                    (states[i // 4] >> (2 * (i % 4))) & 3 == STATE_ALLOC
+                    for i in range(nregs)
+                )
+                dump["runs"].append((addr, reg_size, nregs, run_size, retired, live))
+            elif rtype == HUGE_REC:
+                dump["huge"].append(HUGE.unpack_from(payload))
+        dumps.append(dump)
+    return dumps
+
+
+def node_state(tree, idx):
+    return (tree[(idx - 1) // 4] >> (2 * ((idx - 1) % 4))) & 3
+
+
+def classify_leaves(dump, tree, marks):
+    # Walks buddy tree like chunk_get_usage(), subtrees of used, depleted and
+    # unmapped nodes are not split further
+    depth = dump["depth"]
+    first_leaf = 1 << depth
+    leaves = np.full(first_leaf, LEAF_FREE, dtype=np.uint8)
+    stack = [(1, depth)]
+    while stack:
+        idx, to_leaf = stack.pop()
+        state = node_state(tree, idx)
+        first = (idx << to_leaf) - first_leaf
+        span = slice(first, first + (1 << to_leaf))
+        if state == NODE_FREE:
+            if to_leaf > 0:
+                stack += [(2 * idx, to_leaf - 1), (2 * idx + 1, to_leaf - 1)]
+        elif state == NODE_DEPLETED:
+            leaves[span] = LEAF_DEPLETED
+        elif state == NODE_UNMAPPED:
+            leaves[span] = LEAF_UNMAPPED
+        else:
+            mark = marks[first]
+            if mark != REG_MARK_BAD_VALUE and mark & REG_MARK_LARGE:
+                leaves[span] = LEAF_LARGE
+            elif mark != REG_MARK_BAD_VALUE and mark & REG_MARK_POOL:
+                leaves[span] = LEAF_POOL
+            else:
+                leaves[span] = LEAF_RUN
+    return leaves
+
+
+def summarize(dump):
+    leaf_size = dump["leaf_size"]
+    maps = [classify_leaves(dump, tree, marks) for _, tree, marks in dump["chunks"]]
+    unmapped = sum(int((m == LEAF_UNMAPPED).sum()) for m in maps) * leaf_size
+    depleted = sum(int((m == LEAF_DEPLETED).sum()) for m in maps) * leaf_size
+    mapped = len(maps) * dump["chunk_size"] - unmapped
+    live = sum(live * reg_size for _, reg_size, _, _, _, live in dump["runs"])
+    for _, _, marks in dump["chunks"]:
+        for mark in marks:
+            if mark != REG_MARK_BAD_VALUE and mark & REG_MARK_LARGE:
+                live += leaf_size << (mark & REG_MARK_LARGE_ORDER_MASK)
+    huge = sum(length for _, length in dump["huge"])
+    # Mapped ranges of chunks, each one is a separate VMA
+    segments = sum(
+        int(np.count_nonzero(np.diff((m != LEAF_UNMAPPED).astype(np.int8)) == 1))
+        + int(m[0] != LEAF_UNMAPPED)
+        for m in maps
+    )
+    return {
+        "maps": maps,
+        "mapped": mapped,
+        "depleted": depleted,
+        "unmapped": unmapped,
+        "live": live,
+        "huge": huge,
+        "vmas": segments + len(dump["huge"]),
+    }
+
+
+def plot_layout(dump, summary, out_file):
+    maps = summary["maps"]
+    runs = dump["runs"]
+    fig, (map_axs, run_axs) = plt.subplots(
+        1, 2, figsize=(14, 2 + 0.4 * max(len(maps), 1)), width_ratios=[3, 1]
+    )
+    if maps:
+        map_axs.imshow(
+            np.vstack(maps),
+            aspect="auto",
+            interpolation="nearest",
+            cmap=ListedColormap(LEAF_COLORS),
+            vmin=0,
+            vmax=len(LEAF_COLORS) - 1,
+        )
+    map_axs.set_xlabel(f"Liść drzewa ({dump['leaf_size'] // 1024} KiB)")
+    map_axs.set_ylabel("Chunk")
+    map_axs.set_title(f"Zajętość chunków, pid {dump['pid']}")
+    map_axs.legend(
+        handles=[
+            plt.Rectangle((0, 0), 1, 1, facecolor=c, edgecolor="k")
+            for c in LEAF_COLORS
+        ],
+        labels=LEAF_LABELS,
+        loc="upper center",
+        bbox_to_anchor=(0.5, -0.15),
+        ncol=3,
+    )
+
+    # Runs with few live regions keep whole run mapped
+    fill = [live / nregs for _, _, nregs, _, _, live in runs if nregs > 0]
+    run_axs.hist(fill, bins=20, range=(0, 1))
+    run_axs.set_xlabel("Odsetek żywych regionów w runie")
+    run_axs.set_ylabel("Liczba runów")
+
+    fig.tight_layout()
+    fig.savefig(out_file)
+    plt.close()
+
+
+def plot_timeline(dumps, summaries, out_file):
+    start = dumps[0]["time"]
+    times = [d["time"] - start for d in dumps]
+    mib = 1024 * 1024
+    fig, (mem_axs, frag_axs) = plt.subplots(1, 2, figsize=(12, 5))
+    for key, label in [
+        ("mapped", "Zmapowane w chunkach"),
+        ("live", "Żywe regiony"),
+        ("depleted", "Zwolnione, zmapowane"),
+        ("huge", "Duże mapowania"),
+    ]:
+        mem_axs.plot(times, [s[key] / mib for s in summaries], marker=".", label=label)
+    mem_axs.set_xlabel("Czas (s)")
+    mem_axs.set_ylabel("Pamięć (MiB)")
+    mem_axs.legend()
+
+    frag = [1 - s["live"] / s["mapped"] if s["mapped"] else 0 for s in summaries]
+    frag_axs.plot(times, frag, marker=".", color="r")
+    frag_axs.set_xlabel("Czas (s)")
+    frag_axs.set_ylabel("Fragmentacja (1 - żywe / zmapowane)", color="r")
+    frag_axs.set_ylim(0, 1)
+    vma_axs = frag_axs.twinx()
+    vma_axs.plot(times, [s["vmas"] for s in summaries], marker=".", color="k")
+    vma_axs.set_ylabel("Liczba VMA")
+
+    fig.tight_layout()
+    fig.savefig(out_file)
+    plt.close()
+
+
+def main():
+    if len(sys.argv) != 2:
+        print(f"Usage: {sys.argv[0]} HEAP_DUMP_FILE")
+        sys.exit(2)
+    file = Path(sys.argv[1])
+    print("Reading data...")
+    dumps = parse(file.read_bytes())
+    if not dumps:
+        print("No dumps found")
+        sys.exit(1)
+    summaries = [summarize(dump) for dump in dumps]
+    last = dumps[-1]
+    print(
+        f"Read {len(dumps)} dumps of pid {last['pid']}, last one taken at "
+        f"{datetime.fromtimestamp(last['time'])}. Creating plots..."
+    )
+    out_base = file.name.replace(".", "_")
+    plot_layout(last, summaries[-1], out_base + "_layout")
+    print(f"Saved to {out_base}_layout.png")
+    if len(dumps) > 1:
+        plot_timeline(dumps, summaries, out_base + "_timeline")
+        print(f"Saved to {out_base}_timeline.png")
+
+
+if __name__ == "__main__":
+    main()
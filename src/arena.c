@@ -7,8 +7,10 @@
 #include "sealloc/chunk.h"
 #include "sealloc/container_ll.h"
 #include "sealloc/internal_allocator.h"
+#include "sealloc/latency.h"
 #include "sealloc/logging.h"
 #include "sealloc/platform_api.h"
+#include "sealloc/probes.h"
 #include "sealloc/random.h"
 #include "sealloc/run.h"
 #include "sealloc/size_class.h"
@@ -58,19 +60,26 @@ typedef void (*reset_fun)(arena_t *);
  * @param[in]     size Requested size of mapping
  * @param[in]     ceil Pointer to ceiling pointer which the upper bound for the
  * probe.
+ * @param[in]     alignment Alignment of the mapping, power of 2 and at least
+ * PAGE_SIZE.
  * @returns Returns address of the mapping.
  * @sideeffect May call reset(arena) which will update the probe.
  * @warning Returned address of the mapping may be different from probe because
  * reset function might've been called.
  */
-static uintptr_t arena_morecore(arena_t *arena, volatile uintptr_t *probe_ptr,
-                                reset_fun reset, size_t size,
-                                volatile uintptr_t *ceil) {
+static uintptr_t arena_morecore_aligned(arena_t *arena,
+                                        volatile uintptr_t *probe_ptr,
+                                        reset_fun reset, size_t size,
+                                        volatile uintptr_t *ceil,
+                                        size_t alignment) {
   platform_status_code_t code;
   uintptr_t result;
+  se_lat_start(start);
   se_debug("Mapping more memory at %p", *probe_ptr);
-  code = platform_map_probe(probe_ptr, *ceil, size);
+  code = platform_map_probe_aligned(probe_ptr, *ceil, size, alignment);
+  result = *probe_ptr;
   while (code != PLATFORM_STATUS_OK) {
+    se_probe3(morecore_retry, *probe_ptr, size, code);
     if (code == PLATFORM_STATUS_CEILING_HIT) {
       se_debug("Ceilling hit with %p, resetting", *probe_ptr);
       reset(arena);
@@ -78,40 +87,62 @@ static uintptr_t arena_morecore(arena_t *arena, volatile uintptr_t *probe_ptr,
       se_debug("Different address mapped %p", *probe_ptr);
       result = *probe_ptr;
       reset(arena);
-      return result;
+      if (IS_ALIGNED(result, alignment)) break;
+      // Kernel placed mapping elsewhere and broke alignment, try again
+      if ((code = platform_unmap((void *)result, size)) !=
+          PLATFORM_STATUS_OK) {
+        se_error("Failed to unmap misaligned mapping (ptr : %p, size : %zu): %s",
+                 (void *)result, size, platform_strerror(code));
+      }
     }
     se_debug("Mapping more memory at %p", *probe_ptr);
-    code = platform_map_probe(probe_ptr, *ceil, size);
+    code = platform_map_probe_aligned(probe_ptr, *ceil, size, alignment);
+    result = *probe_ptr;
   }
-  return *probe_ptr;
+  se_lat_end(arena, LAT_MORECORE, start);
+  return result;
+}
+
+// Same as arena_morecore_aligned() with page alignment
+static uintptr_t arena_morecore(arena_t *arena, volatile uintptr_t *probe_ptr,
+                                reset_fun reset, size_t size,
+                                volatile uintptr_t *ceil) {
+  return arena_morecore_aligned(arena, probe_ptr, reset, size, ceil,
+                                PAGE_SIZE);
 }
 
 void arena_init(arena_t *arena) {
-  assert(arena->is_initialized == 0);
   platform_status_code_t code;
-  void *ptr;
-#ifdef STATISTICS
-#include <fcntl.h>
-  int perms = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
-  int fd = open("./heap_stats.sealloc", O_WRONLY | O_APPEND | O_CREAT, perms);
-  if (fd < 0) {
-    se_log("Couldn't open file to write heap statistics to\n");
-    arena->stats_fd = -1;
-  } else {
-    se_log("Opened heap_stats.sealloc file for statistics\n");
-    arena->stats_fd = fd;
-  }
-#endif
+  uint32_t secret;
 #ifdef DEBUG
   char *user_rand = getenv("SEALLOC_SEED");
   if (user_rand != NULL) {
-    arena->secret = str2u32(user_rand);
-    se_log("Using user passed secret: %u\n", arena->secret);
+    secret = str2u32(user_rand);
+    se_log("Using user passed secret: %u\n", secret);
   } else
 #endif
-      if ((code = platform_get_random(&arena->secret)) != PLATFORM_STATUS_OK) {
+      if ((code = platform_get_random(&secret)) != PLATFORM_STATUS_OK) {
     se_error("Failed to get random value: %s", platform_strerror(code));
   }
+  arena_init_seeded(arena, secret);
+}
+
+void arena_init_seeded(arena_t *arena, uint32_t secret) {
+  assert(arena->is_initialized == 0);
+  platform_status_code_t code;
+  void *ptr;
+  const char *conf_str, *prof_path;
+#ifdef STATISTICS
+  hist_init(&arena->hist);
+  arena->hist_path = getenv(HIST_ENV_PATH);
+  if (arena->hist_path == NULL) arena->hist_path = HIST_DEFAULT_PATH;
+#endif
+#ifdef LATENCY
+  lat_init(&arena->latency);
+  arena->latency_path = getenv(LAT_ENV_PATH);
+  if (arena->latency_path == NULL) arena->latency_path = LAT_DEFAULT_PATH;
+#endif
+  arena->secret = secret;
 #ifdef DEBUG
   se_log("Using secret %u\n", arena->secret);
 #endif
@@ -135,6 +166,14 @@ void arena_init(arena_t *arena) {
   arena->chunk_ptr = 0;
   arena->chunks_left = 0;
   memset(arena->bins, 0, sizeof(bin_t) * ARENA_NO_BINS);
+  conf_init(&arena->conf);
+  conf_str = getenv(CONF_ENV_NAME);
+  if (conf_str != NULL) conf_parse(&arena->conf, conf_str);
+  prof_init(&arena->prof, arena->conf.prof_interval, splitmix64());
+  prof_path = getenv(PROF_ENV_PATH);
+  if (prof_path != NULL) arena->prof.path = prof_path;
+  trace_init(&arena->trace);
+  arena->live = NULL;
 }
 
 void *arena_internal_alloc(arena_t *arena, size_t size) {
@@ -167,7 +206,8 @@ void *arena_internal_alloc(arena_t *arena, size_t size) {
   return internal_alloc(map, size);
 }
 
-void arena_internal_free(arena_t *arena, void *ptr) {
+// Finds allocation unit holding metadata at ptr, fails if there is none
+static int_alloc_t *arena_internal_unit(arena_t *arena, void *ptr) {
   uintptr_t ptr_dest = (uintptr_t)ptr;
   int_alloc_t *root = NULL;
 
@@ -184,51 +224,93 @@ void arena_internal_free(arena_t *arena, void *ptr) {
   if (!root) {
     se_error("root == NULL");
   }
+  return root;
+}
 
-  internal_free(root, ptr);
+void arena_internal_free(arena_t *arena, void *ptr) {
+  internal_free(arena_internal_unit(arena, ptr), ptr);
 }
 
-run_t *arena_allocate_run(arena_t *arena, bin_t *bin) {
-  assert(arena->is_initialized == 1);
-  assert(bin->reg_size != 0);
+void arena_internal_shrink(arena_t *arena, void *ptr, size_t size) {
+  internal_shrink(arena_internal_unit(arena, ptr), ptr, size);
+}
 
+// Allocates run memory for bin from any chunk, maps a new chunk if needed
+static void *arena_allocate_run_memory(arena_t *arena, bin_t *bin,
+                                       chunk_t **chunk_ret) {
   chunk_t *chunk;
-  run_t *run;
-  void *run_ptr;
-  for (ll_entry_t *entry = arena->chunk_list.ll; entry != NULL;
-       entry = entry->link.fd) {
+  void *run_ptr = NULL;
+  // Pool runs are marked, so that arena lookups never mistake them for its own
+  const unsigned reg_mark =
+      bin->is_pool ? (REG_MARK_POOL | bin->reg_size) : bin->reg_size;
+  for (ll_entry_t *entry = arena->chunk_list.ll;
+       entry != NULL && run_ptr == NULL; entry = entry->link.fd) {
     chunk = CONTAINER_OF(entry, chunk_t, entry);
     run_ptr = chunk_allocate_run(chunk, bin->run_size_pages * PAGE_SIZE,
-                                 bin->reg_size);
-    if (run_ptr != NULL) {
-      // We just allocated a run
-      run = arena_internal_alloc(
-          arena, sizeof(run_t) + BITS2BYTES_CEIL(bin->reg_mask_size_bits));
-      run_init(run, bin, run_ptr);
-      return run;
-    }
+                                 reg_mark);
+  }
+  if (run_ptr == NULL) {
+    // No luck finding, allocate a new one
+    // Will also be addded to chunk list
+    chunk = arena_allocate_chunk(arena);
+    run_ptr =
+        chunk_allocate_run(chunk, bin->run_size_pages * PAGE_SIZE, reg_mark);
+    assert(run_ptr != NULL && "Failed to allocate run from fresh chunk");
   }
-  // No luck finding, allocate a new one
-  // Will also be addded to chunk list
-  chunk = arena_allocate_chunk(arena);
-  run_ptr =
-      chunk_allocate_run(chunk, bin->run_size_pages * PAGE_SIZE, bin->reg_size);
-  assert(run_ptr != NULL && "Failed to allocate run from fresh chunk");
-
-  run = arena_internal_alloc(
-      arena, sizeof(run_t) + BITS2BYTES_CEIL(bin->reg_mask_size_bits));
+  // Run of large class is the region itself
+  se_probe3(run_create, run_ptr, bin->reg_size,
+            bin->run_size_pages * PAGE_SIZE);
+  *chunk_ret = chunk;
+  return run_ptr;
+}
+
+run_t *arena_allocate_run(arena_t *arena, bin_t *bin) {
+  assert(arena->is_initialized == 1);
+  assert(bin->reg_size != 0);
+
+  chunk_t *chunk;
+  void *run_ptr = arena_allocate_run_memory(arena, bin, &chunk);
+  run_t *run = arena_internal_alloc(arena, run_metadata_size(bin));
   run_init(run, bin, run_ptr);
+  chunk_set_run(chunk, run_ptr, run);
   return run;
 }
 
+void *arena_allocate_large(arena_t *arena, bin_t *bin) {
+  assert(arena->is_initialized == 1);
+  assert(IS_SIZE_LARGE(bin->reg_size));
+  chunk_t *chunk;
+  void *ptr = arena_allocate_run_memory(arena, bin, &chunk);
+  if (ptr != NULL) bin->nallocs++;
+  return ptr;
+}
+
+run_t *arena_retire_run(arena_t *arena, bin_t *bin, run_t *run) {
+  assert(arena->is_initialized == 1);
+  // Descriptor keeps its address, so it stays close to the other ones
+  bin_retire_run(bin, run);
+  run_compact(run, bin);
+  arena_internal_shrink(arena, run, run_compact_metadata_size(bin));
+  return run;
+}
+
+// Chunks keep their own copy of lookup parameters, hot paths do not reach arena
+static void arena_conf_chunk(const arena_t *arena, chunk_t *chunk) {
+  chunk->random_lookup_tries = (uint8_t)arena->conf.random_lookup_tries;
+  chunk->random_lookup_threshold = (uint8_t)arena->conf.random_lookup_threshold;
+  chunk->unmap_threshold = (uint8_t)arena->conf.chunk_unmap_threshold;
+}
+
 chunk_t *arena_allocate_chunk(arena_t *arena) {
   assert(arena->is_initialized == 1);
 
   chunk_t *chunk_meta = arena_internal_alloc(arena, sizeof(chunk_t));
   platform_status_code_t code;
-  size_t map_len = CHUNKS_PER_MAPPING * (CHUNK_SIZE_BYTES + PAGE_SIZE);
+  size_t map_len =
+      (size_t)arena->conf.chunks_per_mapping * (CHUNK_SIZE_BYTES + PAGE_SIZE);
+  const bool mapped = arena->chunks_left == 0;
   // get more memory if needed
-  if (arena->chunks_left == 0) {
+  if (mapped) {
     arena->chunk_ptr =
         arena_morecore(arena, &arena->chunk_alloc_ptr, reset_chunk_ptr_start,
                        map_len, &arena->brk);
@@ -236,7 +318,7 @@ chunk_t *arena_allocate_chunk(arena_t *arena) {
     // mapping
     if (arena->chunk_ptr == arena->chunk_alloc_ptr)
       arena->chunk_alloc_ptr += map_len;
-    arena->chunks_left = CHUNKS_PER_MAPPING;
+    arena->chunks_left = arena->conf.chunks_per_mapping;
   }
 
   // Guard one page after the end of chunk
@@ -246,10 +328,14 @@ chunk_t *arena_allocate_chunk(arena_t *arena) {
     se_error("Failed to allocate mapping (size : %u): %s", PAGE_SIZE,
              platform_strerror(code));
   }
+  se_lat_start(start);
   chunk_init(chunk_meta, (void *)arena->chunk_ptr);
+  se_lat_end(arena, LAT_CHUNK_INIT, start);
+  arena_conf_chunk(arena, chunk_meta);
   ll_add(&arena->chunk_list, &chunk_meta->entry);
   arena->chunk_ptr += (CHUNK_SIZE_BYTES + PAGE_SIZE);
   arena->chunks_left--;
+  se_probe2(chunk_create, chunk_meta->entry.key, mapped);
   return chunk_meta;
 }
 
@@ -257,6 +343,7 @@ void arena_deallocate_chunk(arena_t *arena, chunk_t *chunk) {
   assert(arena->is_initialized == 1);
   assert(chunk_is_unmapped(chunk));
   se_debug("Deallocating chunk");
+  se_probe1(chunk_destroy, chunk->entry.key);
   platform_status_code_t code;
 
   // Unmap guard page
@@ -273,6 +360,29 @@ void arena_deallocate_chunk(arena_t *arena, chunk_t *chunk) {
   arena_internal_free(arena, chunk);
 }
 
+void arena_apply_chunk_conf(arena_t *arena) {
+  assert(arena->is_initialized == 1);
+  for (ll_entry_t *entry = arena->chunk_list.ll; entry != NULL;
+       entry = entry->link.fd) {
+    arena_conf_chunk(arena, CONTAINER_OF(entry, chunk_t, entry));
+  }
+}
+
+size_t arena_decommit(arena_t *arena) {
+  assert(arena->is_initialized == 1);
+  ll_entry_t *entry = arena->chunk_list.ll, *next;
+  chunk_t *chunk;
+  size_t released = 0;
+  while (entry != NULL) {
+    next = entry->link.fd;
+    chunk = CONTAINER_OF(entry, chunk_t, entry);
+    released += chunk_decommit(chunk);
+    if (chunk_is_unmapped(chunk)) arena_deallocate_chunk(arena, chunk);
+    entry = next;
+  }
+  return released;
+}
+
 chunk_t *arena_get_chunk_from_ptr(const arena_t *arena, const void *ptr,
                                   chunk_t *start_chunk) {
   assert(arena->is_initialized == 1);
@@ -299,10 +409,11 @@ static inline unsigned ceil_div(unsigned a, unsigned b) {
 }
 
 bool arena_supply_runs(arena_t *arena, bin_t *bin) {
-  assert(BIN_MINIMUM_REGIONS > bin->avail_regs);
+  assert(bin->min_regions > bin->avail_regs);
   run_t *run;
-  unsigned runs_to_allocate = ceil_div(BIN_MINIMUM_REGIONS - bin->avail_regs,
-                                       bin->reg_mask_size_bits / 2);
+  unsigned runs_to_allocate =
+      ceil_div(bin->min_regions - bin->avail_regs,
+               bin->reg_mask_size_bits / 2);
   se_debug("Adding %u more runs (%u regions total)", runs_to_allocate,
            runs_to_allocate * (bin->reg_mask_size_bits / 2));
   for (unsigned i = 0; i < runs_to_allocate; i++) {
@@ -314,31 +425,46 @@ bool arena_supply_runs(arena_t *arena, bin_t *bin) {
   return true;
 }
 
-bin_t *arena_get_bin_by_reg_size(arena_t *arena, unsigned reg_size) {
-  assert(arena->is_initialized == 1);
+// Index of bin holding regions of reg_size
+static unsigned arena_bin_idx(unsigned reg_size) {
   assert(reg_size >= 1);
   assert(reg_size <= LARGE_SIZE_MAX_REGION);
-
-  unsigned skip_bins = 0;
-  bin_t *bin = NULL;
   // Assume reg_size is either small, medium or large class
   if (IS_SIZE_SMALL(reg_size)) {
     // 0 .. 31
     assert(ALIGNUP_SMALL_SIZE(reg_size) == reg_size);
-    bin = &arena->bins[SIZE_TO_IDX_SMALL(reg_size)];
-  } else if (IS_SIZE_MEDIUM(reg_size)) {
+    return SIZE_TO_IDX_SMALL(reg_size);
+  }
+  if (IS_SIZE_MEDIUM(reg_size)) {
     // 32 .. 34
     assert(alignup_medium_size(reg_size) == reg_size);
-    skip_bins = NO_SMALL_SIZE_CLASSES;
-    bin = &arena->bins[skip_bins + size_to_idx_medium(reg_size)];
-  } else {
-    // 35 ... 43
-    assert(alignup_large_size(reg_size) == reg_size);
-    skip_bins = NO_SMALL_SIZE_CLASSES + NO_MEDIUM_SIZE_CLASSES;
-    bin = &arena->bins[skip_bins + size_to_idx_large(reg_size)];
+    return NO_SMALL_SIZE_CLASSES + size_to_idx_medium(reg_size);
   }
+  // 35 ... 43
+  assert(alignup_large_size(reg_size) == reg_size);
+  return NO_SMALL_SIZE_CLASSES + NO_MEDIUM_SIZE_CLASSES +
+         size_to_idx_large(reg_size);
+}
+
+bin_t *arena_find_bin_by_reg_size(arena_t *arena, unsigned reg_size) {
+  assert(arena->is_initialized == 1);
+  bin_t *bin = &arena->bins[arena_bin_idx(reg_size)];
+  return bin->reg_size == 0 ? NULL : bin;
+}
+
+bin_t *arena_get_bin_by_reg_size(arena_t *arena, unsigned reg_size) {
+  assert(arena->is_initialized == 1);
+  unsigned run_size_pages;
+  bin_t *bin = &arena->bins[arena_bin_idx(reg_size)];
+  if (IS_SIZE_SMALL(reg_size))
+    run_size_pages = arena->conf.run_size_small_pages;
+  else if (IS_SIZE_MEDIUM(reg_size))
+    run_size_pages = arena->conf.run_size_medium_pages;
+  else
+    run_size_pages = reg_size / PAGE_SIZE;
   if (bin->reg_size == 0) {
-    bin_init(bin, reg_size);
+    bin_init_with_run_size(bin, reg_size, run_size_pages);
+    bin->min_regions = arena->conf.bin_min_regions;
   }
   assert(bin->reg_size == reg_size);
   return bin;
@@ -355,6 +481,11 @@ huge_chunk_t *arena_find_huge_mapping(const arena_t *arena,
 }
 
 huge_chunk_t *arena_allocate_huge_mapping(arena_t *arena, size_t len) {
+  return arena_allocate_huge_mapping_aligned(arena, len, PAGE_SIZE);
+}
+
+huge_chunk_t *arena_allocate_huge_mapping_aligned(arena_t *arena, size_t len,
+                                                  size_t alignment) {
   assert(IS_ALIGNED(len, PAGE_SIZE));
   assert(arena->is_initialized == 1);
   huge_chunk_t *huge;
@@ -363,10 +494,12 @@ huge_chunk_t *arena_allocate_huge_mapping(arena_t *arena, size_t len) {
 
   huge = arena_internal_alloc(arena, sizeof(huge_chunk_t));
   huge->len = len;
+  huge->sampled = false;
   huge->entry.link.fd = NULL;
   huge->entry.link.bk = NULL;
-  map = arena_morecore(arena, &arena->huge_alloc_ptr,
-                       reset_huge_alloc_ptr_start, len, &ceil_addr);
+  map = arena_morecore_aligned(arena, &arena->huge_alloc_ptr,
+                               reset_huge_alloc_ptr_start, len, &ceil_addr,
+                               alignment);
   huge->entry.key = (void *)map;
   // Leave one page space in between to avoid overflows
   if (map == arena->huge_alloc_ptr) arena->huge_alloc_ptr += len + PAGE_SIZE;
@@ -408,11 +541,35 @@ void arena_reallocate_huge_mapping(arena_t *arena, huge_chunk_t *huge,
              huge->entry.key, huge->len, platform_strerror(code));
   }
 
+  // Sample is keyed by the old address
+  if (huge->sampled) {
+    prof_forget(arena, huge->entry.key);
+    huge->sampled = false;
+  }
+
   // Update chunk info
   huge->entry.key = (void *)map;
   huge->len = new_size;
 }
 
+bool arena_expand_huge_mapping(arena_t *arena, huge_chunk_t *huge,
+                               size_t new_size) {
+  assert(IS_ALIGNED(new_size, PAGE_SIZE));
+  assert(arena->is_initialized == 1);
+  assert(new_size > huge->len);
+  uintptr_t start = (uintptr_t)huge->entry.key;
+  // Page gap is kept, same as between fresh huge mappings
+  if (platform_expand_in_place(huge->entry.key, huge->len, new_size,
+                               PAGE_SIZE) != PLATFORM_STATUS_OK)
+    return false;
+  huge->len = new_size;
+  // Probing from inside the mapping would place next one right after it
+  if (start <= arena->huge_alloc_ptr &&
+      arena->huge_alloc_ptr < start + new_size + PAGE_SIZE)
+    arena->huge_alloc_ptr = start + new_size + PAGE_SIZE;
+  return true;
+}
+
 void arena_deallocate_huge_mapping(arena_t *arena, huge_chunk_t *huge) {
   assert(IS_ALIGNED(huge->len, PAGE_SIZE));
   assert(arena->is_initialized == 1);
@@ -422,6 +579,79 @@ void arena_deallocate_huge_mapping(arena_t *arena, huge_chunk_t *huge) {
     se_error("Failed to deallocate huge mapping (ptr : %p, size : %u): %s",
              huge->entry.key, huge->len, platform_strerror(code));
   }
+  if (huge->sampled) prof_forget(arena, huge->entry.key);
   ll_del(&arena->huge_alloc_list, &huge->entry);
   arena_internal_free(arena, huge);
 }
+
+// Unmaps memory released as a whole, fails on error
+static void arena_unmap(void *ptr, size_t len) {
+  platform_status_code_t code;
+  if ((code = platform_unmap(ptr, len)) != PLATFORM_STATUS_OK) {
+    se_error("Failed to unmap mapping (ptr : %p, size : %zu): %s", ptr, len,
+             platform_strerror(code));
+  }
+}
+
+void arena_destroy(arena_t *arena) {
+  assert(arena->is_initialized == 1);
+  ll_entry_t *entry, *next;
+  se_debug("Destroying arena");
+  trace_close(&arena->trace);
+
+  // Chunk memory together with its guard page, holes left by freed runs
+  // are fine to unmap again
+  for (entry = arena->chunk_list.ll; entry != NULL; entry = entry->link.fd)
+    arena_unmap(entry->key, CHUNK_SIZE_BYTES + PAGE_SIZE);
+  // Chunks of current mapping which were not handed out yet
+  if (arena->chunks_left > 0)
+    arena_unmap((void *)arena->chunk_ptr,
+                arena->chunks_left * (CHUNK_SIZE_BYTES + PAGE_SIZE));
+  for (entry = arena->huge_alloc_list.ll; entry != NULL; entry = entry->link.fd)
+    arena_unmap(entry->key, CONTAINER_OF(entry, huge_chunk_t, entry)->len);
+  // All other metadata lives in internal allocator units, unmap them last
+  for (entry = arena->internal_alloc_list.ll; entry != NULL; entry = next) {
+    next = entry->link.fd;
+    arena_unmap(CONTAINER_OF(entry, int_alloc_t, entry),
+                ALIGNUP_PAGE(sizeof(int_alloc_t)));
+  }
+  arena->is_initialized = 0;
+}
+
+size_t arena_trim(arena_t *arena) {
+  assert(arena->is_initialized == 1);
+  ll_entry_t *entry, *next;
+  chunk_t *chunk;
+  int_alloc_t *unit;
+  size_t released = arena_decommit(arena);
+
+  // Chunks nothing was allocated from
+  for (entry = arena->chunk_list.ll; entry != NULL; entry = next) {
+    next = entry->link.fd;
+    chunk = CONTAINER_OF(entry, chunk_t, entry);
+    if (chunk_is_empty(chunk)) {
+      chunk_release(chunk);
+      arena_deallocate_chunk(arena, chunk);
+      released += CHUNK_SIZE_BYTES;
+    }
+  }
+  // Chunks of current mapping which were not handed out yet
+  if (arena->chunks_left > 0) {
+    arena_unmap((void *)arena->chunk_ptr,
+                arena->chunks_left * (CHUNK_SIZE_BYTES + PAGE_SIZE));
+    released += arena->chunks_left * CHUNK_SIZE_BYTES;
+    arena->chunks_left = 0;
+  }
+  // Internal allocator units with nothing allocated, released chunks above
+  // may have emptied some
+  for (entry = arena->internal_alloc_list.ll; entry != NULL; entry = next) {
+    next = entry->link.fd;
+    unit = CONTAINER_OF(entry, int_alloc_t, entry);
+    if (unit->free_mem == sizeof(unit->memory)) {
+      ll_del(&arena->internal_alloc_list, entry);
+      arena_unmap(unit, ALIGNUP_PAGE(sizeof(int_alloc_t)));
+      released += ALIGNUP_PAGE(sizeof(int_alloc_t));
+    }
+  }
+  return released;
+}
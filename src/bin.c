@@ -4,30 +4,52 @@
 
 #include "sealloc/container_ll.h"
 #include "sealloc/logging.h"
+#include "sealloc/probes.h"
 #include "sealloc/random.h"
 #include "sealloc/run.h"
 #include "sealloc/size_class.h"
 #include "sealloc/utils.h"
 
+void bin_init_with_run_size(bin_t *bin, unsigned reg_size,
+                            unsigned run_size_pages) {
+  ll_init(&bin->run_list_inactive);
+  ll_init(&bin->run_list_active);
+  bin->run_size_pages = run_size_pages;
+  bin->reg_size = reg_size;
+  bin->avail_regs = 0;
+  bin->reg_mask_size_bits = ((bin->run_size_pages * PAGE_SIZE) / reg_size) * 2;
+  // Offsets within a run are below 2^32, so (off * magic) >> 32 is exact
+  // whenever off is a multiple of reg_size
+  bin->reg_size_magic =
+      (uint32_t)(((UINT64_C(1) << 32) + reg_size - 1) / reg_size);
+  bin->run_list_active_cnt = 0;
+  bin->is_pool = false;
+  bin->min_regions = BIN_MINIMUM_REGIONS;
+  bin->nallocs = 0;
+  bin->nfrees = 0;
+  bin->nruns_released = 0;
+}
+
 void bin_init(bin_t *bin, unsigned reg_size) {
   assert(reg_size >= 1);
   assert(reg_size <= LARGE_SIZE_MAX_REGION);
   assert(is_size_aligned(reg_size));
 
-  ll_init(&bin->run_list_inactive);
-  ll_init(&bin->run_list_active);
   if (IS_SIZE_SMALL(reg_size)) {
-    bin->run_size_pages = RUN_SIZE_SMALL_PAGES;
+    bin_init_with_run_size(bin, reg_size, RUN_SIZE_SMALL_PAGES);
   } else if (IS_SIZE_MEDIUM(reg_size)) {
-    bin->run_size_pages = RUN_SIZE_MEDIUM_PAGES;
+    bin_init_with_run_size(bin, reg_size, RUN_SIZE_MEDIUM_PAGES);
   } else {
     // Assuming large size class
-    bin->run_size_pages = reg_size / PAGE_SIZE;
+    bin_init_with_run_size(bin, reg_size, reg_size / PAGE_SIZE);
   }
-  bin->reg_size = reg_size;
-  bin->avail_regs = 0;
-  bin->reg_mask_size_bits = ((bin->run_size_pages * PAGE_SIZE) / reg_size) * 2;
-  bin->run_list_active_cnt = 0;
+}
+
+void bin_init_pool(bin_t *bin, unsigned reg_size, unsigned run_size_pages) {
+  assert(reg_size >= 1);
+  assert(run_size_pages * PAGE_SIZE >= reg_size);
+  bin_init_with_run_size(bin, reg_size, run_size_pages);
+  bin->is_pool = true;
 }
 
 void bin_add_run(bin_t *bin, run_t *run) {
@@ -47,17 +69,26 @@ void bin_delete_run(bin_t *bin, run_t *run) {
 }
 
 run_t *bin_get_run_for_allocation(bin_t *bin) {
+  unsigned nregs = 1;
+  return bin_get_run_for_batch(bin, &nregs);
+}
+
+run_t *bin_get_run_for_batch(bin_t *bin, unsigned *nregs) {
   assert(bin->reg_size != 0);
   assert(bin->avail_regs > 0);
   assert(bin->run_list_active_cnt > 0);
+  assert(*nregs >= 1);
 
   unsigned run_idx = splitmix32() % bin->run_list_active_cnt;
   ll_entry_t *entry = bin->run_list_active.ll;
+  run_t *run;
   se_debug("Before search, run_idx : %u", run_idx);
   for (; entry != NULL; entry = entry->link.fd) {
     if (run_idx == 0) {
-      bin->avail_regs--;
-      return CONTAINER_OF(entry, run_t, entry);
+      run = CONTAINER_OF(entry, run_t, entry);
+      if (*nregs > run->navail) *nregs = run->navail;
+      bin->avail_regs -= *nregs;
+      return run;
     }
     run_idx--;
   }
@@ -67,6 +98,7 @@ run_t *bin_get_run_for_allocation(bin_t *bin) {
 void bin_retire_run(bin_t *bin, run_t *run) {
   assert(bin->reg_size != 0);
   assert(run->navail == 0);
+  se_probe2(run_retire, run->entry.key, bin->reg_size);
   ll_del(&bin->run_list_active, &run->entry);
   ll_add(&bin->run_list_inactive, &run->entry);
   bin->run_list_active_cnt--;
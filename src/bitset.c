@@ -0,0 +1,293 @@
+#include "sealloc/bitset.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define BITSET_HAVE_X86_KERNELS 1
+#endif
+
+typedef struct bitset_kernels {
+  size_t (*count)(const uint64_t *, size_t);
+  size_t (*count_andnot)(const uint64_t *, const uint64_t *, size_t);
+  size_t (*find_next)(const uint64_t *, size_t, size_t);
+  size_t (*find_next_andnot)(const uint64_t *, const uint64_t *, size_t,
+                             size_t);
+} bitset_kernels_t;
+
+// Mask of bits at positions >= start % 64 within the word holding start
+static inline uint64_t first_word_mask(size_t start) {
+  return ~UINT64_C(0) << (start % 64);
+}
+
+/*
+ * Generic kernels, compiler picks whatever instructions target allows.
+ */
+static size_t count_generic(const uint64_t *set, size_t words) {
+  size_t cnt = 0;
+  for (size_t i = 0; i < words; i++) cnt += __builtin_popcountll(set[i]);
+  return cnt;
+}
+
+static size_t count_andnot_generic(const uint64_t *a, const uint64_t *b,
+                                   size_t words) {
+  size_t cnt = 0;
+  for (size_t i = 0; i < words; i++) cnt += __builtin_popcountll(a[i] & ~b[i]);
+  return cnt;
+}
+
+static size_t find_next_generic(const uint64_t *set, size_t words,
+                                size_t start) {
+  size_t i = start / 64;
+  if (i >= words) return SIZE_MAX;
+  uint64_t word = set[i] & first_word_mask(start);
+  while (word == 0) {
+    if (++i == words) return SIZE_MAX;
+    word = set[i];
+  }
+  return i * 64 + __builtin_ctzll(word);
+}
+
+static size_t find_next_andnot_generic(const uint64_t *a, const uint64_t *b,
+                                       size_t words, size_t start) {
+  size_t i = start / 64;
+  if (i >= words) return SIZE_MAX;
+  uint64_t word = a[i] & ~b[i] & first_word_mask(start);
+  while (word == 0) {
+    if (++i == words) return SIZE_MAX;
+    word = a[i] & ~b[i];
+  }
+  return i * 64 + __builtin_ctzll(word);
+}
+
+#ifdef BITSET_HAVE_X86_KERNELS
+/*
+ * Same loops as generic ones, but compiled with POPCNT and TZCNT enabled.
+ */
+__attribute__((target("popcnt,bmi"))) static size_t count_popcnt(
+    const uint64_t *set, size_t words) {
+  size_t cnt = 0;
+  for (size_t i = 0; i < words; i++) cnt += __builtin_popcountll(set[i]);
+  return cnt;
+}
+
+__attribute__((target("popcnt,bmi"))) static size_t count_andnot_popcnt(
+    const uint64_t *a, const uint64_t *b, size_t words) {
+  size_t cnt = 0;
+  for (size_t i = 0; i < words; i++) cnt += __builtin_popcountll(a[i] & ~b[i]);
+  return cnt;
+}
+
+__attribute__((target("popcnt,bmi"))) static size_t find_next_popcnt(
+    const uint64_t *set, size_t words, size_t start) {
+  size_t i = start / 64;
+  if (i >= words) return SIZE_MAX;
+  uint64_t word = set[i] & first_word_mask(start);
+  while (word == 0) {
+    if (++i == words) return SIZE_MAX;
+    word = set[i];
+  }
+  return i * 64 + __builtin_ctzll(word);
+}
+
+__attribute__((target("popcnt,bmi"))) static size_t find_next_andnot_popcnt(
+    const uint64_t *a, const uint64_t *b, size_t words, size_t start) {
+  size_t i = start / 64;
+  if (i >= words) return SIZE_MAX;
+  uint64_t word = a[i] & ~b[i] & first_word_mask(start);
+  while (word == 0) {
+    if (++i == words) return SIZE_MAX;
+    word = a[i] & ~b[i];
+  }
+  return i * 64 + __builtin_ctzll(word);
+}
+
+/*
+ * AVX2 kernels process 4 words per step. Population count uses nibble lookup
+ * with vpshufb and horizontal byte sums with vpsadbw.
+ */
+__attribute__((target("avx2"))) static inline __m256i popcount_epi64(
+    __m256i v) {
+  const __m256i lookup =
+      _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1,
+                       2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i low_mask = _mm256_set1_epi8(0x0f);
+  __m256i lo = _mm256_and_si256(v, low_mask);
+  __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+  __m256i cnt = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo),
+                                _mm256_shuffle_epi8(lookup, hi));
+  return _mm256_sad_epu8(cnt, _mm256_setzero_si256());
+}
+
+__attribute__((target("avx2"))) static inline size_t hsum_epi64(__m256i v) {
+  return (size_t)_mm256_extract_epi64(v, 0) +
+         (size_t)_mm256_extract_epi64(v, 1) +
+         (size_t)_mm256_extract_epi64(v, 2) +
+         (size_t)_mm256_extract_epi64(v, 3);
+}
+
+__attribute__((target("avx2,popcnt,bmi"))) static size_t count_avx2(
+    const uint64_t *set, size_t words) {
+  __m256i acc = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 4 <= words; i += 4) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)&set[i]);
+    acc = _mm256_add_epi64(acc, popcount_epi64(v));
+  }
+  size_t cnt = hsum_epi64(acc);
+  for (; i < words; i++) cnt += __builtin_popcountll(set[i]);
+  return cnt;
+}
+
+__attribute__((target("avx2,popcnt,bmi"))) static size_t count_andnot_avx2(
+    const uint64_t *a, const uint64_t *b, size_t words) {
+  __m256i acc = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 4 <= words; i += 4) {
+    __m256i va = _mm256_loadu_si256((const __m256i *)&a[i]);
+    __m256i vb = _mm256_loadu_si256((const __m256i *)&b[i]);
+    acc = _mm256_add_epi64(acc, popcount_epi64(_mm256_andnot_si256(vb, va)));
+  }
+  size_t cnt = hsum_epi64(acc);
+  for (; i < words; i++) cnt += __builtin_popcountll(a[i] & ~b[i]);
+  return cnt;
+}
+
+__attribute__((target("avx2,popcnt,bmi"))) static size_t find_next_avx2(
+    const uint64_t *set, size_t words, size_t start) {
+  size_t i = start / 64;
+  if (i >= words) return SIZE_MAX;
+  uint64_t word = set[i] & first_word_mask(start);
+  if (word != 0) return i * 64 + __builtin_ctzll(word);
+  i++;
+  // Skip 256-bit blocks with no set bits
+  for (; i + 4 <= words; i += 4) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)&set[i]);
+    if (!_mm256_testz_si256(v, v)) break;
+  }
+  for (; i < words; i++) {
+    if (set[i] != 0) return i * 64 + __builtin_ctzll(set[i]);
+  }
+  return SIZE_MAX;
+}
+
+__attribute__((target("avx2,popcnt,bmi"))) static size_t
+find_next_andnot_avx2(const uint64_t *a, const uint64_t *b, size_t words,
+                      size_t start) {
+  size_t i = start / 64;
+  if (i >= words) return SIZE_MAX;
+  uint64_t word = a[i] & ~b[i] & first_word_mask(start);
+  if (word != 0) return i * 64 + __builtin_ctzll(word);
+  i++;
+  // Skip 256-bit blocks with no candidates
+  for (; i + 4 <= words; i += 4) {
+    __m256i va = _mm256_loadu_si256((const __m256i *)&a[i]);
+    __m256i vb = _mm256_loadu_si256((const __m256i *)&b[i]);
+    __m256i v = _mm256_andnot_si256(vb, va);
+    if (!_mm256_testz_si256(v, v)) break;
+  }
+  for (; i < words; i++) {
+    word = a[i] & ~b[i];
+    if (word != 0) return i * 64 + __builtin_ctzll(word);
+  }
+  return SIZE_MAX;
+}
+#endif
+
+static const bitset_kernels_t kernels_generic = {
+    .count = count_generic,
+    .count_andnot = count_andnot_generic,
+    .find_next = find_next_generic,
+    .find_next_andnot = find_next_andnot_generic,
+};
+
+#ifdef BITSET_HAVE_X86_KERNELS
+static const bitset_kernels_t kernels_popcnt = {
+    .count = count_popcnt,
+    .count_andnot = count_andnot_popcnt,
+    .find_next = find_next_popcnt,
+    .find_next_andnot = find_next_andnot_popcnt,
+};
+
+static const bitset_kernels_t kernels_avx2 = {
+    .count = count_avx2,
+    .count_andnot = count_andnot_avx2,
+    .find_next = find_next_avx2,
+    .find_next_andnot = find_next_andnot_avx2,
+};
+#endif
+
+// Generic kernels are usable before constructor selects better ones
+static const bitset_kernels_t *kernels = &kernels_generic;
+
+static bool impl_supported(bitset_impl_t impl) {
+  switch (impl) {
+    case BITSET_IMPL_GENERIC:
+      return true;
+#ifdef BITSET_HAVE_X86_KERNELS
+    case BITSET_IMPL_POPCNT:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("popcnt") && __builtin_cpu_supports("bmi");
+    case BITSET_IMPL_AVX2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2") &&
+             __builtin_cpu_supports("popcnt") && __builtin_cpu_supports("bmi");
+#else
+    case BITSET_IMPL_POPCNT:
+    case BITSET_IMPL_AVX2:
+      return false;
+#endif
+  }
+  return false;
+}
+
+bitset_impl_t bitset_best_impl(void) {
+  if (impl_supported(BITSET_IMPL_AVX2)) return BITSET_IMPL_AVX2;
+  if (impl_supported(BITSET_IMPL_POPCNT)) return BITSET_IMPL_POPCNT;
+  return BITSET_IMPL_GENERIC;
+}
+
+bool bitset_select_impl(bitset_impl_t impl) {
+  if (!impl_supported(impl)) return false;
+  switch (impl) {
+    case BITSET_IMPL_GENERIC:
+      kernels = &kernels_generic;
+      break;
+#ifdef BITSET_HAVE_X86_KERNELS
+    case BITSET_IMPL_POPCNT:
+      kernels = &kernels_popcnt;
+      break;
+    case BITSET_IMPL_AVX2:
+      kernels = &kernels_avx2;
+      break;
+#else
+    default:
+      return false;
+#endif
+  }
+  return true;
+}
+
+__attribute__((constructor)) void init_bitset_kernels(void) {
+  bitset_select_impl(bitset_best_impl());
+}
+
+size_t bitset_count(const uint64_t *set, size_t words) {
+  return kernels->count(set, words);
+}
+
+size_t bitset_count_andnot(const uint64_t *a, const uint64_t *b,
+                           size_t words) {
+  return kernels->count_andnot(a, b, words);
+}
+
+size_t bitset_find_next(const uint64_t *set, size_t words, size_t start) {
+  return kernels->find_next(set, words, start);
+}
+
+size_t bitset_find_next_andnot(const uint64_t *a, const uint64_t *b,
+                               size_t words, size_t start) {
+  return kernels->find_next_andnot(a, b, words, start);
+}
@@ -111,6 +111,35 @@ void chunk_init(chunk_t *chunk, void *heap) {
   }
   chunk->avail_nodes_count[0] = 0;
   chunk->jump_tree_first_index[0] = 0;
+  chunk->random_lookup_tries = RANDOM_LOOKUP_TRIES;
+  chunk->random_lookup_threshold = RANDOM_LOOKUP_TRESHOLD_PERCENTAGE;
+  chunk->unmap_threshold = CHUNK_UNMAP_THRESHOLD;
+  memset(chunk->prof_leaves, 0, sizeof(chunk->prof_leaves));
+  memset(chunk->runs, 0, sizeof(chunk->runs));
+}
+
+static size_t chunk_leaf_of(const chunk_t *chunk, const void *ptr) {
+  return ((uintptr_t)ptr - (uintptr_t)chunk->entry.key) /
+         CHUNK_LEAST_REGION_SIZE_BYTES;
+}
+
+void chunk_mark_sampled(chunk_t *chunk, const void *ptr) {
+  bitset_set(chunk->prof_leaves, chunk_leaf_of(chunk, ptr));
+}
+
+bool chunk_is_sampled(const chunk_t *chunk, const void *ptr) {
+  return bitset_get(chunk->prof_leaves, chunk_leaf_of(chunk, ptr));
+}
+
+void chunk_set_run(chunk_t *chunk, const void *run_ptr, run_t *run) {
+  chunk->runs[chunk_leaf_of(chunk, run_ptr)] = run;
+}
+
+run_t *chunk_get_run(const chunk_t *chunk, const void *ptr, unsigned run_size) {
+  const size_t leaf = chunk_leaf_of(chunk, ptr);
+  assert(leaf < CHUNK_NO_NODES_LAST_LAYER);
+  return chunk->runs[leaf & ~(size_t)(run_size / CHUNK_LEAST_REGION_SIZE_BYTES -
+                                       1)];
 }
 
 void buddy_state_go_up(buddy_ctx_t *ctx) {
@@ -139,6 +168,14 @@ unsigned size2idx(unsigned run_size) {
   return ctz(run_size / CHUNK_LEAST_REGION_SIZE_BYTES);
 }
 
+// Leaf mark for run allocated at given level of the tree
+static inline uint16_t get_reg_mark(unsigned level, unsigned reg_size) {
+  if (REG_MARK_IS_POOL(reg_size)) return reg_size;
+  if (IS_SIZE_LARGE(reg_size))
+    return REG_MARK_LARGE | (CHUNK_BUDDY_TREE_DEPTH - level);
+  return reg_size;
+}
+
 void *chunk_allocate_with_node(chunk_t *chunk, jump_node_t node,
                                const unsigned idx, const unsigned level,
                                const unsigned reg_size) {
@@ -200,8 +237,8 @@ void *chunk_allocate_with_node(chunk_t *chunk, jump_node_t node,
 
   // If idx is a leaf node then job is done
   if (IS_LEAF(idx)) {
-    if (reg_size != CHUNK_LEAST_REGION_SIZE_BYTES)
-      chunk->reg_size_small_medium[idx - base_level_idx] = reg_size;
+    chunk->reg_size_small_medium[idx - base_level_idx] =
+        get_reg_mark(level, reg_size);
     set_buddy_tree_item(chunk->buddy_tree, idx, NODE_USED);
     return (void *)((uintptr_t)chunk->entry.key +
                     (idx - base_level_idx) * CHUNK_LEAST_REGION_SIZE_BYTES);
@@ -268,6 +305,7 @@ void *chunk_allocate_with_node(chunk_t *chunk, jump_node_t node,
   set_buddy_tree_item(chunk->buddy_tree, idx, NODE_USED);
   unsigned offset = get_leftmost_idx(idx, CHUNK_BUDDY_TREE_DEPTH - level) -
                     ((CHUNK_NO_NODES + 1) / 2);
+  chunk->reg_size_small_medium[offset] = get_reg_mark(level, reg_size);
   return (void *)((uintptr_t)chunk->entry.key +
                   offset * CHUNK_LEAST_REGION_SIZE_BYTES);
 }
@@ -275,7 +313,7 @@ void *chunk_allocate_with_node(chunk_t *chunk, jump_node_t node,
 void *chunk_allocate_run(chunk_t *chunk, unsigned run_size, unsigned reg_size) {
   assert(CHUNK_LEAST_REGION_SIZE_BYTES <= run_size);
   assert(run_size <= CHUNK_SIZE_BYTES);
-  assert(is_size_aligned(reg_size));
+  assert(REG_MARK_IS_POOL(reg_size) || is_size_aligned(reg_size));
 
   // Check if we can allocate in this chunk
   const unsigned level = CHUNK_BUDDY_TREE_DEPTH - size2idx(run_size);
@@ -287,8 +325,8 @@ void *chunk_allocate_run(chunk_t *chunk, unsigned run_size, unsigned reg_size) {
 
   unsigned rand_idx, current_idx;
   // Try to hit a free node
-  if (((avail_nodes * 100) / all_nodes) > RANDOM_LOOKUP_TRESHOLD_PERCENTAGE) {
-    for (uint8_t i = 0; i < RANDOM_LOOKUP_TRIES; i++) {
+  if (((avail_nodes * 100) / all_nodes) > chunk->random_lookup_threshold) {
+    for (uint8_t i = 0; i < chunk->random_lookup_tries; i++) {
       rand_idx = splitmix32() % all_nodes;
       node = get_jt_item(chunk->jump_tree, level_base_idx + rand_idx);
       if (node.prev != 0 || node.next != 0) {
@@ -340,8 +378,9 @@ static void coalesce_depleted_nodes(buddy_ctx_t *ctx, chunk_t *chunk) {
   }
 
   // We've merged as much depleted nodes as possible
-  // Check if depth passed the unmap threshold
-  // if (ctx->depth_to_leaf >= CHUNK_UNMAP_THRESHOLD) {
+  // Check if depth passed the unmap threshold, depleted root is unmapped
+  // anyway, so that chunk can be released
+  if (ctx->depth_to_leaf < chunk->unmap_threshold && ctx->idx > 1) return;
   // We passed the threshold, unmap
   if ((code = platform_unmap((void *)ctx->ptr, ctx->cur_size)) !=
       PLATFORM_STATUS_OK) {
@@ -350,7 +389,104 @@ static void coalesce_depleted_nodes(buddy_ctx_t *ctx, chunk_t *chunk) {
   }
   set_buddy_tree_item(chunk->buddy_tree, ctx->idx, NODE_UNMAPPED);
   coalesce_unmapped_nodes(ctx, chunk);
-  //}
+}
+
+static size_t decommit_node(chunk_t *chunk, unsigned idx, uintptr_t ptr,
+                            unsigned size, unsigned depth_to_leaf) {
+  chunk_node_t node = get_buddy_tree_item(chunk->buddy_tree, idx);
+  platform_status_code_t code;
+  size_t left;
+  if (node == NODE_DEPLETED) {
+    if ((code = platform_unmap((void *)ptr, size)) != PLATFORM_STATUS_OK) {
+      se_error("Failed unmap page (ptr : %p, size : %u): %s.", (void *)ptr,
+               size, platform_strerror(code));
+    }
+    set_buddy_tree_item(chunk->buddy_tree, idx, NODE_UNMAPPED);
+    buddy_ctx_t ctx = {.idx = idx,
+                       .cur_size = size,
+                       .depth_to_leaf = depth_to_leaf,
+                       .ptr = ptr,
+                       .state = DOWN};
+    coalesce_unmapped_nodes(&ctx, chunk);
+    return size;
+  }
+  // Depleted nodes are never below used or unmapped ones
+  if (node != NODE_FREE || depth_to_leaf == 0) return 0;
+  left = decommit_node(chunk, LEFT_CHILD(idx), ptr, size / 2,
+                       depth_to_leaf - 1);
+  return left + decommit_node(chunk, RIGHT_CHILD(idx), ptr + size / 2,
+                              size / 2, depth_to_leaf - 1);
+}
+
+size_t chunk_decommit(chunk_t *chunk) {
+  return decommit_node(chunk, 1, (uintptr_t)chunk->entry.key, CHUNK_SIZE_BYTES,
+                       CHUNK_BUDDY_TREE_DEPTH);
+}
+
+// Walks nodes in address order, *mapped tells if memory before node is mapped
+static void usage_node(chunk_t *chunk, unsigned idx, unsigned size,
+                       unsigned depth_to_leaf, chunk_usage_t *usage,
+                       bool *mapped) {
+  const unsigned first_leaf_idx = (CHUNK_NO_NODES + 1) / 2;
+  chunk_node_t node = get_buddy_tree_item(chunk->buddy_tree, idx);
+  uint16_t mark;
+  if (node == NODE_UNMAPPED) {
+    usage->unmapped_bytes += size;
+    *mapped = false;
+    return;
+  }
+  // Subtrees which are not split further are mapped as a whole
+  if ((node == NODE_USED || node == NODE_DEPLETED || depth_to_leaf == 0) &&
+      !*mapped) {
+    usage->nsegments++;
+    *mapped = true;
+  }
+  switch (node) {
+    case NODE_DEPLETED:
+      usage->depleted_bytes += size;
+      return;
+    case NODE_USED:
+      usage->run_bytes += size;
+      usage->nruns[depth_to_leaf]++;
+      // Mark is kept at the leftmost leaf of the run
+      mark = chunk->reg_size_small_medium[idx * (size /
+                                                 CHUNK_LEAST_REGION_SIZE_BYTES) -
+                                          first_leaf_idx];
+      if (mark != REG_MARK_BAD_VALUE && (mark & REG_MARK_LARGE))
+        usage->nlarge[mark & REG_MARK_LARGE_ORDER_MASK]++;
+      return;
+    default:
+      break;
+  }
+  if (depth_to_leaf == 0) return;
+  usage_node(chunk, LEFT_CHILD(idx), size / 2, depth_to_leaf - 1, usage,
+             mapped);
+  usage_node(chunk, RIGHT_CHILD(idx), size / 2, depth_to_leaf - 1, usage,
+             mapped);
+}
+
+void chunk_get_usage(chunk_t *chunk, chunk_usage_t *usage) {
+  bool mapped = false;
+  usage_node(chunk, 1, CHUNK_SIZE_BYTES, CHUNK_BUDDY_TREE_DEPTH, usage,
+             &mapped);
+}
+
+bool chunk_is_empty(chunk_t *chunk) {
+  // Leaves are never given back, so every one of them is free only in unused
+  // chunk
+  return chunk->avail_nodes_count[CHUNK_BUDDY_TREE_DEPTH] ==
+         CHUNK_NO_NODES_LAST_LAYER;
+}
+
+void chunk_release(chunk_t *chunk) {
+  platform_status_code_t code;
+  assert(chunk_is_empty(chunk));
+  if ((code = platform_unmap(chunk->entry.key, CHUNK_SIZE_BYTES)) !=
+      PLATFORM_STATUS_OK) {
+    se_error("Failed unmap page (ptr : %p, size : %u): %s.", chunk->entry.key,
+             CHUNK_SIZE_BYTES, platform_strerror(code));
+  }
+  set_buddy_tree_item(chunk->buddy_tree, 1, NODE_UNMAPPED);
 }
 
 bool chunk_deallocate_run(chunk_t *chunk, void *run_ptr) {
@@ -374,6 +510,8 @@ bool chunk_deallocate_run(chunk_t *chunk, void *run_ptr) {
     node = get_buddy_tree_item(chunk->buddy_tree, idx);
   }
   set_buddy_tree_item(chunk->buddy_tree, idx, NODE_DEPLETED);
+  chunk->reg_size_small_medium[ptr_offset] = REG_MARK_BAD_VALUE;
+  chunk->runs[ptr_offset] = NULL;
   buddy_ctx_t ctx = {.idx = idx,
                      .cur_size = CHUNK_LEAST_REGION_SIZE_BYTES << depth_to_leaf,
                      .depth_to_leaf = depth_to_leaf,
@@ -384,6 +522,59 @@ bool chunk_deallocate_run(chunk_t *chunk, void *run_ptr) {
   return false;
 }
 
+// True if node and its whole subtree were never allocated
+static inline bool is_node_free(chunk_t *chunk, unsigned idx, unsigned level) {
+  jump_node_t node = get_jt_item(chunk->jump_tree, idx);
+  return node.prev != 0 || node.next != 0 ||
+         chunk->jump_tree_first_index[level] == idx;
+}
+
+unsigned chunk_expand_run(chunk_t *chunk, void *run_ptr, unsigned run_size,
+                          unsigned min_run_size, unsigned max_run_size) {
+  assert(run_size <= min_run_size && min_run_size <= max_run_size);
+  const unsigned first_leaf_idx = (CHUNK_NO_NODES + 1) / 2;
+  const unsigned offset =
+      ((uintptr_t)run_ptr - (uintptr_t)chunk->entry.key) /
+      CHUNK_LEAST_REGION_SIZE_BYTES;
+  const unsigned run_idx = (first_leaf_idx + offset) >> size2idx(run_size);
+  const unsigned run_level = CHUNK_BUDDY_TREE_DEPTH - size2idx(run_size);
+  unsigned idx = run_idx, level = run_level, size = run_size;
+  assert(get_buddy_tree_item(chunk->buddy_tree, run_idx) == NODE_USED);
+
+  // Find out how far the run can grow before touching anything
+  while (size < max_run_size && !IS_RIGHT_CHILD(idx) &&
+         is_node_free(chunk, idx + 1, level)) {
+    idx = PARENT(idx);
+    level--;
+    size *= 2;
+  }
+  if (size < min_run_size) return run_size;
+
+  /*
+   * Take each buddy as if it was allocated, then move the run one level up.
+   * Children of a used node stay free in buddy tree, so that deallocation
+   * stops at the new run node.
+   */
+  const unsigned target_level = level;
+  idx = run_idx;
+  level = run_level;
+  size = run_size;
+  while (level > target_level) {
+    chunk_allocate_with_node(chunk, get_jt_item(chunk->jump_tree, idx + 1),
+                             idx + 1, level, run_size);
+    chunk->reg_size_small_medium[offset + size / CHUNK_LEAST_REGION_SIZE_BYTES] =
+        REG_MARK_BAD_VALUE;
+    set_buddy_tree_item(chunk->buddy_tree, idx, NODE_FREE);
+    set_buddy_tree_item(chunk->buddy_tree, idx + 1, NODE_FREE);
+    idx = PARENT(idx);
+    level--;
+    size *= 2;
+    set_buddy_tree_item(chunk->buddy_tree, idx, NODE_USED);
+  }
+  chunk->reg_size_small_medium[offset] = get_reg_mark(level, run_size);
+  return size;
+}
+
 // Fills run data based of ptr
 void chunk_get_run_ptr(chunk_t *chunk, void *ptr, void **run_ptr,
                        unsigned *run_size, unsigned *reg_size) {
@@ -396,10 +587,8 @@ void chunk_get_run_ptr(chunk_t *chunk, void *ptr, void **run_ptr,
     return;
   }
   const uintptr_t rel_ptr = (uintptr_t)ptr - chunk_ptr;
-  const uintptr_t block_offset = rel_ptr / CHUNK_LEAST_REGION_SIZE_BYTES;
   const unsigned first_leaf_idx = (CHUNK_NO_NODES + 1) / 2;
-  uintptr_t target_run_ptr =
-      chunk_ptr + (block_offset * CHUNK_LEAST_REGION_SIZE_BYTES);
+  uintptr_t block_offset = rel_ptr / CHUNK_LEAST_REGION_SIZE_BYTES;
 
   chunk_node_t node;
   unsigned cur_size = CHUNK_LEAST_REGION_SIZE_BYTES;
@@ -407,34 +596,41 @@ void chunk_get_run_ptr(chunk_t *chunk, void *ptr, void **run_ptr,
 
   node = get_buddy_tree_item(chunk->buddy_tree, idx);
 
-  // This case is not that common
-  if (node != NODE_USED) {
-    while (node != NODE_USED) {
-      if (IS_ROOT(idx) || IS_RIGHT_CHILD(idx)) {
-        return;
-      }
-      if (node == NODE_DEPLETED || node == NODE_UNMAPPED) {
-        // This may happen when we have huge-in-chunk case or just invalid free
-        // We have to return and check rest of chunks huge allocs
-        // If it is invalid free, we will detect it once we know that this isnt
-        // a huge allocation
-        return;
-      }
-      idx = PARENT(idx);
-      cur_size *= 2;
-      node = get_buddy_tree_item(chunk->buddy_tree, idx);
+  // Pointer lies past the first leaf of its run, this case is not that common
+  while (node != NODE_USED) {
+    if (IS_ROOT(idx)) {
+      return;
+    }
+    if (node == NODE_DEPLETED || node == NODE_UNMAPPED) {
+      // This may happen when we have huge-in-chunk case or just invalid free
+      // We have to return and check rest of chunks huge allocs
+      // If it is invalid free, we will detect it once we know that this isnt
+      // a huge allocation
+      return;
     }
+    idx = PARENT(idx);
+    cur_size *= 2;
+    node = get_buddy_tree_item(chunk->buddy_tree, idx);
+  }
 
-    *run_ptr = (void *)target_run_ptr;
-    *run_size = cur_size;
-    return;
+  // Run starts at the leftmost leaf of its node
+  block_offset = (uintptr_t)idx * (cur_size / CHUNK_LEAST_REGION_SIZE_BYTES) -
+                 first_leaf_idx;
+  const uintptr_t target_run_ptr =
+      chunk_ptr + (block_offset * CHUNK_LEAST_REGION_SIZE_BYTES);
+  const uint16_t mark = chunk->reg_size_small_medium[block_offset];
+  if (mark == REG_MARK_BAD_VALUE) return;
+  if (mark & REG_MARK_LARGE) {
+    // Large run, order in the mark must agree with buddy tree
+    if ((unsigned)CHUNK_LEAST_REGION_SIZE_BYTES
+            << (mark & REG_MARK_LARGE_ORDER_MASK) !=
+        cur_size)
+      return;
+  } else {
+    *reg_size = mark;
   }
   *run_ptr = (void *)target_run_ptr;
   *run_size = cur_size;
-
-  if (chunk->reg_size_small_medium[block_offset] != REG_MARK_BAD_VALUE) {
-    *reg_size = chunk->reg_size_small_medium[block_offset];
-  }
 }
 
 bool chunk_is_unmapped(chunk_t *chunk) {
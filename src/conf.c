@@ -0,0 +1,150 @@
+#include "sealloc/conf.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "sealloc/arena.h"
+#include "sealloc/bin.h"
+#include "sealloc/chunk.h"
+#include "sealloc/logging.h"
+#include "sealloc/prof.h"
+#include "sealloc/run.h"
+#include "sealloc/utils.h"
+
+typedef enum conf_kind {
+  CONF_KIND_COUNT,    // Plain number within [min, max]
+  CONF_KIND_RUN_SIZE  // Run size in bytes, stored in pages
+} conf_kind_t;
+
+typedef struct conf_key {
+  const char *name;
+  size_t offset;
+  unsigned min;
+  unsigned max;
+  conf_kind_t kind;
+} conf_key_t;
+
+static const conf_key_t conf_keys[] = {
+    {"bin_min_regions", offsetof(arena_conf_t, bin_min_regions), 1, 65536,
+     CONF_KIND_COUNT},
+    {"chunks_per_mapping", offsetof(arena_conf_t, chunks_per_mapping), 1, 64,
+     CONF_KIND_COUNT},
+    {"run_size_small", offsetof(arena_conf_t, run_size_small_pages),
+     CHUNK_LEAST_REGION_SIZE_BYTES, CONF_RUN_SIZE_MAX_BYTES,
+     CONF_KIND_RUN_SIZE},
+    {"run_size_medium", offsetof(arena_conf_t, run_size_medium_pages),
+     CHUNK_LEAST_REGION_SIZE_BYTES, CONF_RUN_SIZE_MAX_BYTES,
+     CONF_KIND_RUN_SIZE},
+    {"random_lookup_tries", offsetof(arena_conf_t, random_lookup_tries), 0,
+     255, CONF_KIND_COUNT},
+    {"random_lookup_threshold",
+     offsetof(arena_conf_t, random_lookup_threshold), 0, 100,
+     CONF_KIND_COUNT},
+    {"chunk_unmap_threshold", offsetof(arena_conf_t, chunk_unmap_threshold),
+     0, CHUNK_BUDDY_TREE_DEPTH, CONF_KIND_COUNT},
+    {"prof_interval", offsetof(arena_conf_t, prof_interval), 0,
+     PROF_MAX_INTERVAL, CONF_KIND_COUNT},
+};
+
+#define CONF_NO_KEYS (sizeof(conf_keys) / sizeof(conf_keys[0]))
+
+// Longest entry printed when reporting invalid one
+#define CONF_ENTRY_LOG_MAX 64
+
+void conf_init(arena_conf_t *conf) {
+  conf->bin_min_regions = BIN_MINIMUM_REGIONS;
+  conf->chunks_per_mapping = CHUNKS_PER_MAPPING;
+  conf->run_size_small_pages = RUN_SIZE_SMALL_PAGES;
+  conf->run_size_medium_pages = RUN_SIZE_MEDIUM_PAGES;
+  conf->random_lookup_tries = RANDOM_LOOKUP_TRIES;
+  conf->random_lookup_threshold = RANDOM_LOOKUP_TRESHOLD_PERCENTAGE;
+  conf->chunk_unmap_threshold = CHUNK_UNMAP_THRESHOLD;
+  conf->prof_interval = PROF_DEFAULT_INTERVAL;
+}
+
+static const conf_key_t *conf_find_key(const char *name, size_t len) {
+  for (size_t i = 0; i < CONF_NO_KEYS; i++) {
+    if (strlen(conf_keys[i].name) == len &&
+        memcmp(conf_keys[i].name, name, len) == 0)
+      return &conf_keys[i];
+  }
+  return NULL;
+}
+
+// Parses decimal number of whole [str, str + len), false on garbage or overflow
+static bool conf_parse_number(const char *str, size_t len, unsigned *res) {
+  uint64_t val = 0;
+  if (len == 0) return false;
+  for (size_t i = 0; i < len; i++) {
+    if (str[i] < '0' || str[i] > '9') return false;
+    val = val * 10 + (uint64_t)(str[i] - '0');
+    if (val > UINT32_MAX) return false;
+  }
+  *res = (unsigned)val;
+  return true;
+}
+
+static bool conf_set_key(arena_conf_t *conf, const conf_key_t *key,
+                         unsigned val) {
+  if (val < key->min || val > key->max) return false;
+  if (key->kind == CONF_KIND_RUN_SIZE) {
+    // Runs are allocated from chunk buddy tree
+    if ((val & (val - 1)) != 0) return false;
+    val /= PAGE_SIZE;
+  }
+  *(unsigned *)((char *)conf + key->offset) = val;
+  return true;
+}
+
+static bool conf_apply(arena_conf_t *conf, const char *entry, size_t len) {
+  const char *sep = memchr(entry, ':', len);
+  const conf_key_t *key;
+  unsigned val;
+  if (sep == NULL) return false;
+  key = conf_find_key(entry, (size_t)(sep - entry));
+  if (key == NULL) return false;
+  if (!conf_parse_number(sep + 1, len - (size_t)(sep - entry) - 1, &val))
+    return false;
+  return conf_set_key(conf, key, val);
+}
+
+bool conf_get(const arena_conf_t *conf, const char *name, unsigned *val) {
+  const conf_key_t *key = conf_find_key(name, strlen(name));
+  if (key == NULL) return false;
+  *val = *(const unsigned *)((const char *)conf + key->offset);
+  if (key->kind == CONF_KIND_RUN_SIZE) *val *= PAGE_SIZE;
+  return true;
+}
+
+bool conf_set(arena_conf_t *conf, const char *name, unsigned val) {
+  const conf_key_t *key = conf_find_key(name, strlen(name));
+  if (key == NULL) return false;
+  return conf_set_key(conf, key, val);
+}
+
+static void conf_report(const char *entry, size_t len) {
+  char buf[CONF_ENTRY_LOG_MAX + 1];
+  if (len > CONF_ENTRY_LOG_MAX) len = CONF_ENTRY_LOG_MAX;
+  memcpy(buf, entry, len);
+  buf[len] = '\0';
+  se_log("Invalid " CONF_ENV_NAME " entry, skipping: %s\n", buf);
+}
+
+bool conf_parse(arena_conf_t *conf, const char *str) {
+  const char *end;
+  size_t len;
+  bool ok = true;
+  while (*str != '\0') {
+    end = strchr(str, ',');
+    len = end == NULL ? strlen(str) : (size_t)(end - str);
+    // Empty entries, like trailing comma, are allowed
+    if (len > 0 && !conf_apply(conf, str, len)) {
+      conf_report(str, len);
+      ok = false;
+    }
+    if (end == NULL) break;
+    str = end + 1;
+  }
+  return ok;
+}
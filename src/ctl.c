@@ -0,0 +1,333 @@
+#include "sealloc/ctl.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "sealloc/arena.h"
+#include "sealloc/bin.h"
+#include "sealloc/conf.h"
+#include "sealloc/container_ll.h"
+#include "sealloc/histogram.h"
+#include "sealloc/latency.h"
+#include "sealloc/prof.h"
+#include "sealloc/size_class.h"
+#include "sealloc/utils.h"
+
+// Deepest name holds arena and bin index
+#define CTL_MAX_INDICES 2
+
+typedef struct ctl_req {
+  arena_t *arena;
+  unsigned idx[CTL_MAX_INDICES];  // Numeric components in order of appearance
+  const char *leaf;               // Name of the last component
+  void *oldp;
+  size_t *oldlenp;
+  const void *newp;
+  size_t newlen;
+} ctl_req_t;
+
+typedef int (*ctl_handler_t)(ctl_req_t *req);
+
+typedef struct ctl_node {
+  const char *name;  // NULL if component is an index
+  unsigned nindices;  // Number of valid indices of index component
+  const struct ctl_node *children;
+  size_t nchildren;
+  ctl_handler_t handler;  // Set only on leaves
+} ctl_node_t;
+
+#define CTL_LEAF(name, handler) {name, 0, NULL, 0, handler}
+#define CTL_INNER(name, children) \
+  {name, 0, children, sizeof(children) / sizeof(children[0]), NULL}
+#define CTL_INDEX(nindices, children) \
+  {NULL, nindices, children, sizeof(children) / sizeof(children[0]), NULL}
+
+// Old value is copied out only if caller asked for it with matching length
+static int ctl_check_old(const ctl_req_t *req, size_t len) {
+  if (req->oldp != NULL && (req->oldlenp == NULL || *req->oldlenp != len))
+    return EINVAL;
+  return 0;
+}
+
+static int ctl_read(ctl_req_t *req, const void *val, size_t len) {
+  int ret = ctl_check_old(req, len);
+  if (ret != 0) return ret;
+  if (req->oldp != NULL) memcpy(req->oldp, val, len);
+  if (req->oldlenp != NULL) *req->oldlenp = len;
+  return 0;
+}
+
+static int ctl_read_unsigned(ctl_req_t *req, unsigned val) {
+  if (req->newp != NULL) return EPERM;
+  return ctl_read(req, &val, sizeof(val));
+}
+
+// Reads old value, then takes new one if it was given, false in *written
+// tells caller that there is nothing to store
+static int ctl_rw_unsigned(ctl_req_t *req, unsigned old, unsigned *val,
+                           bool *written) {
+  int ret;
+  *written = false;
+  if (req->newp != NULL && req->newlen != sizeof(unsigned)) return EINVAL;
+  if ((ret = ctl_read(req, &old, sizeof(old))) != 0) return ret;
+  if (req->newp == NULL) return 0;
+  memcpy(val, req->newp, sizeof(unsigned));
+  *written = true;
+  return 0;
+}
+
+// Reading doesn't initialize the bin, bins not used yet read as zeros
+static const bin_t *ctl_bin(ctl_req_t *req) {
+  static const bin_t unused;
+  const bin_t *bin =
+      arena_find_bin_by_reg_size(req->arena, idx_to_size(req->idx[1]));
+  return bin == NULL ? &unused : bin;
+}
+
+static int ctl_bin_reg_size(ctl_req_t *req) {
+  return ctl_read_unsigned(req, ctl_bin(req)->reg_size);
+}
+
+static int ctl_bin_run_size(ctl_req_t *req) {
+  return ctl_read_unsigned(req, ctl_bin(req)->run_size_pages * PAGE_SIZE);
+}
+
+static int ctl_bin_avail_regs(ctl_req_t *req) {
+  return ctl_read_unsigned(req, ctl_bin(req)->avail_regs);
+}
+
+static int ctl_bin_nruns(ctl_req_t *req) {
+  return ctl_read_unsigned(req, ctl_bin(req)->run_list_active_cnt);
+}
+
+static int ctl_bin_min_regions(ctl_req_t *req) {
+  arena_conf_t check = req->arena->conf;
+  unsigned val;
+  bool written;
+  int ret = ctl_rw_unsigned(req, ctl_bin(req)->min_regions, &val, &written);
+  if (ret != 0 || !written) return ret;
+  // Same limits as for all bins
+  if (!conf_set(&check, "bin_min_regions", val)) return EINVAL;
+  // Setting minimum of a bin not used yet prepares it for allocations
+  arena_get_bin_by_reg_size(req->arena, idx_to_size(req->idx[1]))
+      ->min_regions = val;
+  return 0;
+}
+
+static int ctl_conf_ro(ctl_req_t *req) {
+  unsigned val;
+  conf_get(&req->arena->conf, req->leaf, &val);
+  return ctl_read_unsigned(req, val);
+}
+
+static int ctl_conf_rw(ctl_req_t *req) {
+  arena_t *arena = req->arena;
+  unsigned old, val;
+  bool written;
+  conf_get(&arena->conf, req->leaf, &old);
+  int ret = ctl_rw_unsigned(req, old, &val, &written);
+  if (ret != 0 || !written) return ret;
+  if (!conf_set(&arena->conf, req->leaf, val)) return EINVAL;
+  if (strcmp(req->leaf, "bin_min_regions") == 0) {
+    for (unsigned i = 0; i < ARENA_NO_BINS; i++) {
+      if (arena->bins[i].reg_size != 0)
+        arena->bins[i].min_regions = arena->conf.bin_min_regions;
+    }
+  } else if (strcmp(req->leaf, "prof_interval") == 0) {
+    prof_set_interval(&arena->prof, arena->conf.prof_interval);
+  } else {
+    arena_apply_chunk_conf(arena);
+  }
+  return 0;
+}
+
+static int ctl_arena_nbins(ctl_req_t *req) {
+  return ctl_read_unsigned(req, ARENA_NO_BINS);
+}
+
+static int ctl_arena_nchunks(ctl_req_t *req) {
+  unsigned cnt = 0;
+  for (ll_entry_t *e = req->arena->chunk_list.ll; e != NULL; e = e->link.fd)
+    cnt++;
+  return ctl_read_unsigned(req, cnt);
+}
+
+static int ctl_arena_decommit(ctl_req_t *req) {
+  size_t released;
+  int ret;
+  if (req->newp != NULL) return EPERM;
+  // Validate before doing any work
+  if ((ret = ctl_check_old(req, sizeof(released))) != 0) return ret;
+  released = arena_decommit(req->arena);
+  return ctl_read(req, &released, sizeof(released));
+}
+
+// Optional new value is path overriding SEALLOC_PROF_FILE
+static int ctl_prof_dump(ctl_req_t *req) {
+  const char *path = req->arena->prof.path;
+  if (req->oldp != NULL || req->oldlenp != NULL) return EPERM;
+  if (req->newp != NULL) {
+    if (req->newlen != sizeof(path)) return EINVAL;
+    memcpy(&path, req->newp, sizeof(path));
+    if (path == NULL) return EINVAL;
+  }
+  return prof_dump(req->arena, path) ? 0 : EIO;
+}
+
+static int ctl_prof_nsamples(ctl_req_t *req) {
+  size_t nlive = req->arena->prof.nlive;
+  if (req->newp != NULL) return EPERM;
+  return ctl_read(req, &nlive, sizeof(nlive));
+}
+
+static const ctl_node_t ctl_prof_nodes[] = {
+    CTL_LEAF("dump", ctl_prof_dump),
+    CTL_LEAF("nsamples", ctl_prof_nsamples),
+};
+
+#ifdef STATISTICS
+// Optional new value is path overriding the configured dump file
+static int ctl_hist_dump(ctl_req_t *req) {
+  const char *path = req->arena->hist_path;
+  if (req->oldp != NULL || req->oldlenp != NULL) return EPERM;
+  if (req->newp != NULL) {
+    if (req->newlen != sizeof(path)) return EINVAL;
+    memcpy(&path, req->newp, sizeof(path));
+    if (path == NULL) return EINVAL;
+  }
+  return hist_dump(&req->arena->hist, path) ? 0 : EIO;
+}
+
+static const ctl_node_t ctl_hist_nodes[] = {
+    CTL_LEAF("dump", ctl_hist_dump),
+};
+#endif
+
+#ifdef LATENCY
+// Optional new value is path overriding the configured dump file
+static int ctl_latency_dump(ctl_req_t *req) {
+  const char *path = req->arena->latency_path;
+  if (req->oldp != NULL || req->oldlenp != NULL) return EPERM;
+  if (req->newp != NULL) {
+    if (req->newlen != sizeof(path)) return EINVAL;
+    memcpy(&path, req->newp, sizeof(path));
+    if (path == NULL) return EINVAL;
+  }
+  return lat_dump(&req->arena->latency, path) ? 0 : EIO;
+}
+
+// Drops counts so far, e.g. of warm-up
+static int ctl_latency_reset(ctl_req_t *req) {
+  if (req->oldp != NULL || req->oldlenp != NULL || req->newp != NULL)
+    return EPERM;
+  lat_init(&req->arena->latency);
+  return 0;
+}
+
+static const ctl_node_t ctl_latency_nodes[] = {
+    CTL_LEAF("dump", ctl_latency_dump),
+    CTL_LEAF("reset", ctl_latency_reset),
+};
+#endif
+
+static const ctl_node_t ctl_bin_nodes[] = {
+    CTL_LEAF("reg_size", ctl_bin_reg_size),
+    CTL_LEAF("run_size", ctl_bin_run_size),
+    CTL_LEAF("avail_regs", ctl_bin_avail_regs),
+    CTL_LEAF("nruns", ctl_bin_nruns),
+    CTL_LEAF("min_regions", ctl_bin_min_regions),
+};
+
+static const ctl_node_t ctl_bins_nodes[] = {
+    CTL_INDEX(ARENA_NO_BINS, ctl_bin_nodes),
+};
+
+static const ctl_node_t ctl_conf_nodes[] = {
+    CTL_LEAF("bin_min_regions", ctl_conf_rw),
+    CTL_LEAF("chunks_per_mapping", ctl_conf_rw),
+    CTL_LEAF("run_size_small", ctl_conf_ro),
+    CTL_LEAF("run_size_medium", ctl_conf_ro),
+    CTL_LEAF("random_lookup_tries", ctl_conf_rw),
+    CTL_LEAF("random_lookup_threshold", ctl_conf_rw),
+    CTL_LEAF("chunk_unmap_threshold", ctl_conf_rw),
+    CTL_LEAF("prof_interval", ctl_conf_rw),
+};
+
+static const ctl_node_t ctl_arena_nodes[] = {
+    CTL_LEAF("nbins", ctl_arena_nbins),
+    CTL_LEAF("nchunks", ctl_arena_nchunks),
+    CTL_LEAF("decommit", ctl_arena_decommit),
+    CTL_INNER("conf", ctl_conf_nodes),
+    CTL_INNER("bins", ctl_bins_nodes),
+    CTL_INNER("prof", ctl_prof_nodes),
+#ifdef STATISTICS
+    CTL_INNER("hist", ctl_hist_nodes),
+#endif
+#ifdef LATENCY
+    CTL_INNER("latency", ctl_latency_nodes),
+#endif
+};
+
+// Only the default arena has an index
+static const ctl_node_t ctl_arenas_nodes[] = {
+    CTL_INDEX(1, ctl_arena_nodes),
+};
+
+static const ctl_node_t ctl_root_nodes[] = {
+    CTL_INNER("arena", ctl_arenas_nodes),
+};
+
+static const ctl_node_t *ctl_find(const ctl_node_t *nodes, size_t nnodes,
+                                  const char *comp, size_t len,
+                                  ctl_req_t *req, unsigned *nidx) {
+  uint64_t val = 0;
+  if (len == 0) return NULL;
+  if (nodes[0].name == NULL) {
+    for (size_t i = 0; i < len; i++) {
+      if (comp[i] < '0' || comp[i] > '9') return NULL;
+      val = val * 10 + (uint64_t)(comp[i] - '0');
+      if (val >= nodes[0].nindices) return NULL;
+    }
+    if (*nidx >= CTL_MAX_INDICES) return NULL;
+    req->idx[(*nidx)++] = (unsigned)val;
+    return &nodes[0];
+  }
+  for (size_t i = 0; i < nnodes; i++) {
+    if (strncmp(nodes[i].name, comp, len) == 0 && nodes[i].name[len] == '\0')
+      return &nodes[i];
+  }
+  return NULL;
+}
+
+int ctl_by_name(arena_t *arena, const char *name, void *oldp, size_t *oldlenp,
+                const void *newp, size_t newlen) {
+  ctl_req_t req = {.arena = arena,
+                   .idx = {0},
+                   .leaf = NULL,
+                   .oldp = oldp,
+                   .oldlenp = oldlenp,
+                   .newp = newp,
+                   .newlen = newlen};
+  const ctl_node_t *nodes = ctl_root_nodes, *node = NULL;
+  size_t nnodes = sizeof(ctl_root_nodes) / sizeof(ctl_root_nodes[0]);
+  unsigned nidx = 0;
+  const char *end;
+  if (name == NULL) return ENOENT;
+  for (;;) {
+    if (nnodes == 0) return ENOENT;
+    end = strchr(name, '.');
+    node = ctl_find(nodes, nnodes, name, end == NULL ? strlen(name)
+                                                     : (size_t)(end - name),
+                    &req, &nidx);
+    if (node == NULL) return ENOENT;
+    if (end == NULL) break;
+    nodes = node->children;
+    nnodes = node->nchildren;
+    name = end + 1;
+  }
+  if (node->handler == NULL) return ENOENT;
+  req.leaf = node->name;
+  return node->handler(&req);
+}
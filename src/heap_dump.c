@@ -0,0 +1,136 @@
+#include "sealloc/heap_dump.h"
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sealloc/bin.h"
+#include "sealloc/chunk.h"
+#include "sealloc/container_ll.h"
+#include "sealloc/run.h"
+#include "sealloc/size_class.h"
+#include "sealloc/utils.h"
+
+// Region states are packed into buffer of this size before being written
+#define HEAP_DUMP_STATES_BUF 256
+
+static size_t heap_dump_pad(size_t len) { return (len + 7) & ~(size_t)7; }
+
+static bool heap_dump_write(int fd, const void *buf, size_t len) {
+  const char *ptr = buf;
+  ssize_t ret;
+  while (len > 0) {
+    ret = write(fd, ptr, len);
+    if (ret < 0 && errno == EINTR) continue;
+    if (ret <= 0) return false;
+    ptr += ret;
+    len -= (size_t)ret;
+  }
+  return true;
+}
+
+static bool heap_dump_record(int fd, heap_dump_type_t type, size_t len) {
+  heap_dump_record_t rec = {.type = type, .len = (uint32_t)heap_dump_pad(len)};
+  return heap_dump_write(fd, &rec, sizeof(rec));
+}
+
+// Pads payload of len bytes
+static bool heap_dump_finish(int fd, size_t len) {
+  static const uint8_t zeros[8];
+  return heap_dump_write(fd, zeros, heap_dump_pad(len) - len);
+}
+
+static bool heap_dump_header(arena_t *arena, int fd) {
+  heap_dump_header_t header;
+  struct timespec ts;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, HEAP_DUMP_MAGIC, sizeof(HEAP_DUMP_MAGIC));
+  clock_gettime(CLOCK_REALTIME, &ts);
+  header.version = HEAP_DUMP_FORMAT_VERSION;
+  header.pid = (uint32_t)getpid();
+  header.timestamp =
+      (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+  header.page_size = PAGE_SIZE;
+  header.chunk_size = CHUNK_SIZE_BYTES;
+  header.leaf_size = CHUNK_LEAST_REGION_SIZE_BYTES;
+  header.tree_depth = CHUNK_BUDDY_TREE_DEPTH;
+  header.chunks_left = arena->chunks_left;
+  return heap_dump_write(fd, &header, sizeof(header));
+}
+
+static bool heap_dump_chunk(const chunk_t *chunk, int fd) {
+  heap_dump_chunk_t payload = {.addr = (uintptr_t)chunk->entry.key};
+  size_t len = sizeof(payload) + sizeof(chunk->buddy_tree) +
+               sizeof(chunk->reg_size_small_medium);
+  return heap_dump_record(fd, HEAP_DUMP_CHUNK, len) &&
+         heap_dump_write(fd, &payload, sizeof(payload)) &&
+         heap_dump_write(fd, chunk->buddy_tree, sizeof(chunk->buddy_tree)) &&
+         heap_dump_write(fd, chunk->reg_size_small_medium,
+                         sizeof(chunk->reg_size_small_medium)) &&
+         heap_dump_finish(fd, len);
+}
+
+static bool heap_dump_run(const run_t *run, const bin_t *bin, bool retired,
+                          int fd) {
+  uint8_t states[HEAP_DUMP_STATES_BUF];
+  heap_dump_run_t payload = {.addr = (uintptr_t)run->entry.key,
+                             .reg_size = bin->reg_size,
+                             .nregs = bin->reg_mask_size_bits / 2,
+                             .run_size = bin->run_size_pages * PAGE_SIZE,
+                             .retired = retired};
+  size_t len = sizeof(payload) + (payload.nregs + 3) / 4;
+  size_t pos = 0;
+  if (!heap_dump_record(fd, HEAP_DUMP_RUN, len) ||
+      !heap_dump_write(fd, &payload, sizeof(payload)))
+    return false;
+  memset(states, 0, sizeof(states));
+  for (size_t i = 0; i < payload.nregs; i++) {
+    states[pos] |=
+        (uint8_t)(run_get_region_state(run, bin, i) << (2 * (i % 4)));
+    if (i % 4 == 3 && ++pos == sizeof(states)) {
+      if (!heap_dump_write(fd, states, pos)) return false;
+      memset(states, 0, sizeof(states));
+      pos = 0;
+    }
+  }
+  if (payload.nregs % 4 != 0) pos++;
+  return heap_dump_write(fd, states, pos) && heap_dump_finish(fd, len);
+}
+
+static bool heap_dump_runs(const bin_t *bin, const ll_entry_t *entry,
+                           bool retired, int fd) {
+  for (; entry != NULL; entry = entry->link.fd) {
+    if (!heap_dump_run(CONTAINER_OF(entry, run_t, entry), bin, retired, fd))
+      return false;
+  }
+  return true;
+}
+
+static bool heap_dump_huge(const huge_chunk_t *huge, int fd) {
+  heap_dump_huge_t payload = {.addr = (uintptr_t)huge->entry.key,
+                              .len = huge->len};
+  return heap_dump_record(fd, HEAP_DUMP_HUGE, sizeof(payload)) &&
+         heap_dump_write(fd, &payload, sizeof(payload));
+}
+
+bool heap_dump(arena_t *arena, int fd) {
+  const bin_t *bin;
+  if (!heap_dump_header(arena, fd)) return false;
+  for (ll_entry_t *e = arena->chunk_list.ll; e != NULL; e = e->link.fd) {
+    if (!heap_dump_chunk(CONTAINER_OF(e, chunk_t, entry), fd)) return false;
+  }
+  for (unsigned i = 0; i < ARENA_NO_BINS; i++) {
+    bin = &arena->bins[i];
+    // Large regions have no run metadata, chunks mark them
+    if (bin->reg_size == 0 || IS_SIZE_LARGE(bin->reg_size)) continue;
+    if (!heap_dump_runs(bin, bin->run_list_active.ll, false, fd) ||
+        !heap_dump_runs(bin, bin->run_list_inactive.ll, true, fd))
+      return false;
+  }
+  for (ll_entry_t *e = arena->huge_alloc_list.ll; e != NULL; e = e->link.fd) {
+    if (!heap_dump_huge(CONTAINER_OF(e, huge_chunk_t, entry), fd))
+      return false;
+  }
+  return heap_dump_record(fd, HEAP_DUMP_END, 0);
+}
@@ -0,0 +1,63 @@
+#include "sealloc/histogram.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "sealloc/logging.h"
+#include "sealloc/size_class.h"
+
+static const char *hist_class_names[HIST_NO_CLASSES] = {"small", "medium",
+                                                         "large", "huge"};
+
+void hist_init(alloc_hist_t *hist) { memset(hist, 0, sizeof(*hist)); }
+
+hist_class_t hist_class(size_t size) {
+  // Zero sized requests are served with smallest region
+  if (size == 0 || IS_SIZE_SMALL(size)) return HIST_CLASS_SMALL;
+  if (IS_SIZE_MEDIUM(size)) return HIST_CLASS_MEDIUM;
+  if (IS_SIZE_LARGE(size)) return HIST_CLASS_LARGE;
+  return HIST_CLASS_HUGE;
+}
+
+unsigned hist_bucket(size_t size) {
+  if (size == 0) return 0;
+  return 64 - (unsigned)__builtin_clzll((unsigned long long)size);
+}
+
+void hist_record(alloc_hist_t *hist, size_t size) {
+  hist_class_t class = hist_class(size);
+  __atomic_fetch_add(&hist->class_count[class], 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&hist->class_bytes[class], size, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&hist->bucket_count[hist_bucket(size)], 1,
+                     __ATOMIC_RELAXED);
+}
+
+static size_t hist_load(const uint64_t *counter) {
+  return (size_t)__atomic_load_n(counter, __ATOMIC_RELAXED);
+}
+
+void hist_write_json(const alloc_hist_t *hist, int fd) {
+  fse_log(fd, "{\"version\":%u,\"pid\":%u,\"classes\":{", HIST_FORMAT_VERSION,
+          (unsigned)getpid());
+  for (unsigned i = 0; i < HIST_NO_CLASSES; i++) {
+    fse_log(fd, "%s\"%s\":{\"count\":%zu,\"bytes\":%zu}", i == 0 ? "" : ",",
+            hist_class_names[i], hist_load(&hist->class_count[i]),
+            hist_load(&hist->class_bytes[i]));
+  }
+  fse_log(fd, "},\"log2_buckets\":[");
+  for (unsigned i = 0; i < HIST_NO_BUCKETS; i++) {
+    fse_log(fd, "%s%zu", i == 0 ? "" : ",", hist_load(&hist->bucket_count[i]));
+  }
+  fse_log(fd, "]}\n");
+}
+
+bool hist_dump(const alloc_hist_t *hist, const char *path) {
+  int perms = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
+  int fd = open(path, O_WRONLY | O_APPEND | O_CREAT, perms);
+  if (fd < 0) return false;
+  hist_write_json(hist, fd);
+  close(fd);
+  return true;
+}
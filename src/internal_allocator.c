@@ -218,8 +218,8 @@ void *internal_alloc(int_alloc_t *root, size_t size) {
   return NULL;
 }
 
-// Free the chunk pointed by ptr
-void internal_free(int_alloc_t *root, void *ptr) {
+// Find used node of the chunk pointed by ptr, fills in its size
+static size_t find_used_node(int_alloc_t *root, void *ptr, size_t *size) {
   size_t idx = 1, cur_size = INTERNAL_ALLOC_CHUNK_SIZE_BYTES;
   uintptr_t ptr_cur, ptr_dest = (uintptr_t)ptr;
   ia_node_t state;
@@ -248,6 +248,14 @@ void internal_free(int_alloc_t *root, void *ptr) {
     }
     state = get_tree_item(root->buddy_tree, idx);
   }
+  *size = cur_size;
+  return idx;
+}
+
+// Free the chunk pointed by ptr
+void internal_free(int_alloc_t *root, void *ptr) {
+  size_t cur_size;
+  size_t idx = find_used_node(root, ptr, &cur_size);
 
   // Mark the node free
   set_tree_item(root->buddy_tree, idx, NODE_FREE);
@@ -258,3 +266,23 @@ void internal_free(int_alloc_t *root, void *ptr) {
   // Second phase, go up and coalesce free nodes
   coalesce_free_nodes(root->buddy_tree, idx);
 }
+
+// Shrink the chunk pointed by ptr to the smallest node holding size bytes
+void internal_shrink(int_alloc_t *root, void *ptr, size_t size) {
+  size_t cur_size;
+  size_t idx = find_used_node(root, ptr, &cur_size);
+  const size_t used_idx = idx;
+
+  // Chunk keeps the left child, right child becomes free
+  while (!IS_LEAF(idx) && size <= cur_size / 2) {
+    set_tree_item(root->buddy_tree, idx, NODE_SPLIT);
+    set_tree_item(root->buddy_tree, RIGHT_CHILD(idx), NODE_FREE);
+    idx = LEFT_CHILD(idx);
+    set_tree_item(root->buddy_tree, idx, NODE_USED);
+    cur_size /= 2;
+    root->free_mem += cur_size;
+  }
+
+  // Nodes above might have been full, now they have free space
+  if (idx != used_idx) mark_nodes_split(root->buddy_tree, PARENT(used_idx));
+}
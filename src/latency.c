@@ -0,0 +1,74 @@
+#include "sealloc/latency.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "sealloc/logging.h"
+
+static const char *lat_phase_names[LAT_NO_PHASES] = {
+    "malloc_size_class",    "malloc_supply_runs", "malloc_run_select",
+    "malloc_region_select", "free_locate",        "free_release",
+    "morecore",             "chunk_init"};
+
+static uint64_t lat_clock_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+uint64_t lat_bucket_lower(unsigned bucket) {
+  unsigned group = bucket / LAT_SUB_BUCKETS;
+  uint64_t sub = bucket % LAT_SUB_BUCKETS;
+  if (group == 0) return sub;
+  return (LAT_SUB_BUCKETS + sub) << (group - 1);
+}
+
+void lat_init(lat_hist_t *hist) {
+  memset(hist, 0, sizeof(*hist));
+  hist->start_ns = lat_clock_ns();
+  hist->start_ticks = lat_now();
+}
+
+// Ticks per second measured since initialization, 0 if too early to tell
+static size_t lat_ticks_per_sec(const lat_hist_t *hist) {
+  uint64_t ticks = lat_now() - hist->start_ticks;
+  uint64_t ns = lat_clock_ns() - hist->start_ns;
+  if (ns == 0) return 0;
+  return (size_t)((double)ticks * 1e9 / (double)ns);
+}
+
+void lat_write_json(const lat_hist_t *hist, int fd) {
+  fse_log(fd, "{\"version\":%u,\"pid\":%u,\"ticks_per_sec\":%zu,\"phases\":{",
+          LAT_FORMAT_VERSION, (unsigned)getpid(), lat_ticks_per_sec(hist));
+  for (unsigned i = 0; i < LAT_NO_PHASES; i++) {
+    size_t total = 0;
+    bool first = true;
+    fse_log(fd, "%s\"%s\":{\"buckets\":[", i == 0 ? "" : ",",
+            lat_phase_names[i]);
+    for (unsigned k = 0; k < LAT_NO_BUCKETS; k++) {
+      size_t cnt =
+          (size_t)__atomic_load_n(&hist->count[i][k], __ATOMIC_RELAXED);
+      if (cnt == 0) continue;
+      fse_log(fd, "%s[%zu,%zu]", first ? "" : ",",
+              (size_t)lat_bucket_lower(k), cnt);
+      total += cnt;
+      first = false;
+    }
+    fse_log(fd, "],\"count\":%zu}", total);
+  }
+  fse_log(fd, "}}\n");
+}
+
+bool lat_dump(const lat_hist_t *hist, const char *path) {
+  int perms = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
+  int fd = open(path, O_WRONLY | O_APPEND | O_CREAT, perms);
+  if (fd < 0) return false;
+  // Document takes many writes, children inheriting LD_PRELOAD dump as well
+  flock(fd, LOCK_EX);
+  lat_write_json(hist, fd);
+  close(fd);
+  return true;
+}
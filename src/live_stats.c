@@ -0,0 +1,117 @@
+#include "sealloc/live_stats.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sealloc/logging.h"
+
+static uint64_t live_clock(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void live_stats_init(live_stats_t *live) {
+  memset(live, 0, sizeof(*live));
+}
+
+void live_stats_path(unsigned pid, char *buf) {
+  snprintf(buf, LIVE_PATH_MAX, "%s%u", LIVE_PATH_PREFIX, pid);
+}
+
+// Creates segment of current process and publishes first snapshot
+static bool live_stats_create(live_stats_t *live, arena_t *arena) {
+  int perms = S_IRUSR | S_IWUSR;
+  live_segment_t *seg;
+  int fd;
+  if (live->shared) perms |= S_IRGRP | S_IROTH;
+  live_stats_path((unsigned)getpid(), live->path);
+  // Path is predictable, so file left by a dead process with the same pid is
+  // removed and only a file created here is used, never one planted by others
+  unlink(live->path);
+  fd = open(live->path, O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC,
+            perms);
+  if (fd < 0) return false;
+  if (ftruncate(fd, sizeof(live_segment_t)) != 0) {
+    close(fd);
+    unlink(live->path);
+    return false;
+  }
+  seg = mmap(NULL, sizeof(live_segment_t), PROT_READ | PROT_WRITE, MAP_SHARED,
+             fd, 0);
+  // Mapping keeps the file referenced
+  close(fd);
+  if (seg == MAP_FAILED) {
+    unlink(live->path);
+    return false;
+  }
+  memcpy(seg->magic, LIVE_MAGIC, sizeof(seg->magic));
+  seg->size = sizeof(live_segment_t);
+  seg->pid = (uint32_t)getpid();
+  seg->interval_ms = (uint32_t)(live->interval_ns / 1000000ULL);
+  live->seg = seg;
+  live_stats_publish(live, arena);
+  // Readers check version last, so they never see a half-initialized segment
+  __atomic_store_n(&seg->version, LIVE_FORMAT_VERSION, __ATOMIC_RELEASE);
+  return true;
+}
+
+bool live_stats_open(live_stats_t *live, arena_t *arena, unsigned interval_ms,
+                     bool shared) {
+  live_stats_init(live);
+  live->interval_ns = (uint64_t)interval_ms * 1000000ULL;
+  live->shared = shared;
+  return live_stats_create(live, arena);
+}
+
+void live_stats_publish(live_stats_t *live, arena_t *arena) {
+  live_segment_t *seg = live->seg;
+  arena_stats_t stats;
+  uint64_t seq = __atomic_load_n(&seg->seq, __ATOMIC_RELAXED);
+  // Walk happens outside of the write section, so readers retry less often
+  stats_collect(arena, &stats);
+  live->last = live_clock();
+  live->nops = 0;
+  __atomic_store_n(&seg->seq, seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  memcpy(&seg->stats, &stats, sizeof(stats));
+  seg->timestamp = live->last;
+  seg->nallocs = live->nallocs;
+  seg->nfrees = live->nfrees;
+  __atomic_store_n(&seg->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+void live_stats_check(live_stats_t *live, arena_t *arena) {
+  live->nops = 0;
+  if (live->seg == NULL) {
+    // Detached in forked child, which got this far without exec
+    if (!live_stats_create(live, arena)) {
+      se_log("Couldn't create %s to publish statistics to\n", live->path);
+      arena->live = NULL;
+    }
+    return;
+  }
+  if (live_clock() - live->last >= live->interval_ns)
+    live_stats_publish(live, arena);
+}
+
+void live_stats_close(live_stats_t *live) {
+  if (live->seg == NULL) return;
+  munmap(live->seg, sizeof(live_segment_t));
+  unlink(live->path);
+  live_stats_init(live);
+}
+
+void live_stats_detach(live_stats_t *live) {
+  uint64_t interval_ns = live->interval_ns;
+  bool shared = live->shared;
+  if (live->seg != NULL) munmap(live->seg, sizeof(live_segment_t));
+  live_stats_init(live);
+  live->interval_ns = interval_ns;
+  live->shared = shared;
+}
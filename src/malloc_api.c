@@ -1,35 +1,162 @@
+#include <errno.h>
+#include <limits.h>
+#include <malloc.h>
+#include <pthread.h>
 #include <sealloc_api.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "sealloc/arena.h"
+#include "sealloc/ctl.h"
+#include "sealloc/heap_dump.h"
+#include "sealloc/latency.h"
+#include "sealloc/live_stats.h"
 #include "sealloc/logging.h"
+#include "sealloc/platform_api.h"
+#include "sealloc/prof.h"
 #include "sealloc/sealloc.h"
 #include "sealloc/size_class.h"
+#include "sealloc/stats.h"
+#include "sealloc/trace.h"
 
 // Main arena object
 static arena_t arena;
 
 #ifdef STATISTICS
-#include <unistd.h>
-__attribute__((destructor)) void close_stats_file(void) {
-  if (arena.is_initialized != 0 && arena.stats_fd >= 0) close(arena.stats_fd);
+#include <signal.h>
+
+static void dump_stats(void) {
+  if (!hist_dump(&arena.hist, arena.hist_path))
+    se_log("Couldn't open %s to write heap statistics to\n", arena.hist_path);
+}
+
+static void dump_stats_on_signal(int sig) {
+  (void)sig;
+  dump_stats();
 }
 
-void log_allocation(size_t size) {
-  char *class;
-  if (IS_SIZE_SMALL(size))
-    class = "S";
-  else if (IS_SIZE_MEDIUM(size))
-    class = "M";
-  else if (IS_SIZE_LARGE(size))
-    class = "L";
-  else {
-    class = "H";
+__attribute__((constructor)) static void setup_stats(void) {
+  struct sigaction act;
+  const char *sig_str;
+  if (arena.is_initialized == 0) {
+    arena_init(&arena);
   }
-  if (arena.stats_fd >= 0) fse_log(arena.stats_fd, "%s %zu\n", class, size);
+  sig_str = getenv(HIST_ENV_SIGNAL);
+  if (sig_str == NULL) return;
+  memset(&act, 0, sizeof(act));
+  act.sa_handler = dump_stats_on_signal;
+  act.sa_flags = SA_RESTART;
+  sigemptyset(&act.sa_mask);
+  if (sigaction((int)str2u32(sig_str), &act, NULL) != 0)
+    se_log("Couldn't install heap statistics handler for signal %s\n",
+           sig_str);
+}
+
+__attribute__((destructor)) static void dump_stats_at_exit(void) {
+  if (arena.is_initialized != 0) dump_stats();
+}
+
+static void log_allocation(size_t size) { hist_record(&arena.hist, size); }
+#endif
+
+#ifdef LATENCY
+__attribute__((destructor)) static void dump_latency_at_exit(void) {
+  if (arena.is_initialized == 0) return;
+  if (!lat_dump(&arena.latency, arena.latency_path))
+    se_log("Couldn't open %s to write latency histograms to\n",
+           arena.latency_path);
 }
 #endif
 
+// Profile is written only if anything was sampled
+__attribute__((destructor)) static void dump_prof_at_exit(void) {
+  if (arena.is_initialized == 0 || arena.prof.nsamples == 0) return;
+  if (!prof_dump(&arena, arena.prof.path))
+    se_log("Couldn't open %s to write heap profile to\n", arena.prof.path);
+}
+
+static void open_trace(void) {
+  char path[PATH_MAX];
+  const char *prefix = getenv(TRACE_ENV_PATH);
+  if (prefix == NULL) return;
+  // Every process writes its own file, children of shells would clobber it
+  snprintf(path, sizeof(path), "%s.%u", prefix, (unsigned)getpid());
+  if (!trace_open(&arena.trace, path))
+    se_log("Couldn't open %s to write allocation trace to\n", path);
+}
+
+static void reopen_trace_in_child(void) {
+  trace_detach(&arena.trace);
+  open_trace();
+}
+
+// Calls made before constructors run are not traced
+__attribute__((constructor)) static void setup_trace(void) {
+  if (getenv(TRACE_ENV_PATH) == NULL) return;
+  if (arena.is_initialized == 0) {
+    arena_init(&arena);
+  }
+  open_trace();
+  pthread_atfork(NULL, NULL, reopen_trace_in_child);
+}
+
+__attribute__((destructor)) static void close_trace_at_exit(void) {
+  trace_close(&arena.trace);
+}
+
+static live_stats_t live_stats;
+
+static void open_live_stats(void) {
+  const char *interval = getenv(LIVE_ENV);
+  if (interval == NULL) return;
+  bool shared = getenv(LIVE_ENV_SHARED) != NULL;
+  if (live_stats_open(&live_stats, &arena, str2u32(interval), shared))
+    arena.live = &live_stats;
+  else
+    se_log("Couldn't create %s to publish statistics to\n", live_stats.path);
+}
+
+// Child publishes under its own pid, segment of the parent stays in place
+static void detach_live_stats_in_child(void) {
+  if (arena.live != NULL) live_stats_detach(&live_stats);
+}
+
+__attribute__((constructor)) static void setup_live_stats(void) {
+  if (getenv(LIVE_ENV) == NULL) return;
+  if (arena.is_initialized == 0) {
+    arena_init(&arena);
+  }
+  open_live_stats();
+  pthread_atfork(NULL, NULL, detach_live_stats_in_child);
+}
+
+// Readers still attached see the final snapshot
+__attribute__((destructor)) static void close_live_stats_at_exit(void) {
+  if (arena.live == NULL) return;
+  arena.live = NULL;
+  if (live_stats.seg != NULL) live_stats_publish(&live_stats, &arena);
+  live_stats_close(&live_stats);
+}
+
+// Feeds API call to the trace and to published statistics
+static inline void trace_call(trace_op_t op, const void *id, size_t size,
+                              uint64_t arg) {
+  if (trace_is_open(&arena.trace))
+    trace_record(&arena.trace, op, id, size, arg);
+  live_stats_tick(arena.live, &arena, op == TRACE_OP_FREE);
+}
+
+arena_t *sealloc_default_arena(void) {
+  if (arena.is_initialized == 0) {
+    arena_init(&arena);
+  }
+  return &arena;
+}
+
 void *malloc(size_t size) {
   if (arena.is_initialized == 0) {
     arena_init(&arena);
@@ -37,15 +164,23 @@ void *malloc(size_t size) {
 #ifdef STATISTICS
   log_allocation(size);
 #endif
-#ifdef DEBUG
   void *ret = sealloc_malloc(&arena, size);
   se_debug("Returning pointer: %p", ret);
+  trace_call(TRACE_OP_MALLOC, ret, size, 0);
   return ret;
-#else
-  return sealloc_malloc(&arena, size);
-#endif
 }
-void free(void *ptr) { sealloc_free(&arena, ptr); }
+void free(void *ptr) {
+  sealloc_free(&arena, ptr);
+  if (ptr != NULL) trace_call(TRACE_OP_FREE, ptr, 0, 0);
+}
+void free_sized(void *ptr, size_t size) {
+  sealloc_free_sized(&arena, ptr, size);
+  if (ptr != NULL) trace_call(TRACE_OP_FREE, ptr, size, 0);
+}
+void free_aligned_sized(void *ptr, size_t alignment, size_t size) {
+  sealloc_free_aligned_sized(&arena, ptr, alignment, size);
+  if (ptr != NULL) trace_call(TRACE_OP_FREE, ptr, size, alignment);
+}
 void *calloc(size_t nmemb, size_t size) {
   if (arena.is_initialized == 0) {
     arena_init(&arena);
@@ -54,14 +189,11 @@ void *calloc(size_t nmemb, size_t size) {
 #ifdef STATISTICS
   log_allocation(nmemb * size);
 #endif
-#ifdef DEBUG
   se_debug("Allocating size: nmemb=%zu size=%zu", nmemb, size);
   void *ret = sealloc_calloc(&arena, nmemb, size);
   se_debug("Returning pointer: %p", ret);
+  trace_call(TRACE_OP_CALLOC, ret, size, nmemb);
   return ret;
-#else
-  return sealloc_calloc(&arena, nmemb, size);
-#endif
 }
 void *realloc(void *ptr, size_t size) {
   if (arena.is_initialized == 0) {
@@ -71,11 +203,264 @@ void *realloc(void *ptr, size_t size) {
 #ifdef STATISTICS
   log_allocation(size);
 #endif
-#ifdef DEBUG
   void *ret = sealloc_realloc(&arena, ptr, size);
   se_debug("Returning pointer: %p", ret);
+  trace_call(TRACE_OP_REALLOC, ret, size, (uintptr_t)ptr);
+  return ret;
+}
+static inline int is_pow2(size_t n) { return n != 0 && (n & (n - 1)) == 0; }
+
+static void *aligned_malloc(size_t alignment, size_t size) {
+  if (arena.is_initialized == 0) {
+    arena_init(&arena);
+  }
+#ifdef STATISTICS
+  log_allocation(size);
+#endif
+  void *ret = sealloc_aligned_alloc(&arena, alignment, size);
+  se_debug("Returning pointer: %p", ret);
+  trace_call(TRACE_OP_ALIGNED, ret, size, alignment);
+  if (ret == NULL) errno = ENOMEM;
   return ret;
-#else
-  return sealloc_realloc(&arena, ptr, size);
+}
+int posix_memalign(void **memptr, size_t alignment, size_t size) {
+  if (!is_pow2(alignment) || alignment % sizeof(void *) != 0) return EINVAL;
+  void *ret = aligned_malloc(alignment, size);
+  if (ret == NULL) return ENOMEM;
+  *memptr = ret;
+  return 0;
+}
+void *aligned_alloc(size_t alignment, size_t size) {
+  if (!is_pow2(alignment)) {
+    errno = EINVAL;
+    return NULL;
+  }
+  return aligned_malloc(alignment, size);
+}
+void *memalign(size_t alignment, size_t size) {
+  // Like glibc, round alignment up to the next power of 2
+  if (alignment > SIZE_MAX / 2 + 1) {
+    errno = EINVAL;
+    return NULL;
+  }
+  size_t a = 1;
+  while (a < alignment) a <<= 1;
+  return aligned_malloc(a, size);
+}
+void *valloc(size_t size) { return aligned_malloc(PAGE_SIZE, size); }
+void *pvalloc(size_t size) {
+  if (size > SIZE_MAX - PAGE_SIZE) {
+    errno = ENOMEM;
+    return NULL;
+  }
+  return aligned_malloc(PAGE_SIZE, size == 0 ? PAGE_SIZE : ALIGNUP_PAGE(size));
+}
+size_t malloc_usable_size(void *ptr) {
+  if (arena.is_initialized == 0) return 0;
+  return sealloc_usable_size(&arena, ptr);
+}
+size_t sealloc_nallocx(size_t size) { return sealloc_round_size(size); }
+struct mallinfo2 mallinfo2(void) {
+  struct mallinfo2 info;
+  arena_stats_t stats;
+  memset(&info, 0, sizeof(info));
+  if (arena.is_initialized == 0) return info;
+  stats_collect(&arena, &stats);
+  info.arena = stats.chunk_mapped_bytes;
+  for (unsigned i = 0; i < ARENA_NO_BINS; i++)
+    info.ordblks += stats.bins[i].nregs_avail;
+  info.hblks = stats.nhuge;
+  info.hblkhd = stats.huge_bytes;
+  info.uordblks = stats.small_bytes + stats.medium_bytes + stats.large_bytes;
+  info.fordblks = info.arena - info.uordblks;
+  // What malloc_trim() would give back
+  info.keepcost = stats.chunk_depleted_bytes + stats.chunk_cached_bytes;
+  return info;
+}
+int malloc_trim(size_t pad) {
+  // There is no heap top, so there is nothing to keep padding for
+  (void)pad;
+  if (arena.is_initialized == 0) return 0;
+  return arena_trim(&arena) > 0;
+}
+int malloc_info(int options, FILE *fp) {
+  arena_stats_t stats;
+  if (options != 0) {
+    errno = EINVAL;
+    return -1;
+  }
+  if (arena.is_initialized == 0) {
+    arena_init(&arena);
+  }
+  stats_collect(&arena, &stats);
+  stats_write_xml(&stats, fp);
+  return 0;
+}
+size_t sealloc_try_expand(void *ptr, size_t min_size, size_t max_size) {
+  if (arena.is_initialized == 0) {
+    arena_init(&arena);
+  }
+  return sealloc_expand_in_place(&arena, ptr, min_size, max_size);
+}
+int sealloc_ctl(const char *name, void *oldp, size_t *oldlenp, void *newp,
+                size_t newlen) {
+  if (arena.is_initialized == 0) {
+    arena_init(&arena);
+  }
+  return ctl_by_name(&arena, name, oldp, oldlenp, newp, newlen);
+}
+_Static_assert(SEALLOC_STATS_NBINS == ARENA_NO_BINS, "Bin count mismatch");
+_Static_assert(SEALLOC_STATS_NORDERS == CHUNK_BUDDY_TREE_DEPTH + 1,
+               "Buddy order count mismatch");
+
+static void copy_chunk_stats(const chunk_usage_t *usage,
+                             struct sealloc_chunk_stats *out) {
+  for (unsigned i = 0; i < SEALLOC_STATS_NORDERS; i++)
+    out->nruns[i] = usage->nruns[i];
+  out->run_bytes = usage->run_bytes;
+  out->depleted_bytes = usage->depleted_bytes;
+  out->unmapped_bytes = usage->unmapped_bytes;
+}
+
+void sealloc_stats_get(struct sealloc_stats *out) {
+  arena_stats_t stats;
+  const bin_stats_t *bin;
+  if (arena.is_initialized == 0) {
+    arena_init(&arena);
+  }
+  stats_collect(&arena, &stats);
+  memset(out, 0, sizeof(*out));
+  for (unsigned i = 0; i < SEALLOC_STATS_NBINS; i++) {
+    bin = &stats.bins[i];
+    out->bins[i] = (struct sealloc_bin_stats){
+        .reg_size = bin->reg_size,
+        .run_size = bin->run_size,
+        .nallocs = bin->nallocs,
+        .nfrees = bin->nfrees,
+        .nruns_active = bin->nruns_active,
+        .nruns_inactive = bin->nruns_inactive,
+        .nruns_released = bin->nruns_released,
+        .avail_regs = bin->nregs_avail,
+        .live_regs = bin->nregs_live,
+        .lost_regs = bin->nregs_freed};
+  }
+  out->nchunks = stats.nchunks;
+  for (unsigned i = 0; i < SEALLOC_STATS_NORDERS; i++) {
+    out->chunks.nruns[i] = stats.chunk_nruns[i];
+    out->chunks.run_bytes +=
+        stats.chunk_nruns[i] * (CHUNK_LEAST_REGION_SIZE_BYTES << i);
+  }
+  out->chunks.depleted_bytes = stats.chunk_depleted_bytes;
+  out->chunks.unmapped_bytes = stats.chunk_unmapped_bytes;
+  out->chunk_cached_bytes = stats.chunk_cached_bytes;
+  out->nhuge = stats.nhuge;
+  out->huge_bytes = stats.huge_bytes;
+  out->metadata_mapped_bytes = stats.internal_mapped_bytes;
+  out->metadata_used_bytes = stats.internal_used_bytes;
+  out->mapped_bytes = stats.mapped_bytes;
+  out->guard_bytes = stats.guard_bytes;
+  out->nvmas = stats.nvmas;
+  out->nmap_calls = stats.platform.nmap;
+  out->nprobe_calls = stats.platform.nprobe;
+  out->nprobe_retries = stats.platform.nprobe_retry;
+  out->nunmap_calls = stats.platform.nunmap;
+  out->nguard_calls = stats.platform.nguard;
+  out->nunguard_calls = stats.platform.nunguard;
+  out->nexpand_calls = stats.platform.nexpand;
+}
+
+int sealloc_stats_get_chunk(size_t idx, struct sealloc_chunk_stats *out) {
+  chunk_usage_t usage;
+  if (arena.is_initialized == 0) {
+    arena_init(&arena);
+  }
+  if (!stats_collect_chunk(&arena, idx, &usage)) return ENOENT;
+  copy_chunk_stats(&usage, out);
+  return 0;
+}
+
+int sealloc_stats_write_json(FILE *fp) {
+  arena_stats_t stats;
+  if (fp == NULL) return EINVAL;
+  if (arena.is_initialized == 0) {
+    arena_init(&arena);
+  }
+  stats_collect(&arena, &stats);
+  stats_write_json(&arena, &stats, fp);
+  return 0;
+}
+
+int sealloc_dump_heap(int fd) {
+  if (fd < 0) return EINVAL;
+  if (arena.is_initialized == 0) {
+    arena_init(&arena);
+  }
+  return heap_dump(&arena, fd) ? 0 : EIO;
+}
+size_t sealloc_malloc_batch(size_t size, size_t n, void **out) {
+  if (arena.is_initialized == 0) {
+    arena_init(&arena);
+  }
+#ifdef STATISTICS
+  for (size_t i = 0; i < n; i++) log_allocation(size);
 #endif
+  size_t cnt = sealloc_batch_malloc(&arena, size, n, out);
+  for (size_t i = 0; i < cnt; i++) trace_call(TRACE_OP_MALLOC, out[i], size, 0);
+  return cnt;
+}
+void sealloc_free_batch(void **ptrs, size_t n) {
+  sealloc_batch_free(&arena, ptrs, n);
+  for (size_t i = 0; i < n; i++) {
+    if (ptrs[i] != NULL) trace_call(TRACE_OP_FREE, ptrs[i], 0, 0);
+  }
+}
+sealloc_arena_t *sealloc_arena_create(void) {
+  arena_t *new_arena;
+  // Arena lives in its own mapping, so it is released together with its memory
+  if (platform_map(NULL, ALIGNUP_PAGE(sizeof(arena_t)), (void **)&new_arena) !=
+      PLATFORM_STATUS_OK)
+    return NULL;
+  new_arena->is_initialized = 0;
+  arena_init(new_arena);
+  return new_arena;
+}
+void *sealloc_arena_malloc(sealloc_arena_t *a, size_t size) {
+  return sealloc_malloc(a, size);
+}
+void sealloc_arena_free(sealloc_arena_t *a, void *ptr) {
+  sealloc_free(a, ptr);
+}
+void *sealloc_arena_aligned_alloc(sealloc_arena_t *a, size_t alignment,
+                                  size_t size) {
+  if (!is_pow2(alignment)) return NULL;
+  return sealloc_aligned_alloc(a, alignment, size);
+}
+void sealloc_arena_free_aligned_sized(sealloc_arena_t *a, void *ptr,
+                                      size_t alignment, size_t size) {
+  sealloc_free_aligned_sized(a, ptr, alignment, size);
+}
+void sealloc_arena_destroy(sealloc_arena_t *a) {
+  platform_status_code_t code;
+  if (a == NULL) return;
+  arena_destroy(a);
+  if ((code = platform_unmap(a, ALIGNUP_PAGE(sizeof(arena_t)))) !=
+      PLATFORM_STATUS_OK) {
+    se_error("Failed to unmap arena: %s", platform_strerror(code));
+  }
+}
+sealloc_pool_t *sealloc_pool_create(size_t obj_size, size_t align) {
+  if (arena.is_initialized == 0) {
+    arena_init(&arena);
+  }
+  return sealloc_create_pool(&arena, obj_size, align);
+}
+void *sealloc_pool_alloc(sealloc_pool_t *pool) {
+  return sealloc_malloc_from_pool(pool);
+}
+void sealloc_pool_free(sealloc_pool_t *pool, void *ptr) {
+  sealloc_free_to_pool(pool, ptr);
+}
+void sealloc_pool_destroy(sealloc_pool_t *pool) {
+  if (pool == NULL) return;
+  sealloc_destroy_pool(pool);
 }
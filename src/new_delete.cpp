@@ -0,0 +1,160 @@
+// Replaceable C++ allocation functions backed by the default arena
+
+#include <sealloc/sealloc_export.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+extern "C" {
+#include "sealloc/live_stats.h"
+#include "sealloc/sealloc.h"
+#include "sealloc/trace.h"
+}
+
+namespace {
+
+// Feeds call to the trace and to published statistics
+void trace(trace_op_t op, const void *ptr, std::size_t size,
+           std::uint64_t arg) {
+  arena_t *arena = sealloc_default_arena();
+  if (trace_is_open(&arena->trace))
+    trace_record(&arena->trace, op, ptr, size, arg);
+  live_stats_tick(arena->live, arena, op == TRACE_OP_FREE);
+}
+
+// Same failure handling as required from the default operator new
+void *allocate(std::size_t size) {
+  void *ptr;
+#ifdef STATISTICS
+  hist_record(&sealloc_default_arena()->hist, size);
+#endif
+  while ((ptr = sealloc_malloc(sealloc_default_arena(), size)) == nullptr) {
+    std::new_handler handler = std::get_new_handler();
+    if (handler == nullptr) throw std::bad_alloc();
+    handler();
+  }
+  trace(TRACE_OP_MALLOC, ptr, size, 0);
+  return ptr;
+}
+
+void *allocate_aligned(std::size_t size, std::align_val_t alignment) {
+  void *ptr;
+#ifdef STATISTICS
+  hist_record(&sealloc_default_arena()->hist, size);
+#endif
+  while ((ptr = sealloc_aligned_alloc(sealloc_default_arena(),
+                                     static_cast<std::size_t>(alignment),
+                                     size)) == nullptr) {
+    std::new_handler handler = std::get_new_handler();
+    if (handler == nullptr) throw std::bad_alloc();
+    handler();
+  }
+  trace(TRACE_OP_ALIGNED, ptr, size, static_cast<std::size_t>(alignment));
+  return ptr;
+}
+
+void *allocate_nothrow(std::size_t size) noexcept {
+  try {
+    return allocate(size);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void *allocate_aligned_nothrow(std::size_t size,
+                               std::align_val_t alignment) noexcept {
+  try {
+    return allocate_aligned(size, alignment);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void deallocate(void *ptr) noexcept {
+  if (ptr == nullptr) return;
+  sealloc_free(sealloc_default_arena(), ptr);
+  trace(TRACE_OP_FREE, ptr, 0, 0);
+}
+
+// Size selects the bin directly, no chunk walk is needed
+void deallocate_sized(void *ptr, std::size_t size) noexcept {
+  if (ptr == nullptr) return;
+  sealloc_free_sized(sealloc_default_arena(), ptr, size);
+  trace(TRACE_OP_FREE, ptr, size, 0);
+}
+
+void deallocate_aligned_sized(void *ptr, std::size_t size,
+                              std::align_val_t alignment) noexcept {
+  if (ptr == nullptr) return;
+  sealloc_free_aligned_sized(sealloc_default_arena(), ptr,
+                             static_cast<std::size_t>(alignment), size);
+  trace(TRACE_OP_FREE, ptr, size, static_cast<std::size_t>(alignment));
+}
+
+}  // namespace
+
+SEALLOC_EXPORT void *operator new(std::size_t size) { return allocate(size); }
+SEALLOC_EXPORT void *operator new[](std::size_t size) { return allocate(size); }
+SEALLOC_EXPORT void *operator new(std::size_t size,
+                                  const std::nothrow_t &) noexcept {
+  return allocate_nothrow(size);
+}
+SEALLOC_EXPORT void *operator new[](std::size_t size,
+                                    const std::nothrow_t &) noexcept {
+  return allocate_nothrow(size);
+}
+SEALLOC_EXPORT void *operator new(std::size_t size, std::align_val_t al) {
+  return allocate_aligned(size, al);
+}
+SEALLOC_EXPORT void *operator new[](std::size_t size, std::align_val_t al) {
+  return allocate_aligned(size, al);
+}
+SEALLOC_EXPORT void *operator new(std::size_t size, std::align_val_t al,
+                                  const std::nothrow_t &) noexcept {
+  return allocate_aligned_nothrow(size, al);
+}
+SEALLOC_EXPORT void *operator new[](std::size_t size, std::align_val_t al,
+                                    const std::nothrow_t &) noexcept {
+  return allocate_aligned_nothrow(size, al);
+}
+
+SEALLOC_EXPORT void operator delete(void *ptr) noexcept { deallocate(ptr); }
+SEALLOC_EXPORT void operator delete[](void *ptr) noexcept { deallocate(ptr); }
+SEALLOC_EXPORT void operator delete(void *ptr,
+                                    const std::nothrow_t &) noexcept {
+  deallocate(ptr);
+}
+SEALLOC_EXPORT void operator delete[](void *ptr,
+                                      const std::nothrow_t &) noexcept {
+  deallocate(ptr);
+}
+SEALLOC_EXPORT void operator delete(void *ptr, std::size_t size) noexcept {
+  deallocate_sized(ptr, size);
+}
+SEALLOC_EXPORT void operator delete[](void *ptr, std::size_t size) noexcept {
+  deallocate_sized(ptr, size);
+}
+// Aligned allocations above a page are mappings, full lookup finds them too
+SEALLOC_EXPORT void operator delete(void *ptr, std::align_val_t) noexcept {
+  deallocate(ptr);
+}
+SEALLOC_EXPORT void operator delete[](void *ptr, std::align_val_t) noexcept {
+  deallocate(ptr);
+}
+SEALLOC_EXPORT void operator delete(void *ptr, std::align_val_t,
+                                    const std::nothrow_t &) noexcept {
+  deallocate(ptr);
+}
+SEALLOC_EXPORT void operator delete[](void *ptr, std::align_val_t,
+                                      const std::nothrow_t &) noexcept {
+  deallocate(ptr);
+}
+SEALLOC_EXPORT void operator delete(void *ptr, std::size_t size,
+                                    std::align_val_t al) noexcept {
+  deallocate_aligned_sized(ptr, size, al);
+}
+SEALLOC_EXPORT void operator delete[](void *ptr, std::size_t size,
+                                      std::align_val_t al) noexcept {
+  deallocate_aligned_sized(ptr, size, al);
+}
@@ -1,8 +1,12 @@
+// mremap() is a GNU extension
+#define _GNU_SOURCE
+
 #include <assert.h>
 #include <stddef.h>
 
 #include "sealloc/logging.h"
 #include "sealloc/platform_api.h"
+#include "sealloc/probes.h"
 #include "sealloc/utils.h"
 
 #ifdef __linux__
@@ -40,10 +44,15 @@ __attribute__((constructor)) void init_aarch64(void) {
   }
 }
 
-#elif
+#else
 static int additional_prot_flags = 0;
 #endif
 
+// Allocator is single threaded, plain increments are enough
+static platform_counters_t counters;
+
+void platform_get_counters(platform_counters_t *out) { *out = counters; }
+
 static platform_status_code_t get_error_from_errno(void) {
   switch (errno) {
     case EINVAL:
@@ -75,6 +84,7 @@ const char *platform_strerror(platform_status_code_t code) {
 
 platform_status_code_t platform_map(void *hint, size_t len, void **result) {
   assert(len > 0);
+  counters.nmap++;
   void *map = mmap(hint, len, PROT_READ | PROT_WRITE | additional_prot_flags,
                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
   if (map == MAP_FAILED) return get_error_from_errno();
@@ -93,16 +103,24 @@ platform_status_code_t platform_get_program_break(void **result) {
 }
 platform_status_code_t platform_map_probe(volatile uintptr_t *probe, uintptr_t ceiling,
                                           size_t len) {
+  return platform_map_probe_aligned(probe, ceiling, len, PAGE_SIZE);
+}
+
+platform_status_code_t platform_map_probe_aligned(volatile uintptr_t *probe,
+                                                  uintptr_t ceiling, size_t len,
+                                                  size_t alignment) {
   assert(len > 0);
   assert(IS_ALIGNED(len, PAGE_SIZE));
   assert(IS_ALIGNED(*probe, PAGE_SIZE));
+  assert(alignment >= PAGE_SIZE && (alignment & (alignment - 1)) == 0);
   void *map = NULL;
-  uintptr_t new_probe = *probe;
+  uintptr_t new_probe = ALIGNUP(*probe, alignment);
 
   if (new_probe >= ceiling) {
     return PLATFORM_STATUS_CEILING_HIT;
   }
   while (map == NULL) {
+    counters.nprobe++;
     map = mmap((void *)new_probe, len,
                PROT_READ | PROT_WRITE | additional_prot_flags,
                MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
@@ -112,7 +130,8 @@ platform_status_code_t platform_map_probe(volatile uintptr_t *probe, uintptr_t c
       if (errno == EEXIST) {
         /* We hit a mapping, try incrementing probe */
         se_debug("Existing mapping hit");
-        new_probe += PAGE_SIZE;
+        counters.nprobe_retry++;
+        new_probe += alignment;
         if (new_probe >= ceiling) {
           return PLATFORM_STATUS_CEILING_HIT;
         }
@@ -134,14 +153,35 @@ platform_status_code_t platform_map_probe(volatile uintptr_t *probe, uintptr_t c
 platform_status_code_t platform_unmap(void *ptr, size_t len) {
   assert(len > 0);
   se_debug("Unmapping (ptr : %p, len : %zu)", ptr, len);
+  se_probe2(unmap, ptr, len);
+  counters.nunmap++;
   if (munmap(ptr, len) == 0) {
     return PLATFORM_STATUS_OK;
   }
   return get_error_from_errno();
 }
+platform_status_code_t platform_expand_in_place(void *ptr, size_t len,
+                                                size_t new_len, size_t gap) {
+  assert(len < new_len);
+  assert(IS_ALIGNED(new_len, PAGE_SIZE));
+  assert(IS_ALIGNED(gap, PAGE_SIZE));
+  counters.nexpand++;
+  // Without MREMAP_MAYMOVE kernel fails if the range after mapping is taken
+  if (mremap(ptr, len, new_len + gap, 0) == MAP_FAILED)
+    return get_error_from_errno();
+  se_debug("Expanded mapping (ptr : %p, len : %zu, new_len : %zu)", ptr, len,
+           new_len);
+  if (gap > 0 && munmap((char *)ptr + new_len, gap) != 0) {
+    platform_status_code_t code = get_error_from_errno();
+    munmap((char *)ptr + len, new_len + gap - len);
+    return code;
+  }
+  return PLATFORM_STATUS_OK;
+}
 platform_status_code_t platform_guard(void *ptr, size_t len) {
   assert(len > 0);
   se_debug("Guarding (ptr : %p, len : %zu)", ptr, len);
+  counters.nguard++;
   if (mprotect(ptr, len, PROT_NONE) == 0) {
     return PLATFORM_STATUS_OK;
   }
@@ -150,6 +190,7 @@ platform_status_code_t platform_guard(void *ptr, size_t len) {
 platform_status_code_t platform_unguard(void *ptr, size_t len) {
   assert(len > 0);
   se_debug("Unguarding (ptr : %p, len : %zu)", ptr, len);
+  counters.nunguard++;
   if (mprotect(ptr, len, PROT_READ | PROT_WRITE) == 0) {
     return PLATFORM_STATUS_OK;
   }
@@ -0,0 +1,46 @@
+#include "sealloc/pool.h"
+
+#include <assert.h>
+
+#include "sealloc/utils.h"
+
+#if __aarch64__ && __ARM_FEATURE_MEMORY_TAGGING
+#include "sealloc/arch/aarch64.h"
+#endif
+
+unsigned pool_reg_size(size_t obj_size, size_t align) {
+  if (align == 0) align = POOL_MIN_OBJ_SIZE;
+  if ((align & (align - 1)) != 0 || align > PAGE_SIZE) return 0;
+  if (obj_size == 0 || obj_size > POOL_MAX_OBJ_SIZE) return 0;
+#if __aarch64__ && __ARM_FEATURE_MEMORY_TAGGING
+  // Regions are tagged by whole granules
+  if (align < MEMORY_GRANULE_SIZE) align = MEMORY_GRANULE_SIZE;
+#endif
+  if (obj_size < POOL_MIN_OBJ_SIZE) obj_size = POOL_MIN_OBJ_SIZE;
+  // Runs are page aligned, so stride being multiple of align is enough
+  size_t reg_size = ALIGNUP(obj_size, align);
+  if (reg_size > POOL_MAX_OBJ_SIZE) return 0;
+  return (unsigned)reg_size;
+}
+
+unsigned pool_run_size_pages(unsigned reg_size) {
+  assert(POOL_MIN_OBJ_SIZE <= reg_size && reg_size <= POOL_MAX_OBJ_SIZE);
+  unsigned run_size, nregs, waste;
+  // Chunk hands out power of 2 multiples of its least region size only
+  for (run_size = CHUNK_LEAST_REGION_SIZE_BYTES;
+       run_size < POOL_RUN_SIZE_MAX_BYTES; run_size *= 2) {
+    nregs = run_size / reg_size;
+    waste = run_size - nregs * reg_size;
+    if (nregs >= POOL_MIN_REGIONS_PER_RUN &&
+        waste <= (run_size >> POOL_MAX_WASTE_SHIFT))
+      break;
+  }
+  return run_size / PAGE_SIZE;
+}
+
+void pool_init(pool_t *pool, arena_t *arena, unsigned reg_size) {
+  assert(arena->is_initialized == 1);
+  bin_init_pool(&pool->bin, reg_size, pool_run_size_pages(reg_size));
+  pool->bin.min_regions = arena->conf.bin_min_regions;
+  pool->arena = arena;
+}
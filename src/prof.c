@@ -0,0 +1,238 @@
+#include "sealloc/prof.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if !defined(__x86_64__) && !defined(__aarch64__)
+#include <unwind.h>
+#endif
+
+#include "sealloc/arena.h"
+#include "sealloc/chunk.h"
+#include "sealloc/container_ll.h"
+#include "sealloc/logging.h"
+#include "sealloc/run.h"
+#include "sealloc/sealloc.h"
+#include "sealloc/utils.h"
+
+#if __aarch64__ && __ARM_FEATURE_MEMORY_TAGGING
+#include "sealloc/arch/aarch64.h"
+#endif
+
+// Return address into prof_sample()
+#define PROF_SKIP_FRAMES 1
+
+// Biggest distance between frame records trusted by frame pointer walk
+#define PROF_MAX_FRAME_BYTES (1 << 20)
+
+#define PROF_LN2 0.6931471805599453
+
+// Size of buffer used to copy process memory map
+#define PROF_MAPS_BUFSIZE 4096
+
+// xorshift64*, period 2^64 - 1, state must not be 0
+static uint64_t prof_random(prof_t *prof) {
+  uint64_t x = prof->rng;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  prof->rng = x;
+  return x * UINT64_C(0x2545F4914F6CDD1D);
+}
+
+// Natural logarithm of x >= 1, accurate to about 1e-6, libm is not linked
+static double prof_ln(uint64_t x) {
+  unsigned exp = 63 - (unsigned)__builtin_clzll(x);
+  double m = (double)x / (double)(UINT64_C(1) << exp);
+  // ln(m) = 2 atanh(z), z < 1/3 for m in [1, 2)
+  double z = (m - 1) / (m + 1), z2 = z * z;
+  double atanh = z * (1 + z2 * (1.0 / 3 + z2 * (1.0 / 5 + z2 * (1.0 / 7 +
+                                                                 z2 / 9))));
+  return exp * PROF_LN2 + 2 * atanh;
+}
+
+// Exponentially distributed distance to next sample with mean interval
+static int64_t prof_next_distance(prof_t *prof) {
+  uint64_t r = (prof_random(prof) >> 11) + 1;  // Uniform in [1, 2^53]
+  // -ln(r / 2^53)
+  double dist = (53 * PROF_LN2 - prof_ln(r)) * prof->interval;
+  return (int64_t)dist + 1;
+}
+
+void prof_init(prof_t *prof, unsigned interval, uint64_t seed) {
+  prof->rng = seed != 0 ? seed : 1;
+  prof->nlive = 0;
+  prof->nsamples = 0;
+  prof->sampled_bytes = 0;
+  prof->path = PROF_DEFAULT_PATH;
+  for (unsigned i = 0; i < PROF_TABLE_SIZE; i++) ll_init(&prof->table[i]);
+  prof->spare = NULL;
+  prof_set_interval(prof, interval);
+}
+
+void prof_set_interval(prof_t *prof, unsigned interval) {
+  prof->interval = interval;
+  prof->bytes_left = interval == 0 ? INT64_MAX : prof_next_distance(prof);
+}
+
+static ll_head_t *prof_bucket(prof_t *prof, const void *ptr) {
+  // Regions are at least 16 bytes apart
+  uint64_t h = ((uintptr_t)ptr >> 4) * UINT64_C(0x9E3779B97F4A7C15);
+  return &prof->table[h >> 56 & (PROF_TABLE_SIZE - 1)];
+}
+
+#if defined(__x86_64__) || defined(__aarch64__)
+// Frame record pointed to by frame pointer, same on x86-64 and aarch64
+typedef struct prof_frame {
+  const struct prof_frame *next;
+  void *ret;
+} prof_frame_t;
+
+// Code built without frame pointers leaves anything in the register, so the
+// chain is followed only while it goes up the stack in sane steps
+static bool prof_frame_valid(const prof_frame_t *frame,
+                             const prof_frame_t *next) {
+  return next > frame &&
+         (uintptr_t)next - (uintptr_t)frame <= PROF_MAX_FRAME_BYTES &&
+         IS_ALIGNED((uintptr_t)next, sizeof(void *));
+}
+
+// Walks frame pointers, DWARF unwinding costs more than the rest of sampling
+__attribute__((noinline)) static void prof_backtrace(prof_sample_t *sample) {
+  const prof_frame_t *frame = __builtin_frame_address(0);
+  unsigned skip = PROF_SKIP_FRAMES;
+  sample->nframes = 0;
+  while (sample->nframes < PROF_MAX_FRAMES && frame->ret != NULL) {
+    if (skip > 0)
+      skip--;
+    else
+      sample->frames[sample->nframes++] = frame->ret;
+    if (!prof_frame_valid(frame, frame->next)) break;
+    frame = frame->next;
+  }
+}
+#else
+typedef struct prof_unwind {
+  prof_sample_t *sample;
+  unsigned skip;
+} prof_unwind_t;
+
+static _Unwind_Reason_Code prof_unwind_frame(struct _Unwind_Context *ctx,
+                                             void *arg) {
+  prof_unwind_t *uw = arg;
+  uintptr_t ip = _Unwind_GetIP(ctx);
+  if (ip == 0) return _URC_END_OF_STACK;
+  if (uw->skip > 0) {
+    uw->skip--;
+    return _URC_NO_REASON;
+  }
+  uw->sample->frames[uw->sample->nframes++] = (void *)ip;
+  if (uw->sample->nframes == PROF_MAX_FRAMES) return _URC_END_OF_STACK;
+  return _URC_NO_REASON;
+}
+
+// Unwinder starts in prof_backtrace() itself
+__attribute__((noinline)) static void prof_backtrace(prof_sample_t *sample) {
+  prof_unwind_t uw = {.sample = sample, .skip = PROF_SKIP_FRAMES + 1};
+  sample->nframes = 0;
+  _Unwind_Backtrace(prof_unwind_frame, &uw);
+}
+#endif
+
+__attribute__((noinline)) void prof_sample(arena_t *arena, void *ptr,
+                                           size_t size) {
+  prof_t *prof = &arena->prof;
+  prof_sample_t *sample;
+  chunk_t *chunk;
+  run_t *run;
+  bin_t *bin;
+  huge_chunk_t *huge;
+  prof->bytes_left =
+      prof->interval == 0 ? INT64_MAX : prof_next_distance(prof);
+#if __aarch64__ && __ARM_FEATURE_MEMORY_TAGGING
+  if (is_mte_enabled) ptr = PTR_CLEAR_TAG(ptr);
+#endif
+  chunk = arena_get_chunk_from_ptr(arena, ptr, NULL);
+  if (chunk != NULL) {
+    chunk_mark_sampled(chunk, ptr);
+    // Sized free knows the run but not the chunk, so the run is marked too
+    if (locate_metadata_for_ptr(arena, ptr, &chunk, &run, &bin, &huge) ==
+        METADATA_REGULAR)
+      run->sampled = 1;
+  } else {
+    huge = arena_find_huge_mapping(arena, ptr);
+    if (huge == NULL) return;
+    huge->sampled = true;
+  }
+  // Internal allocator costs more than the rest of sampling
+  if (prof->spare != NULL) {
+    sample = CONTAINER_OF(prof->spare, prof_sample_t, entry);
+    prof->spare = prof->spare->link.fd;
+  } else {
+    sample = arena_internal_alloc(arena, sizeof(prof_sample_t));
+  }
+  sample->entry.link.fd = NULL;
+  sample->entry.link.bk = NULL;
+  sample->entry.key = ptr;
+  sample->size = size;
+  prof_backtrace(sample);
+  ll_add(prof_bucket(prof, ptr), &sample->entry);
+  prof->nlive++;
+  prof->nsamples++;
+  prof->sampled_bytes += size;
+}
+
+bool prof_forget(arena_t *arena, const void *ptr) {
+  prof_t *prof = &arena->prof;
+  ll_head_t *bucket = prof_bucket(prof, ptr);
+  ll_entry_t *entry = ll_find(bucket, ptr);
+  if (entry == NULL) return false;
+  ll_del(bucket, entry);
+  entry->link.fd = prof->spare;
+  prof->spare = entry;
+  prof->nlive--;
+  return true;
+}
+
+static void prof_write_maps(int fd) {
+  char buf[PROF_MAPS_BUFSIZE];
+  ssize_t len;
+  int maps = open("/proc/self/maps", O_RDONLY);
+  if (maps < 0) return;
+  while ((len = read(maps, buf, sizeof(buf))) > 0) write(fd, buf, (size_t)len);
+  close(maps);
+}
+
+void prof_write(const arena_t *arena, int fd) {
+  const prof_t *prof = &arena->prof;
+  const prof_sample_t *sample;
+  size_t live_bytes = 0;
+  for (unsigned i = 0; i < PROF_TABLE_SIZE; i++) {
+    for (ll_entry_t *e = prof->table[i].ll; e != NULL; e = e->link.fd)
+      live_bytes += CONTAINER_OF(e, prof_sample_t, entry)->size;
+  }
+  // heap_v2 tells pprof to scale samples back by the sampling interval
+  fse_log(fd, "heap profile: %zu: %zu [%zu: %zu] @ heap_v2/%u\n", prof->nlive,
+          live_bytes, prof->nsamples, prof->sampled_bytes, prof->interval);
+  for (unsigned i = 0; i < PROF_TABLE_SIZE; i++) {
+    for (ll_entry_t *e = prof->table[i].ll; e != NULL; e = e->link.fd) {
+      sample = CONTAINER_OF(e, prof_sample_t, entry);
+      fse_log(fd, "1: %zu [1: %zu] @", sample->size, sample->size);
+      for (unsigned k = 0; k < sample->nframes; k++)
+        fse_log(fd, " %p", sample->frames[k]);
+      fse_log(fd, "\n");
+    }
+  }
+  fse_log(fd, "\nMAPPED_LIBRARIES:\n");
+  prof_write_maps(fd);
+}
+
+bool prof_dump(const arena_t *arena, const char *path) {
+  int perms = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
+  int fd = open(path, O_WRONLY | O_TRUNC | O_CREAT, perms);
+  if (fd < 0) return false;
+  prof_write(arena, fd);
+  close(fd);
+  return true;
+}
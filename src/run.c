@@ -5,6 +5,7 @@
 #include <string.h>
 
 #include "sealloc/bin.h"
+#include "sealloc/bitset.h"
 #include "sealloc/generator.h"
 #include "sealloc/logging.h"
 #include "sealloc/random.h"
@@ -89,22 +90,66 @@ static inline uint64_t add_to_excludes(const uint64_t tagged_ptr,
 
 #endif
 
-// Get state of a region from bitmap
-static inline bstate_t get_bitmap_item(uint8_t *mem, size_t idx) {
-  size_t word = idx / 4;
-  size_t off = idx % 4;
-  return (bstate_t)(mem[word] >> (2 * off) & 3);
+// Bitset of regions that were ever allocated
+static inline uint64_t *alloc_set(run_t *run) { return run->reg_bitmap; }
+
+// Bitset of regions that were freed
+static inline uint64_t *freed_set(run_t *run, bin_t *bin) {
+  return run->reg_bitmap + run_bitset_words(bin);
 }
 
-// Set region state inside a bitmap
-static inline void set_bitmap_item(uint8_t *mem, size_t idx, bstate_t state) {
-  size_t word = idx / 4;
-  size_t off = idx % 4;
-  uint8_t erase_bits = 3;  // 0b11
-  // First, clear the bits we want to set in mem[word]
-  // Second, set two state bits in their place
-  mem[word] =
-      (mem[word] & ~(erase_bits << (off * 2))) | ((uint8_t)state << (off * 2));
+// Bitset of live regions in compact descriptor
+static inline uint64_t *live_set(run_t *run) { return run->reg_bitmap; }
+
+static inline bool is_region_live(run_t *run, bin_t *bin, size_t idx) {
+  if (run->gen == RUN_GEN_COMPACT) return bitset_get(live_set(run), idx);
+  return bitset_get(alloc_set(run), idx) &&
+         !bitset_get(freed_set(run, bin), idx);
+}
+
+size_t run_bitset_words(const bin_t *bin) {
+  return BITSET_WORDS(bin->reg_mask_size_bits / 2);
+}
+
+size_t run_metadata_size(const bin_t *bin) {
+  return sizeof(run_t) + 2 * run_bitset_words(bin) * sizeof(uint64_t);
+}
+
+size_t run_compact_metadata_size(const bin_t *bin) {
+  return sizeof(run_t) + run_bitset_words(bin) * sizeof(uint64_t);
+}
+
+void run_compact(run_t *run, const bin_t *bin) {
+  assert(run->navail == 0);
+  assert(run->gen != RUN_GEN_COMPACT);
+  size_t words = run_bitset_words(bin);
+  // Live bitset overwrites allocated bitset word by word
+  uint64_t *alloc = run->reg_bitmap;
+  const uint64_t *freed = run->reg_bitmap + words;
+  run->gen = RUN_GEN_COMPACT;
+  run->current_idx = 0;
+  for (size_t i = 0; i < words; i++) alloc[i] &= ~freed[i];
+}
+
+bool run_is_compact(const run_t *run) { return run->gen == RUN_GEN_COMPACT; }
+
+// Random generator of cyclic group Z_n, any number coprime with n will do
+static unsigned random_coprime(unsigned n) {
+  unsigned gen;
+  if (n <= 2) return 1;
+  do {
+    gen = 1 + splitmix32() % (n - 1);
+  } while (gcd(gen, n) != 1);
+  return gen;
+}
+
+// True if run size of the bin was not changed by SEALLOC_CONF
+static bool run_has_default_size(const bin_t *bin) {
+  if (IS_SIZE_SMALL(bin->reg_size))
+    return bin->run_size_pages == RUN_SIZE_SMALL_PAGES;
+  if (IS_SIZE_MEDIUM(bin->reg_size))
+    return bin->run_size_pages == RUN_SIZE_MEDIUM_PAGES;
+  return true;
 }
 
 void run_init(run_t *run, bin_t *bin, void *heap) {
@@ -112,11 +157,19 @@ void run_init(run_t *run, bin_t *bin, void *heap) {
   run->entry.key = heap;
   run->entry.link.fd = NULL;
   run->entry.link.bk = NULL;
+  run->bin = bin;
   run->navail = bin->reg_mask_size_bits / 2;
   run->nfreed = 0;
+  run->sampled = 0;
 
   // Choose a generator
-  if (IS_SIZE_SMALL(bin->reg_size)) {
+  if (bin->is_pool) {
+    // Pool sizes are arbitrary, so there is no precomputed table
+    run->gen = random_coprime(bin->reg_mask_size_bits / 2);
+  } else if (!run_has_default_size(bin)) {
+    // Tables are computed for region counts of default run sizes
+    run->gen = random_coprime(bin->reg_mask_size_bits / 2);
+  } else if (IS_SIZE_SMALL(bin->reg_size)) {
     gen_idx = SIZE_TO_IDX_SMALL(bin->reg_size);
     run->gen = GENERATORS_SMALL[gen_idx][splitmix32() %
                                          GENERATORS_SMALL_LENGTHS[gen_idx]];
@@ -132,7 +185,7 @@ void run_init(run_t *run, bin_t *bin, void *heap) {
   run->current_idx = splitmix32() % (bin->reg_mask_size_bits / 2);
 
   // Prepare bitmap, mark everything as free
-  memset(run->reg_bitmap, 0x0, BITS2BYTES_CEIL(bin->reg_mask_size_bits));
+  memset(run->reg_bitmap, 0x0, 2 * run_bitset_words(bin) * sizeof(uint64_t));
 }
 
 // Allocate region from run
@@ -142,26 +195,30 @@ void *run_allocate(run_t *run, bin_t *bin) {
 
   uintptr_t heap = (uintptr_t)run->entry.key;
   unsigned elems = (unsigned)(bin->reg_mask_size_bits / 2);
+  unsigned next_idx;
   void *ptr;
 
-  // Get next item from generator
-  run->current_idx = (run->gen + run->current_idx) % elems;
+  // Get next item from generator, both gen and current_idx are below elems so
+  // a single subtraction is enough to wrap around
+  next_idx = run->gen + run->current_idx;
+  if (next_idx >= elems) next_idx -= elems;
+  run->current_idx = next_idx;
 
   // Sanity check
-  bstate_t state;
-  if ((state = get_bitmap_item(run->reg_bitmap, run->current_idx)) !=
-      STATE_FREE) {
+  if (bitset_get(alloc_set(run), run->current_idx)) {
     se_error(
         "Region is not free, Region(heap=%p, nfree=%u, gen=%u, "
         "current_idx=%u), state=%u",
-        run->entry.key, run->navail, run->gen, run->current_idx, state);
+        run->entry.key, run->navail, run->gen, run->current_idx,
+        run_get_region_state(run, bin, run->current_idx));
   }
 
   // Mark region as allocated
-  set_bitmap_item(run->reg_bitmap, run->current_idx, STATE_ALLOC);
+  bitset_set(alloc_set(run), run->current_idx);
 
   // Decrese amount of free regions
   run->navail--;
+  bin->nallocs++;
   se_debug("Allocating region at current_idx %u, next is %u", run->current_idx,
            (run->gen + run->current_idx) % elems);
   ptr = (void *)(heap + (run->current_idx * bin->reg_size));
@@ -173,13 +230,13 @@ void *run_allocate(run_t *run, bin_t *bin) {
   // Always keep tag 0 in excludes
   uint64_t excludes = 1, nptr;
   if (run->current_idx > 0 &&
-      get_bitmap_item(run->reg_bitmap, run->current_idx - 1) == STATE_ALLOC) {
+      is_region_live(run, bin, run->current_idx - 1)) {
     nptr = get_tag_from_memory((uint64_t)ptr - bin->reg_size);
     excludes = add_to_excludes(nptr, excludes);
   }
 
   if (run->current_idx < ((bin->reg_mask_size_bits / 2) - 1) &&
-      get_bitmap_item(run->reg_bitmap, run->current_idx + 1) == STATE_ALLOC) {
+      is_region_live(run, bin, run->current_idx + 1)) {
     nptr = get_tag_from_memory((uint64_t)ptr + bin->reg_size);
     excludes = add_to_excludes(nptr, excludes);
   }
@@ -200,16 +257,22 @@ size_t run_validate_ptr(run_t *run, bin_t *bin, void *ptr) {
   }
 #endif
   // Here, we trust that ptr is in range of current run
-  ptrdiff_t rel_ptr = (uintptr_t)ptr - (uintptr_t)run->entry.key;
-  size_t bitmap_idx = rel_ptr / bin->reg_size;
+  uint64_t rel_ptr = (uintptr_t)ptr - (uintptr_t)run->entry.key;
+  // Divide by reg_size using its reciprocal, see bin_init()
+  size_t bitmap_idx = (rel_ptr * bin->reg_size_magic) >> 32;
   // Check if ptr is unaligned
-  if (rel_ptr % bin->reg_size != 0) {
+  if (bitmap_idx * bin->reg_size != rel_ptr) {
     se_debug("Unaligned ptr (ptr=%p)", ptr);
     return SIZE_MAX;
   }
+  // Check if ptr points to the unused tail of the run
+  if (bitmap_idx >= bin->reg_mask_size_bits / 2) {
+    se_debug("Ptr past last region (ptr=%p)", ptr);
+    return SIZE_MAX;
+  }
 
   // Check for double free
-  if (get_bitmap_item(run->reg_bitmap, bitmap_idx) != STATE_ALLOC) {
+  if (!is_region_live(run, bin, bitmap_idx)) {
     // se_error("Provided ptr not freeable (ptr=%p)", ptr);
     return SIZE_MAX;
   }
@@ -224,12 +287,58 @@ bool run_deallocate(run_t *run, bin_t *bin, void *ptr) {
   if (bitmap_idx == SIZE_MAX) return false;
 
   // Mark as freed
-  set_bitmap_item(run->reg_bitmap, bitmap_idx, STATE_ALLOC_FREE);
+  if (run->gen == RUN_GEN_COMPACT)
+    bitset_clear(live_set(run), bitmap_idx);
+  else
+    bitset_set(freed_set(run, bin), bitmap_idx);
   run->nfreed++;
+  bin->nfrees++;
   return true;
 }
 
+void *run_tag_large(void *ptr, unsigned size) {
+#if __aarch64__ && __ARM_FEATURE_MEMORY_TAGGING
+  if (!is_mte_enabled) {
+    return ptr;
+  }
+  // Large region has no neighbours within its run, exclude only tag 0
+  ptr = (void *)tag_pointer((uint64_t)ptr, 1);
+  set_tag_n((uint64_t)ptr, (uint64_t)ptr, size);
+  return ptr;
+#else
+  (void)size;
+  return ptr;
+#endif
+}
+
 bool run_is_depleted(run_t *run) { return run->navail == 0; }
 bool run_is_freeable(run_t *run, bin_t *bin) {
+  // Every allocated region is either live or freed
+  assert(run->nfreed + run_count_live(run, bin) ==
+         bin->reg_mask_size_bits / 2 - run->navail);
   return run->nfreed == bin->reg_mask_size_bits / 2;
 }
+
+bstate_t run_get_region_state(const run_t *run, const bin_t *bin,
+                              size_t idx) {
+  const uint64_t *alloc = run->reg_bitmap;
+  const uint64_t *freed = run->reg_bitmap + run_bitset_words(bin);
+  if (run->gen == RUN_GEN_COMPACT)
+    return bitset_get(run->reg_bitmap, idx) ? STATE_ALLOC : STATE_ALLOC_FREE;
+  if (!bitset_get(alloc, idx)) return STATE_FREE;
+  return bitset_get(freed, idx) ? STATE_ALLOC_FREE : STATE_ALLOC;
+}
+
+size_t run_count_live(const run_t *run, const bin_t *bin) {
+  size_t words = run_bitset_words(bin);
+  if (run->gen == RUN_GEN_COMPACT) return bitset_count(run->reg_bitmap, words);
+  return bitset_count_andnot(run->reg_bitmap, run->reg_bitmap + words, words);
+}
+
+size_t run_next_live(const run_t *run, const bin_t *bin, size_t start) {
+  size_t words = run_bitset_words(bin);
+  if (run->gen == RUN_GEN_COMPACT)
+    return bitset_find_next(run->reg_bitmap, words, start);
+  return bitset_find_next_andnot(run->reg_bitmap, run->reg_bitmap + words,
+                                 words, start);
+}
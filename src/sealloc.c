@@ -4,45 +4,84 @@
 #include "sealloc/arena.h"
 #include "sealloc/bin.h"
 #include "sealloc/chunk.h"
+#include "sealloc/latency.h"
 #include "sealloc/logging.h"
 #include "sealloc/platform_api.h"
+#include "sealloc/pool.h"
+#include "sealloc/probes.h"
+#include "sealloc/prof.h"
 #include "sealloc/run.h"
+#include "sealloc/sealloc.h"
 #include "sealloc/size_class.h"
 #include "sealloc/utils.h"
 
-typedef enum metadata_type {
-  METADATA_INVALID,
-  METADATA_REGULAR,
-  METADATA_HUGE
-} metadata_t;
+/*
+ * Batch allocation takes at most that many regions from a single randomly
+ * chosen run before choosing another one.
+ */
+#define BATCH_REGIONS_PER_RUN 8
 
-static void *sealloc_allocate_with_bin(arena_t *arena, bin_t *bin) {
-  void *ptr;
+/*
+ * Number of recently located runs remembered during batch free.
+ */
+#define BATCH_FREE_CACHE_SIZE 16
 
+// Makes sure that bin has enough regions to choose from
+static bool sealloc_fill_bin(arena_t *arena, bin_t *bin) {
   // Check if there is enough regions to choose from
-  // Here adding one run should be enough
-  if (bin->avail_regs < BIN_MINIMUM_REGIONS) {
+  // Usually adding one run is enough, but bin may be empty or its minimum
+  // may have been raised with sealloc_ctl()
+  if (bin->avail_regs < bin->min_regions) {
+    se_debug("Not enough available regions, supplying more");
+    se_lat_start(start);
+    bool supplied = arena_supply_runs(arena, bin);
+    se_lat_end(arena, LAT_MALLOC_SUPPLY_RUNS, start);
     // If runs could not be supplied, then we're out of memory
-    run_t *run = arena_allocate_run(arena, bin);
-    if (run == NULL) {
+    if (!supplied) {
       se_debug("End of memory");
-      return NULL;
+      return false;
     }
-    bin_add_run(bin, run);
   }
-  assert(bin->avail_regs >= BIN_MINIMUM_REGIONS);
+  assert(bin->avail_regs >= bin->min_regions);
+  return true;
+}
+
+// Counts allocation towards next heap profile sample
+static inline void sealloc_prof_tick(arena_t *arena, void *ptr, size_t size) {
+  if (ptr != NULL && prof_tick(&arena->prof, size))
+    prof_sample(arena, ptr, size);
+}
+
+static void *sealloc_allocate_with_bin(arena_t *arena, bin_t *bin) {
+  void *ptr;
+
+  // Large regions occupy whole run and carry no run metadata
+  if (IS_SIZE_LARGE(bin->reg_size)) {
+    se_debug("Allocating large region of size %u", bin->reg_size);
+    ptr = arena_allocate_large(arena, bin);
+    if (ptr == NULL) return NULL;
+    return run_tag_large(ptr, bin->reg_size);
+  }
+
+  if (!sealloc_fill_bin(arena, bin)) return NULL;
+  se_lat_start(run_start);
   run_t *run = bin_get_run_for_allocation(bin);
+  se_lat_end(arena, LAT_MALLOC_RUN_SELECT, run_start);
   se_debug("Allocating from bin for region sizes %u", bin->reg_size);
+  se_lat_start(reg_start);
   ptr = run_allocate(run, bin);
+  se_lat_end(arena, LAT_MALLOC_REGION_SELECT, reg_start);
   if (run_is_depleted(run)) {
     se_debug("Retiring run");
-    bin_retire_run(bin, run);
+    arena_retire_run(arena, bin, run);
   }
   return ptr;
 }
 
 void *sealloc_malloc(arena_t *arena, size_t size) {
   size_t aligned_size;
+  void *ptr;
+  se_probe1(malloc_entry, size);
 
   /*
    * Some programs seem to allocate size 0 to reallocate in future
@@ -52,46 +91,109 @@ void *sealloc_malloc(arena_t *arena, size_t size) {
 
   if (IS_SIZE_HUGE(size)) {
     huge_chunk_t *huge = arena_allocate_huge_mapping(arena, ALIGNUP_PAGE(size));
-    return huge->entry.key;
+    ptr = huge->entry.key;
+  } else {
+    se_lat_start(start);
+    aligned_size = alignup_size(size);
+    se_debug("Allocating region of size %zu (aligned to %zu)", size,
+             aligned_size);
+    bin_t *bin = arena_get_bin_by_reg_size(arena, aligned_size);
+    se_lat_end(arena, LAT_MALLOC_SIZE_CLASS, start);
+    ptr = sealloc_allocate_with_bin(arena, bin);
   }
+  sealloc_prof_tick(arena, ptr, size);
+  se_probe2(malloc_exit, size, ptr);
+  return ptr;
+}
 
-  if (IS_SIZE_SMALL(size)) {
-    aligned_size = ALIGNUP_SMALL_SIZE(size);
-  } else if (IS_SIZE_MEDIUM(size)) {
-    aligned_size = alignup_medium_size(size);
-  } else {
-    aligned_size = alignup_large_size(size);
+void *sealloc_aligned_alloc(arena_t *arena, size_t alignment, size_t size) {
+  assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+  if (size == 0) size = SMALL_SIZE_MIN_REGION;
+  if (size > SIZE_MAX - PAGE_SIZE || size > SIZE_MAX - alignment) return NULL;
+
+  /*
+   * Mappings are placed by probing, so they can be probed at aligned addresses
+   * directly. Runs within chunks are aligned only to a page.
+   */
+  if (alignment > PAGE_SIZE) {
+    se_debug("Allocating huge mapping of size %zu aligned to %zu", size,
+             alignment);
+    void *ptr = arena_allocate_huge_mapping_aligned(arena, ALIGNUP_PAGE(size),
+                                                    alignment)
+                    ->entry.key;
+    sealloc_prof_tick(arena, ptr, size);
+    return ptr;
+  }
+
+  /*
+   * Runs are page aligned and regions are placed at multiples of reg_size, so
+   * every region of a class is aligned iff reg_size is a multiple of
+   * alignment. Small classes are multiples of 16, medium and large classes are
+   * powers of 2, hence class of size rounded up to alignment is such a class.
+   */
+  return sealloc_malloc(arena, ALIGNUP(size, alignment));
+}
+
+size_t sealloc_batch_malloc(arena_t *arena, size_t size, size_t n,
+                            void **out) {
+  size_t i = 0;
+  unsigned nregs;
+  run_t *run;
+
+  if (size == 0) size = SMALL_SIZE_MIN_REGION;
+
+  // Huge and large allocations have no runs to share
+  if (IS_SIZE_HUGE(size) || IS_SIZE_LARGE(size)) {
+    for (; i < n; i++) {
+      out[i] = sealloc_malloc(arena, size);
+      if (out[i] == NULL) break;
+    }
+    return i;
   }
 
-  se_debug("Allocating region of size %zu (aligned to %zu)", size,
-           aligned_size);
-  bin_t *bin = arena_get_bin_by_reg_size(arena, aligned_size);
-  // initialize bin with enugh runs, needed only once
-  if (bin->avail_regs == 0) {
-    se_debug("No available regions, supplying more");
-    if (!arena_supply_runs(arena, bin)) return NULL;
+  bin_t *bin = arena_get_bin_by_reg_size(arena, alignup_size(size));
+  se_debug("Allocating batch of %zu regions of size %u", n, bin->reg_size);
+  while (i < n) {
+    if (!sealloc_fill_bin(arena, bin)) return i;
+    nregs = n - i < BATCH_REGIONS_PER_RUN ? n - i : BATCH_REGIONS_PER_RUN;
+    run = bin_get_run_for_batch(bin, &nregs);
+    for (unsigned k = 0; k < nregs; k++) {
+      out[i] = run_allocate(run, bin);
+      sealloc_prof_tick(arena, out[i++], size);
+    }
+    if (run_is_depleted(run)) {
+      se_debug("Retiring run");
+      arena_retire_run(arena, bin, run);
+    }
   }
-  return sealloc_allocate_with_bin(arena, bin);
+  return i;
 }
 
-metadata_t locate_metadata_for_ptr(arena_t *arena, void *ptr,
-                                          chunk_t **chunk_ret, run_t **run_ret,
-                                          bin_t **bin_ret,
-                                          huge_chunk_t **huge_ret) {
+// Finds chunk and run which contain ptr, NULL if ptr is not within any run
+static chunk_t *locate_run_for_ptr(arena_t *arena, void *ptr, void **run_ptr,
+                                   unsigned *run_size, unsigned *reg_size) {
   chunk_t *chunk = NULL;
-  void *run_ptr = NULL;
-  unsigned run_size = 0, reg_size = 0;
   se_debug("Getting chunk from pointer");
   chunk = arena_get_chunk_from_ptr(arena, ptr, chunk);
   while (chunk != NULL) {
-    *chunk_ret = chunk;
     se_debug("Found chunk metadata at %p", (void *)chunk);
-    chunk_get_run_ptr(chunk, ptr, &run_ptr, &run_size, &reg_size);
-    if (run_ptr != NULL) {
+    chunk_get_run_ptr(chunk, ptr, run_ptr, run_size, reg_size);
+    if (*run_ptr != NULL) {
       break;
     }
     chunk = arena_get_chunk_from_ptr(arena, ptr, chunk);
   }
+  return chunk;
+}
+
+metadata_t locate_metadata_for_ptr(arena_t *arena, void *ptr,
+                                          chunk_t **chunk_ret, run_t **run_ret,
+                                          bin_t **bin_ret,
+                                          huge_chunk_t **huge_ret) {
+  chunk_t *chunk = NULL;
+  void *run_ptr = NULL;
+  unsigned run_size = 0, reg_size = 0;
+  chunk = locate_run_for_ptr(arena, ptr, &run_ptr, &run_size, &reg_size);
   if (chunk == NULL) {
     se_debug("No chunk found, checking huge allocations.");
     huge_chunk_t *huge_chunk;
@@ -102,22 +204,107 @@ metadata_t locate_metadata_for_ptr(arena_t *arena, void *ptr,
     *huge_ret = huge_chunk;
     return METADATA_HUGE;
   }
+  *chunk_ret = chunk;
   se_debug("Found run (run_ptr : %p)", run_ptr);
+  // Pool regions must be freed through their pool
+  if (REG_MARK_IS_POOL(reg_size)) return METADATA_INVALID;
   if (reg_size > 0) {
     se_debug("Getting bin for small/medium class");
     *bin_ret = arena_get_bin_by_reg_size(arena, reg_size);
   } else {
     se_debug("Getting bin for large class");
+    // Large region always starts at the beginning of its run
+    if (ptr != run_ptr) return METADATA_INVALID;
     *bin_ret = arena_get_bin_by_reg_size(arena, run_size);
+    *run_ret = NULL;
+    return METADATA_LARGE;
   }
-  *run_ret = bin_get_run_by_addr(*bin_ret, run_ptr);
+  *run_ret = chunk_get_run(chunk, run_ptr, run_size);
+  assert(*run_ret == NULL || (*run_ret)->bin == *bin_ret);
   se_debug("Found run metadata at %p (reg_size : %u, run_size_pages %u)",
            (void *)*run_ret, (*bin_ret)->reg_size, (*bin_ret)->run_size_pages);
   return METADATA_REGULAR;
 }
 
-static void sealloc_free_with_metadata(arena_t *arena, chunk_t *chunk,
+static void sealloc_usable_size_invalid(void) {
+  se_log("Invalid call to malloc_usable_size()");
+  abort();
+}
+
+size_t sealloc_usable_size(arena_t *arena, void *ptr) {
+  void *run_ptr = NULL;
+  unsigned run_size = 0, reg_size = 0;
+  huge_chunk_t *huge;
+  if (ptr == NULL) return 0;
+#if __aarch64__ && __ARM_FEATURE_MEMORY_TAGGING
+#include "sealloc/arch/aarch64.h"
+  if (is_mte_enabled) {
+    // Clear tag bits, so that we can do pointer arithmetics
+    ptr = (void *)((uintptr_t)ptr & ((1ULL << TAG_OFFSET_BITS) - 1));
+  }
+#endif
+  /*
+   * Chunk alone knows the class of each run, so run metadata is not looked up.
+   * Pointer is checked to be the start of some region, but not whether the
+   * region is live.
+   */
+  if (locate_run_for_ptr(arena, ptr, &run_ptr, &run_size, &reg_size) == NULL) {
+    huge = arena_find_huge_mapping(arena, ptr);
+    if (huge == NULL) sealloc_usable_size_invalid();
+    return huge->len;
+  }
+  if (reg_size == 0) {
+    if (ptr != run_ptr) sealloc_usable_size_invalid();
+    return run_size;
+  }
+  // Pool regions are known only to their pool
+  if (REG_MARK_IS_POOL(reg_size)) sealloc_usable_size_invalid();
+  bin_t *bin = arena_get_bin_by_reg_size(arena, reg_size);
+  uint64_t rel_ptr = (uintptr_t)ptr - (uintptr_t)run_ptr;
+  size_t idx = (rel_ptr * bin->reg_size_magic) >> 32;
+  if (idx * reg_size != rel_ptr || idx >= bin->reg_mask_size_bits / 2)
+    sealloc_usable_size_invalid();
+  return reg_size;
+}
+
+size_t sealloc_round_size(size_t size) {
+  if (size == 0) return SMALL_SIZE_MIN_REGION;
+  if (IS_SIZE_HUGE(size)) {
+    if (size > SIZE_MAX - PAGE_SIZE) return 0;
+    return ALIGNUP_PAGE(size);
+  }
+  return alignup_size(size);
+}
+
+// Releases run that has no live regions left, together with its metadata
+static void sealloc_release_run(arena_t *arena, chunk_t *chunk, bin_t *bin,
+                                run_t *run) {
+  se_debug("Run is freeable, deleting");
+  bin_delete_run(bin, run);
+  bin->nruns_released++;
+  if (chunk_deallocate_run(chunk, run->entry.key)) {
+    se_debug("Chunk is fully unmapped, deallocating chunk metadata");
+    arena_deallocate_chunk(arena, chunk);
+  }
+  arena_internal_free(arena, run);
+}
+
+// Returns true if run was released together with its metadata
+static bool sealloc_free_with_metadata(arena_t *arena, chunk_t *chunk,
                                        bin_t *bin, run_t *run, void *ptr) {
+  if (chunk_is_sampled(chunk, ptr)) prof_forget(arena, ptr);
+  if (IS_SIZE_LARGE(bin->reg_size)) {
+    // Pointer was already validated against the chunk, release the run
+    se_debug("Freeing large region");
+    bin->nfrees++;
+    bin->nruns_released++;
+    if (chunk_deallocate_run(chunk, ptr)) {
+      se_debug("Chunk is fully unmapped, deallocating chunk metadata");
+      arena_deallocate_chunk(arena, chunk);
+    }
+    return true;
+  }
+
   if (!run_deallocate(run, bin, ptr)) {
     se_debug("Invalid pointer: %p", ptr);
     se_log("Invalid call to free()");
@@ -125,14 +312,10 @@ static void sealloc_free_with_metadata(arena_t *arena, chunk_t *chunk,
   }
 
   if (run_is_freeable(run, bin)) {
-    se_debug("Run is freeable, deleting");
-    bin_delete_run(bin, run);
-    if (chunk_deallocate_run(chunk, run->entry.key)) {
-      se_debug("Chunk is fully unmapped, deallocating chunk metadata");
-      arena_deallocate_chunk(arena, chunk);
-    }
-    arena_internal_free(arena, run);
+    sealloc_release_run(arena, chunk, bin, run);
+    return true;
   }
+  return false;
 }
 
 void sealloc_free(arena_t *arena, void *ptr) {
@@ -143,6 +326,7 @@ void sealloc_free(arena_t *arena, void *ptr) {
   huge_chunk_t *huge;
   metadata_t meta;
   if (ptr == NULL) return;
+  se_probe1(free_entry, ptr);
 #if __aarch64__ && __ARM_FEATURE_MEMORY_TAGGING
 #include "sealloc/arch/aarch64.h"
   if (is_mte_enabled) {
@@ -150,24 +334,258 @@ void sealloc_free(arena_t *arena, void *ptr) {
     ptr = (void *)((uintptr_t)ptr & ((1ULL << TAG_OFFSET_BITS) - 1));
   }
 #endif
+  se_lat_start(locate_start);
   meta = locate_metadata_for_ptr(arena, ptr, &chunk, &run, &bin, &huge);
+  se_lat_end(arena, LAT_FREE_LOCATE, locate_start);
   if (meta == METADATA_INVALID) {
     se_debug("Invalid pointer: %p", ptr);
     se_log("Invalid call to free()");
     abort();
   }
-  if (meta == METADATA_HUGE) {
+  se_lat_start(release_start);
+  if (meta == METADATA_HUGE)
     arena_deallocate_huge_mapping(arena, huge);
+  else
+    sealloc_free_with_metadata(arena, chunk, bin, run, ptr);
+  se_lat_end(arena, LAT_FREE_RELEASE, release_start);
+  se_probe1(free_exit, ptr);
+}
+
+// Finds run of bin containing ptr through its chunk, NULL if there is none
+static run_t *locate_run_of_bin(arena_t *arena, bin_t *bin, void *ptr,
+                                chunk_t **chunk_ret) {
+  run_t *run;
+  chunk_t *chunk = arena_get_chunk_from_ptr(arena, ptr, NULL);
+  if (chunk == NULL) return NULL;
+  // Size class tells the run size, so buddy tree of the chunk is not walked
+  run = chunk_get_run(chunk, ptr, bin->run_size_pages * PAGE_SIZE);
+  if (run == NULL || run->bin != bin) return NULL;
+  *chunk_ret = chunk;
+  return run;
+}
+
+static void sealloc_free_sized_invalid(void) {
+  se_log("Invalid call to free_sized()");
+  abort();
+}
+
+static void sealloc_free_huge_sized(arena_t *arena, void *ptr, size_t size) {
+  se_lat_start(locate_start);
+  huge_chunk_t *huge = arena_find_huge_mapping(arena, ptr);
+  se_lat_end(arena, LAT_FREE_LOCATE, locate_start);
+  if (huge == NULL || huge->len != ALIGNUP_PAGE(size))
+    sealloc_free_sized_invalid();
+  se_lat_start(release_start);
+  arena_deallocate_huge_mapping(arena, huge);
+  se_lat_end(arena, LAT_FREE_RELEASE, release_start);
+}
+
+void sealloc_free_sized(arena_t *arena, void *ptr, size_t size) {
+  se_debug("Freeing a region at %p of size %zu", ptr, size);
+  chunk_t *chunk;
+  run_t *run;
+  bin_t *bin, *bin_found;
+  huge_chunk_t *huge;
+  if (ptr == NULL) return;
+  se_probe1(free_entry, ptr);
+#if __aarch64__ && __ARM_FEATURE_MEMORY_TAGGING
+#include "sealloc/arch/aarch64.h"
+  if (is_mte_enabled) {
+    // Clear tag bits, so that we can do pointer arithmetics
+    ptr = (void *)((uintptr_t)ptr & ((1ULL << TAG_OFFSET_BITS) - 1));
+  }
+#endif
+  // Same substitution as in sealloc_malloc()
+  if (size == 0) size = SMALL_SIZE_MIN_REGION;
+
+  if (IS_SIZE_HUGE(size)) {
+    sealloc_free_huge_sized(arena, ptr, size);
+    se_probe1(free_exit, ptr);
+    return;
+  }
+
+  bin = arena_get_bin_by_reg_size(arena, alignup_size(size));
+  if (IS_SIZE_LARGE(bin->reg_size)) {
+    // Large regions are known only to chunks, but class must still match
+    se_lat_start(locate_start);
+    if (locate_metadata_for_ptr(arena, ptr, &chunk, &run, &bin_found,
+                                &huge) != METADATA_LARGE ||
+        bin_found != bin)
+      sealloc_free_sized_invalid();
+    se_lat_end(arena, LAT_FREE_LOCATE, locate_start);
+    se_lat_start(release_start);
+    sealloc_free_with_metadata(arena, chunk, bin, run, ptr);
+    se_lat_end(arena, LAT_FREE_RELEASE, release_start);
+    se_probe1(free_exit, ptr);
+    return;
+  }
+
+  se_lat_start(locate_start);
+  run = locate_run_of_bin(arena, bin, ptr, &chunk);
+  se_lat_end(arena, LAT_FREE_LOCATE, locate_start);
+  se_lat_start(release_start);
+  if (run == NULL || !run_deallocate(run, bin, ptr))
+    sealloc_free_sized_invalid();
+  // Run tells if table of samples has to be searched
+  if (run->sampled) prof_forget(arena, ptr);
+
+  if (run_is_freeable(run, bin)) sealloc_release_run(arena, chunk, bin, run);
+  se_lat_end(arena, LAT_FREE_RELEASE, release_start);
+  se_probe1(free_exit, ptr);
+}
+
+void sealloc_free_aligned_sized(arena_t *arena, void *ptr, size_t alignment,
+                                size_t size) {
+  if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+    se_log("Invalid call to free_aligned_sized()");
+    abort();
+  }
+  if (size == 0) size = SMALL_SIZE_MIN_REGION;
+  // Same placement as in sealloc_aligned_alloc()
+  if (alignment > PAGE_SIZE) {
+    if (ptr != NULL) sealloc_free_huge_sized(arena, ptr, size);
     return;
   }
+  sealloc_free_sized(arena, ptr, ALIGNUP(size, alignment));
+}
+
+typedef struct batch_free_entry {
+  uintptr_t run_start; /* 0 if entry is empty */
+  uintptr_t run_end;
+  chunk_t *chunk;
+  bin_t *bin;
+  run_t *run;
+} batch_free_entry_t;
+
+void sealloc_batch_free(arena_t *arena, void **ptrs, size_t n) {
+  batch_free_entry_t cache[BATCH_FREE_CACHE_SIZE] = {0};
+  batch_free_entry_t *entry;
+  unsigned next_slot = 0;
+  chunk_t *chunk;
+  run_t *run;
+  bin_t *bin;
+  huge_chunk_t *huge;
+  metadata_t meta;
+  uintptr_t addr;
+  void *ptr;
+
+  for (size_t i = 0; i < n; i++) {
+    ptr = ptrs[i];
+    if (ptr == NULL) continue;
+#if __aarch64__ && __ARM_FEATURE_MEMORY_TAGGING
+#include "sealloc/arch/aarch64.h"
+    if (is_mte_enabled) {
+      // Clear tag bits, so that we can do pointer arithmetics
+      ptr = (void *)((uintptr_t)ptr & ((1ULL << TAG_OFFSET_BITS) - 1));
+    }
+#endif
+    addr = (uintptr_t)ptr;
+    // Pointers freed together tend to share runs, try recently seen ones
+    entry = NULL;
+    for (unsigned k = 0; k < BATCH_FREE_CACHE_SIZE; k++) {
+      if (cache[k].run_start <= addr && addr < cache[k].run_end) {
+        entry = &cache[k];
+        break;
+      }
+    }
+
+    if (entry == NULL) {
+      meta = locate_metadata_for_ptr(arena, ptr, &chunk, &run, &bin, &huge);
+      if (meta == METADATA_INVALID) {
+        se_debug("Invalid pointer: %p", ptr);
+        se_log("Invalid call to free()");
+        abort();
+      }
+      if (meta == METADATA_HUGE) {
+        arena_deallocate_huge_mapping(arena, huge);
+        continue;
+      }
+      if (meta == METADATA_LARGE) {
+        sealloc_free_with_metadata(arena, chunk, bin, run, ptr);
+        continue;
+      }
+      entry = &cache[next_slot];
+      next_slot = (next_slot + 1) % BATCH_FREE_CACHE_SIZE;
+      entry->run_start = (uintptr_t)run->entry.key;
+      entry->run_end = entry->run_start + bin->run_size_pages * PAGE_SIZE;
+      entry->chunk = chunk;
+      entry->bin = bin;
+      entry->run = run;
+    }
+
+    // Validates ptr against the run, aborts if it is not freeable
+    if (sealloc_free_with_metadata(arena, entry->chunk, entry->bin,
+                                   entry->run, ptr)) {
+      entry->run_start = 0;
+      entry->run_end = 0;
+    }
+  }
+}
+
+pool_t *sealloc_create_pool(arena_t *arena, size_t obj_size, size_t align) {
+  unsigned reg_size = pool_reg_size(obj_size, align);
+  if (reg_size == 0) return NULL;
+  pool_t *pool = arena_internal_alloc(arena, sizeof(pool_t));
+  pool_init(pool, arena, reg_size);
+  se_debug("Created pool of regions of size %u (run_size_pages %u)", reg_size,
+           pool->bin.run_size_pages);
+  return pool;
+}
+
+void *sealloc_malloc_from_pool(pool_t *pool) {
+  // Pool regions are never large, regular bin path applies
+  return sealloc_allocate_with_bin(pool->arena, &pool->bin);
+}
+
+void sealloc_free_to_pool(pool_t *pool, void *ptr) {
+  if (ptr == NULL) return;
+#if __aarch64__ && __ARM_FEATURE_MEMORY_TAGGING
+#include "sealloc/arch/aarch64.h"
+  if (is_mte_enabled) {
+    // Clear tag bits, so that we can do pointer arithmetics
+    ptr = (void *)((uintptr_t)ptr & ((1ULL << TAG_OFFSET_BITS) - 1));
+  }
+#endif
+  bin_t *bin = &pool->bin;
+  chunk_t *chunk;
+  run_t *run = locate_run_of_bin(pool->arena, bin, ptr, &chunk);
+  if (run == NULL || !run_deallocate(run, bin, ptr)) {
+    se_debug("Invalid pointer: %p", ptr);
+    se_log("Invalid call to sealloc_pool_free()");
+    abort();
+  }
+  if (run_is_freeable(run, bin))
+    sealloc_release_run(pool->arena, chunk, bin, run);
+}
 
-  sealloc_free_with_metadata(arena, chunk, bin, run, ptr);
+void sealloc_destroy_pool(pool_t *pool) {
+  arena_t *arena = pool->arena;
+  ll_head_t *lists[] = {&pool->bin.run_list_active,
+                        &pool->bin.run_list_inactive};
+  ll_entry_t *entry, *next;
+  chunk_t *chunk;
+  // Objects die together with the pool, runs are released as they are
+  for (unsigned i = 0; i < sizeof(lists) / sizeof(lists[0]); i++) {
+    for (entry = lists[i]->ll; entry != NULL; entry = next) {
+      next = entry->link.fd;
+      chunk = arena_get_chunk_from_ptr(arena, entry->key, NULL);
+      assert(chunk != NULL);
+      if (chunk_deallocate_run(chunk, entry->key))
+        arena_deallocate_chunk(arena, chunk);
+      arena_internal_free(arena, CONTAINER_OF(entry, run_t, entry));
+    }
+  }
+  arena_internal_free(arena, pool);
 }
 
 static void *realloc_huge(arena_t *arena, huge_chunk_t *huge, size_t new_size) {
   se_debug("Reallocating huge chunk at %p", huge->entry.key);
   if (IS_SIZE_HUGE(new_size)) {
+    void *old_map = huge->entry.key;
     arena_reallocate_huge_mapping(arena, huge, new_size);
+    // Moved mapping lost its sample, count it as a new allocation
+    if (huge->entry.key != old_map)
+      sealloc_prof_tick(arena, huge->entry.key, new_size);
     return huge->entry.key;
   }
   // huge -> regular case
@@ -176,7 +594,9 @@ static void *realloc_huge(arena_t *arena, huge_chunk_t *huge, size_t new_size) {
     se_debug("Failed to allocate region for huge mapping reallocation");
     return NULL;
   }
-  memcpy(new_reg, huge->entry.key, new_size);
+  // Aligned allocations map less than smallest huge size
+  memcpy(new_reg, huge->entry.key,
+         new_size < huge->len ? new_size : huge->len);
   arena_deallocate_huge_mapping(arena, huge);
   return new_reg;
 }
@@ -212,7 +632,8 @@ void *sealloc_realloc(arena_t *arena, void *old_ptr, size_t new_size) {
     return realloc_huge(arena, huge, ALIGNUP_PAGE(new_size));
   }
 
-  if (run_validate_ptr(run_old, bin_old, old_ptr) == SIZE_MAX) {
+  if (meta == METADATA_REGULAR &&
+      run_validate_ptr(run_old, bin_old, old_ptr) == SIZE_MAX) {
     se_log("Invalid call to realloc()");
     abort();
   }
@@ -225,22 +646,12 @@ void *sealloc_realloc(arena_t *arena, void *old_ptr, size_t new_size) {
     memcpy(huge->entry.key, old_ptr, bin_old->reg_size);
 #endif
     sealloc_free_with_metadata(arena, chunk, bin_old, run_old, old_ptr);
+    sealloc_prof_tick(arena, huge->entry.key, new_size);
     return huge->entry.key;
   }
 
-  if (IS_SIZE_SMALL(new_size)) {
-    new_size_aligned = ALIGNUP_SMALL_SIZE(new_size);
-  } else if (IS_SIZE_MEDIUM(new_size)) {
-    new_size_aligned = alignup_medium_size(new_size);
-  } else {
-    new_size_aligned = alignup_large_size(new_size);
-  }
-
+  new_size_aligned = alignup_size(new_size);
   bin_new = arena_get_bin_by_reg_size(arena, new_size_aligned);
-  // initialize bin with enugh runs, needed only once
-  if (bin_new->avail_regs == 0) {
-    if (!arena_supply_runs(arena, bin_new)) return NULL;
-  }
   if (bin_new->reg_size == bin_old->reg_size) {
     se_debug("New allocation is still in the same class");
 #if __aarch64__ && __ARM_FEATURE_MEMORY_TAGGING
@@ -272,9 +683,64 @@ void *sealloc_realloc(arena_t *arena, void *old_ptr, size_t new_size) {
   }
 #endif
   sealloc_free_with_metadata(arena, chunk, bin_old, run_old, old_ptr);
+  sealloc_prof_tick(arena, new_ptr, new_size);
   return new_ptr;
 }
 
+static void sealloc_expand_invalid(void) {
+  se_log("Invalid call to sealloc_try_expand()");
+  abort();
+}
+
+size_t sealloc_expand_in_place(arena_t *arena, void *ptr, size_t min_size,
+                               size_t max_size) {
+  chunk_t *chunk;
+  run_t *run;
+  bin_t *bin;
+  huge_chunk_t *huge;
+  metadata_t meta;
+  size_t usable;
+  if (ptr == NULL) return 0;
+#if __aarch64__ && __ARM_FEATURE_MEMORY_TAGGING
+#include "sealloc/arch/aarch64.h"
+  if (is_mte_enabled) {
+    // Clear tag bits, so that we can do pointer arithmetics
+    ptr = PTR_CLEAR_TAG(ptr);
+  }
+#endif
+  if (max_size < min_size) max_size = min_size;
+  meta = locate_metadata_for_ptr(arena, ptr, &chunk, &run, &bin, &huge);
+  if (meta == METADATA_INVALID) sealloc_expand_invalid();
+
+  if (meta == METADATA_HUGE) {
+    usable = huge->len;
+    if (min_size <= usable || min_size > SIZE_MAX - PAGE_SIZE) return usable;
+    if (max_size > SIZE_MAX - PAGE_SIZE) max_size = SIZE_MAX - PAGE_SIZE;
+    // Try the biggest size first, pages after mapping may fit only smaller one
+    if (!arena_expand_huge_mapping(arena, huge, ALIGNUP_PAGE(max_size)) &&
+        ALIGNUP_PAGE(min_size) < ALIGNUP_PAGE(max_size))
+      arena_expand_huge_mapping(arena, huge, ALIGNUP_PAGE(min_size));
+    return huge->len;
+  }
+
+  if (meta == METADATA_REGULAR) {
+    if (run_validate_ptr(run, bin, ptr) == SIZE_MAX) sealloc_expand_invalid();
+    // Neighbours in the run belong to other regions, class is the limit
+    return bin->reg_size;
+  }
+
+  // Large region spans whole run, it can take free buddies of the run
+  usable = bin->reg_size;
+  if (min_size <= usable || IS_SIZE_HUGE(min_size)) return usable;
+#if __aarch64__ && __ARM_FEATURE_MEMORY_TAGGING
+  // Buddies are not tagged with tag of the pointer
+  if (is_mte_enabled) return usable;
+#endif
+  if (IS_SIZE_HUGE(max_size)) max_size = LARGE_SIZE_MAX_REGION;
+  return chunk_expand_run(chunk, ptr, usable, alignup_size(min_size),
+                          alignup_size(max_size));
+}
+
 void *sealloc_calloc(arena_t *arena, size_t nmemb, size_t size) {
   if (nmemb == 0 || size == 0) return NULL;
   void *ptr = sealloc_malloc(arena, nmemb * size);
@@ -14,8 +14,13 @@
 #include <stdint.h>
 
 #include "bin.h"
+#include "conf.h"
 #include "container_ll.h"
+#include "histogram.h"
+#include "latency.h"
+#include "prof.h"
 #include "size_class.h"
+#include "trace.h"
 #include "utils.h"
 
 struct chunk_state;
@@ -39,6 +44,7 @@ struct huge_chunk {
   ll_entry_t entry; /*!< Linkage field that links together more huge allocations
                        metadata. */
   size_t len;       /*!< Size of allocation, ALIGNED to PAGE_SIZE */
+  bool sampled;     /*!< Allocation is tracked by heap profiler */
 };
 typedef struct huge_chunk huge_chunk_t;
 
@@ -74,8 +80,19 @@ struct arena_state {
                              for more memory for internal allocator nodes. */
   bin_t bins[ARENA_NO_BINS]; /*!< Array of bin_t structures for SMALL, MEDIUM or
                                 LARGE size classes. */
+  arena_conf_t conf; /*!< Policy values, compile-time defaults overridden by
+                        SEALLOC_CONF */
+  prof_t prof;       /*!< Sampling heap profiler */
+  trace_t trace;     /*!< Trace of allocator API calls, closed by default */
+  struct live_stats *live; /*!< Statistics published to shared memory, NULL
+                              unless enabled */
 #ifdef STATISTICS
-  int stats_fd; /*!< Descriptor to stats file */
+  alloc_hist_t hist;     /*!< Histogram of allocation requests */
+  const char *hist_path; /*!< File histogram is dumped to */
+#endif
+#ifdef LATENCY
+  lat_hist_t latency;       /*!< Latency histograms of allocator phases */
+  const char *latency_path; /*!< File latency histograms are dumped to */
 #endif
 };
 typedef struct arena_state arena_t;
@@ -88,6 +105,16 @@ typedef struct arena_state arena_t;
  */
 void arena_init(arena_t *arena);
 
+/*!
+ * @brief Initializes an uninitialized arena structure with given secret.
+ *
+ * Same secret and sequence of requests give the same layout of the heap.
+ *
+ * @param[in,out] arena Pointer to the allocated arena structure.
+ * @param[in] secret Seed of PRNG used to randomize allocations.
+ */
+void arena_init_seeded(arena_t *arena, uint32_t secret);
+
 /*!
  * @brief Allocates metadata of specified size.
  *
@@ -108,6 +135,17 @@ void *arena_internal_alloc(arena_t *arena, size_t size);
  */
 void arena_internal_free(arena_t *arena, void *ptr);
 
+/*!
+ * @brief Gives back tail of metadata associated with ptr.
+ *
+ * @param[in,out] arena Pointer to the allocated arena structure.
+ * @param[in] ptr Pointer to the metadata being shrunk.
+ * @param[in] size New size of metadata.
+ * @pre arena is initialized
+ * @pre size is not bigger than the size ptr was allocated with
+ */
+void arena_internal_shrink(arena_t *arena, void *ptr, size_t size);
+
 /*!
  * @brief Allocates a run within some chunk assigned to arena.
  *
@@ -122,6 +160,36 @@ void arena_internal_free(arena_t *arena, void *ptr);
  */
 run_t *arena_allocate_run(arena_t *arena, bin_t *bin);
 
+/*!
+ * @brief Allocates memory for a single large region.
+ *
+ * Region spans entire run allocated within some chunk assigned to arena. No
+ * run metadata is created, chunk alone tracks the allocation.
+ *
+ * @param[in,out] arena Pointer to the allocated arena structure.
+ * @param[in] bin Bin of the large size class.
+ * @return Pointer to the region.
+ * @pre arena is initialized
+ * @pre bin is initialized and its reg_size is in large size class
+ */
+void *arena_allocate_large(arena_t *arena, bin_t *bin);
+
+/*!
+ * @brief Retires depleted run and shrinks its metadata.
+ *
+ * Run is moved to the inactive list of the bin and its metadata is turned in
+ * place into compact descriptor that only tracks live regions. Memory past the
+ * descriptor is given back to internal allocator.
+ *
+ * @param[in,out] arena Pointer to the allocated arena structure.
+ * @param[in,out] bin Pointer to the bin which run belongs to.
+ * @param[in,out] run Depleted run.
+ * @return Compact metadata of the retired run, same as run.
+ * @pre arena is initialized
+ * @pre run is on the active list of bin and is depleted
+ */
+run_t *arena_retire_run(arena_t *arena, bin_t *bin, run_t *run);
+
 /*!
  * @brief Initially pumps runs into the bin to prepare for allocation.
  *
@@ -163,6 +231,27 @@ chunk_t *arena_allocate_chunk(arena_t *arena);
  */
 void arena_deallocate_chunk(arena_t *arena, chunk_t *chunk);
 
+/*!
+ * @brief Propagates changed configuration to existing chunks.
+ *
+ * Lookup and unmap parameters of every chunk are reset to configured values.
+ *
+ * @param[in,out] arena Pointer to the allocated arena structure
+ * @pre arena is initialized
+ */
+void arena_apply_chunk_conf(arena_t *arena);
+
+/*!
+ * @brief Unmaps freed memory which chunks keep mapped.
+ *
+ * Chunks which become fully unmapped are deallocated.
+ *
+ * @param[in,out] arena Pointer to the allocated arena structure
+ * @return Number of bytes unmapped.
+ * @pre arena is initialized
+ */
+size_t arena_decommit(arena_t *arena);
+
 /*!
  * @brief Finds chunk metadata.
  *
@@ -198,6 +287,21 @@ chunk_t *arena_get_chunk_from_ptr(const arena_t *arena, const void *ptr,
  */
 bin_t *arena_get_bin_by_reg_size(arena_t *arena, unsigned reg_size);
 
+/*!
+ * @brief Returns bin for reg_size if it was initialized
+ *
+ * Unlike arena_get_bin_by_reg_size(), bin is left untouched, so the call
+ * doesn't change state of the arena.
+ *
+ * @param[in] arena Pointer to the allocated arena structure
+ * @param[in] reg_size Region size which identifies which bin to return
+ * @return Pointer to bin metadata for reg_size, NULL if bin wasn't used yet
+ * @pre 1 <= reg_size <= LARGE_SIZE_MAX_REGION
+ * @pre reg_size is initialied to size in its class
+ * @pre arena is initialized
+ */
+bin_t *arena_find_bin_by_reg_size(arena_t *arena, unsigned reg_size);
+
 /*!
  * @brief Finds huge allocation
  *
@@ -225,6 +329,23 @@ huge_chunk_t *arena_find_huge_mapping(const arena_t *arena,
  */
 huge_chunk_t *arena_allocate_huge_mapping(arena_t *arena, size_t len);
 
+/*!
+ * @brief Allocates huge allocation at address aligned to alignment.
+ *
+ * Mapping is probed directly at aligned addresses, no memory is wasted for
+ * alignment.
+ *
+ * @param[in, out] arena Pointer to the allocated arena structure.
+ * @param[in] len size of requested allocation, page aligned.
+ * @param[in] alignment Alignment of mapping, power of 2 and at least PAGE_SIZE.
+ * @return Pointer to huge allocation mapping.
+ * @pre len is page aligned
+ * @pre arena is initialized
+ * @sideeffect fails if mapping could not be allocated
+ */
+huge_chunk_t *arena_allocate_huge_mapping_aligned(arena_t *arena, size_t len,
+                                                  size_t alignment);
+
 /*!
  * @brief Deallocates huge allocation.
  *
@@ -248,4 +369,43 @@ void arena_deallocate_huge_mapping(arena_t *arena, huge_chunk_t *huge);
  */
 void arena_reallocate_huge_mapping(arena_t *arena, huge_chunk_t *huge,
                                    size_t new_size);
+
+/*!
+ * @brief Grows huge allocation in place, keeping one page gap after it.
+ *
+ * @param[in, out] arena Pointer to the allocated arena structure
+ * @param[in, out] huge Metadata of huge allocation.
+ * @param[in] new_size Size of grown mapping.
+ * @return True if mapping was grown, false if memory after it is taken.
+ * @pre new_size is page aligned and bigger than huge->len
+ * @pre arena is initialized
+ */
+bool arena_expand_huge_mapping(arena_t *arena, huge_chunk_t *huge,
+                               size_t new_size);
+
+/*!
+ * @brief Releases all memory of arena at once.
+ *
+ * Chunks, huge allocations and internal allocator units are unmapped without
+ * freeing regions one by one. All pointers allocated from arena become
+ * invalid.
+ *
+ * @param[in, out] arena Pointer to the allocated arena structure.
+ * @pre arena is initialized
+ * @post arena is uninitialized and can be initialized again
+ * @sideeffect fails if any mapping could not be unmapped
+ */
+void arena_destroy(arena_t *arena);
+
+/*!
+ * @brief Returns to the system all memory arena can give back.
+ *
+ * Besides arena_decommit(), unused chunks, not yet used chunks of current
+ * mapping and empty internal allocator units are unmapped.
+ *
+ * @param[in, out] arena Pointer to the allocated arena structure.
+ * @return Number of bytes unmapped.
+ * @pre arena is initialized
+ */
+size_t arena_trim(arena_t *arena);
 #endif /* SEALLOC_ARENA_H_ */
@@ -38,6 +38,14 @@ struct bin_state {
   unsigned reg_size;       /*!< Size of single region */
   unsigned run_size_pages; /*!< Number of pages that each run spans */
   unsigned reg_mask_size_bits; /*!< Number of bits in region bitmask */
+  uint32_t reg_size_magic; /*!< ceil(2^32 / reg_size), lets region index be
+                              computed with multiply and shift */
+  bool is_pool; /*!< True if bin belongs to an object pool instead of arena */
+  unsigned min_regions; /*!< Regions kept available for allocation,
+                           BIN_MINIMUM_REGIONS by default */
+  size_t nallocs;        /*!< Regions allocated from the bin */
+  size_t nfrees;         /*!< Regions freed to the bin */
+  size_t nruns_released; /*!< Runs given back to chunks */
 };
 typedef struct bin_state bin_t;
 
@@ -51,6 +59,32 @@ typedef struct bin_state bin_t;
  */
 void bin_init(bin_t *bin, unsigned reg_size);
 
+/*!
+ * @brief Initializes an uninitialized bin structure with given run size.
+ *
+ * @param[in,out] bin Pointer to the allocated bin structure.
+ * @param[in] reg_size Region size of the bin.
+ * @param[in] run_size_pages Number of pages that each run spans.
+ * @pre run_size_pages * PAGE_SIZE is a power of 2 multiple of
+ * CHUNK_LEAST_REGION_SIZE_BYTES holding at most 65535 regions
+ */
+void bin_init_with_run_size(bin_t *bin, unsigned reg_size,
+                            unsigned run_size_pages);
+
+/*!
+ * @brief Initializes an uninitialized bin structure of an object pool.
+ *
+ * Unlike bin_init(), region and run sizes are not derived from size classes.
+ *
+ * @param[in,out] bin Pointer to the allocated bin structure.
+ * @param[in] reg_size Size of single object.
+ * @param[in] run_size_pages Number of pages that each run spans.
+ * @pre 1 <= reg_size < REG_MARK_POOL
+ * @pre run_size_pages * PAGE_SIZE is a power of 2 multiple of
+ * CHUNK_LEAST_REGION_SIZE_BYTES
+ */
+void bin_init_pool(bin_t *bin, unsigned reg_size, unsigned run_size_pages);
+
 /*!
  * @brief Selects run from which next allocation will take place
  *
@@ -62,6 +96,20 @@ void bin_init(bin_t *bin, unsigned reg_size);
  */
 run_t *bin_get_run_for_allocation(bin_t *bin);
 
+/*!
+ * @brief Selects run from which next several allocations will take place
+ *
+ * @param[in,out] bin Pointer to the allocated bin structure.
+ * @param[in,out] nregs Number of regions requested, on return number of
+ * regions reserved in selected run.
+ * @pre bin is initialized
+ * @pre *nregs >= 1
+ * @post bin structure is updated
+ * @warning *nregs allocations must take place from specified run after calling
+ * this function
+ */
+run_t *bin_get_run_for_batch(bin_t *bin, unsigned *nregs);
+
 /*!
  * @brief Adds fresh run to the bin
  *
@@ -0,0 +1,99 @@
+/*!
+ * @file bitset.h
+ * @brief Word-wide bitset helpers and bulk kernels.
+ *
+ * Bitsets are arrays of 64-bit words, bit i lives in word i / 64 at position
+ * i % 64. Single bit accessors are inlined, bulk operations are dispatched at
+ * runtime to the best implementation supported by the CPU.
+ */
+
+#ifndef SEALLOC_BITSET_H_
+#define SEALLOC_BITSET_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*!
+ * @brief Number of 64-bit words needed to hold nbits bits.
+ */
+#define BITSET_WORDS(nbits) (((nbits) + 63) / 64)
+
+/*!
+ * @brief Available implementations of bulk kernels.
+ */
+typedef enum bitset_impl {
+  BITSET_IMPL_GENERIC, /*!< Portable implementation using compiler builtins */
+  BITSET_IMPL_POPCNT,  /*!< x86 POPCNT and TZCNT instructions */
+  BITSET_IMPL_AVX2,    /*!< x86 AVX2, 256 bits per step */
+} bitset_impl_t;
+
+static inline bool bitset_get(const uint64_t *set, size_t idx) {
+  return (set[idx / 64] >> (idx % 64)) & 1;
+}
+
+static inline void bitset_set(uint64_t *set, size_t idx) {
+  set[idx / 64] |= UINT64_C(1) << (idx % 64);
+}
+
+static inline void bitset_clear(uint64_t *set, size_t idx) {
+  set[idx / 64] &= ~(UINT64_C(1) << (idx % 64));
+}
+
+/*!
+ * @brief Counts set bits.
+ *
+ * @param[in] set Bitset to count.
+ * @param[in] words Length of the bitset in words.
+ * @return Number of set bits.
+ */
+size_t bitset_count(const uint64_t *set, size_t words);
+
+/*!
+ * @brief Counts bits set in a and clear in b.
+ *
+ * @param[in] a First bitset.
+ * @param[in] b Second bitset.
+ * @param[in] words Length of both bitsets in words.
+ * @return Number of set bits in (a & ~b).
+ */
+size_t bitset_count_andnot(const uint64_t *a, const uint64_t *b, size_t words);
+
+/*!
+ * @brief Finds first set bit at index >= start.
+ *
+ * @param[in] set Bitset to search.
+ * @param[in] words Length of the bitset in words.
+ * @param[in] start Index where the search begins.
+ * @return Index of the found bit or SIZE_MAX if there is none.
+ */
+size_t bitset_find_next(const uint64_t *set, size_t words, size_t start);
+
+/*!
+ * @brief Finds first bit at index >= start that is set in a and clear in b.
+ *
+ * @param[in] a First bitset.
+ * @param[in] b Second bitset.
+ * @param[in] words Length of both bitsets in words.
+ * @param[in] start Index where the search begins.
+ * @return Index of the found bit or SIZE_MAX if there is none.
+ */
+size_t bitset_find_next_andnot(const uint64_t *a, const uint64_t *b,
+                               size_t words, size_t start);
+
+/*!
+ * @brief Returns the fastest implementation supported by the CPU.
+ */
+bitset_impl_t bitset_best_impl(void);
+
+/*!
+ * @brief Switches bulk kernels to given implementation.
+ *
+ * Best implementation is selected automatically when library is loaded.
+ *
+ * @param[in] impl Implementation to use.
+ * @return false if CPU does not support impl, selection is unchanged then.
+ */
+bool bitset_select_impl(bitset_impl_t impl);
+
+#endif /* SEALLOC_BITSET_H_ */
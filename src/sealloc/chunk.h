@@ -13,6 +13,7 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "bitset.h"
 #include "container_ll.h"
 #include "utils.h"
 struct run_state;
@@ -43,7 +44,8 @@ typedef struct run_state run_t;
 /*!
  * @brief Arbitrary point where we unmap part of the chunk
  *
- * Right now we are unmapping at least 32 pages
+ * Freed run memory is unmapped once it coalesces into a node this many levels
+ * above leaves, or into the root. Right now we are unmapping every freed run.
  */
 #define CHUNK_UNMAP_THRESHOLD 0
 
@@ -55,6 +57,32 @@ typedef struct run_state run_t;
  */
 #define REG_MARK_BAD_VALUE 65535
 
+/*!
+ * @brief Marks first leaf of a large run, low bits hold size order of the run
+ *
+ * Large runs carry no other metadata, run of size
+ * CHUNK_LEAST_REGION_SIZE_BYTES << order is marked with (REG_MARK_LARGE |
+ * order).
+ */
+#define REG_MARK_LARGE 0x8000
+#define REG_MARK_LARGE_ORDER_MASK 0x00ff
+
+/*!
+ * @brief Marks first leaf of a run owned by an object pool, low bits hold
+ * reg_size of the pool.
+ *
+ * Pool runs are not known to arena bins, so lookups through arena treat them
+ * as invalid.
+ */
+#define REG_MARK_POOL 0x4000
+#define REG_MARK_POOL_SIZE_MASK 0x3fff
+/*!
+ * @brief True if m is a pool mark, sizes of large classes never match.
+ */
+#define REG_MARK_IS_POOL(m)                                      \
+  (((m) & ~(unsigned)REG_MARK_POOL_SIZE_MASK) == REG_MARK_POOL && \
+   ((m) & REG_MARK_POOL_SIZE_MASK) != 0)
+
 #define RANDOM_LOOKUP_TRESHOLD_PERCENTAGE 25
 #define RANDOM_LOOKUP_TRIES 4
 
@@ -75,10 +103,11 @@ struct chunk_state {
                                                     allocation in i-th row of
                                                     the tree, if 0 then corresponding jump_tree_first_index is also 0*/
   uint16_t
-      reg_size_small_medium[CHUNK_NO_NODES_LAST_LAYER]; /*!<  Stores (reg_size /
-                                                           16) for small and
-                                                           medium size class
-                                                           ONLY */
+      reg_size_small_medium[CHUNK_NO_NODES_LAST_LAYER]; /*!<  Stores reg_size
+                                                           for small and
+                                                           medium size class,
+                                                           REG_MARK_LARGE mark
+                                                           for large runs */
   unsigned jump_tree_first_index[CHUNK_BUDDY_TREE_DEPTH +
                                  1]; /*!< Array of starting global indexes of
                                         free nodes in each level, 0 if level
@@ -88,6 +117,20 @@ struct chunk_state {
               and next pointing at prev/next free element in the same row */
   uint8_t buddy_tree[CHUNK_BUDDY_TREE_SIZE_BYTES]; /*<! Segment tree state for
                                                       binary buddy algorithm */
+  uint8_t random_lookup_tries; /*!< Random probes for a free node before
+                                  walking free list, RANDOM_LOOKUP_TRIES by
+                                  default */
+  uint8_t random_lookup_threshold; /*!< Percentage of free nodes on a level
+                                      above which random probes are tried */
+  uint8_t unmap_threshold; /*!< Freed nodes are unmapped from this many levels
+                              above leaves, CHUNK_UNMAP_THRESHOLD by default */
+  uint64_t prof_leaves[BITSET_WORDS(
+      CHUNK_NO_NODES_LAST_LAYER)]; /*!< Leaves holding regions sampled by
+                                      profiler, never cleared since regions
+                                      are not reused */
+  run_t *runs[CHUNK_NO_NODES_LAST_LAYER]; /*!< Metadata of run starting at
+                                             each leaf, NULL for large runs
+                                             and other leaves */
 };
 typedef struct chunk_state chunk_t;
 
@@ -109,12 +152,14 @@ void chunk_init(chunk_t *chunk, void *heap);
  *
  * @param[in,out] chunk Pointer to the allocated chunk structure.
  * @param[in] run_size How much memory to allocate
- * @param[in] reg_size Additional run info to link with allocated run pointer
+ * @param[in] reg_size Additional run info to link with allocated run pointer,
+ * pool runs pass (REG_MARK_POOL | reg_size)
  * @return NULL if not enough memory, pointer to at least run_size bytes
  * otherwise
  * @pre chunk is initialized
  * @pre CHUNK_LEAST_REGION_SIZE_BYTES <= run_size <= CHUNK_SIZE_BYTES
- * @pre reg_size is aligned to size within its size class
+ * @pre reg_size is aligned to size within its size class or carries
+ * REG_MARK_POOL
  */
 void *chunk_allocate_run(chunk_t *chunk, unsigned run_size, unsigned reg_size);
 
@@ -130,6 +175,126 @@ void *chunk_allocate_run(chunk_t *chunk, unsigned run_size, unsigned reg_size);
  */
 bool chunk_deallocate_run(chunk_t *chunk, void *run_ptr);
 
+/*!
+ * @brief Unmaps freed runs kept mapped below chunk unmap threshold.
+ *
+ * @param[in,out] chunk Pointer to the allocated chunk structure.
+ * @returns Number of bytes unmapped, chunk may become fully unmapped
+ * @pre chunk is initialized
+ */
+size_t chunk_decommit(chunk_t *chunk);
+
+/*!
+ * @brief Marks leaf holding region as sampled by profiler.
+ *
+ * @param[in,out] chunk Pointer to the allocated chunk structure.
+ * @param[in] ptr Pointer to region within the chunk.
+ * @pre chunk is initialized
+ */
+void chunk_mark_sampled(chunk_t *chunk, const void *ptr);
+
+/*!
+ * @brief Checks if leaf holding region holds sampled regions.
+ *
+ * Other regions sharing the leaf with sampled one are reported too.
+ *
+ * @param[in] chunk Pointer to the allocated chunk structure.
+ * @param[in] ptr Pointer to region within the chunk.
+ * @return true if leaf was marked with chunk_mark_sampled().
+ * @pre chunk is initialized
+ */
+bool chunk_is_sampled(const chunk_t *chunk, const void *ptr);
+
+/*!
+ * @brief Links run metadata with run memory.
+ *
+ * @param[in,out] chunk Pointer to the allocated chunk structure.
+ * @param[in] run_ptr Pointer to a valid run in a chunk.
+ * @param[in] run Run metadata, found by chunk_get_run() until the run is
+ * deallocated.
+ * @pre chunk is initialized
+ * @pre run_ptr is a valid pointer acquired from chunk_allocate_run
+ */
+void chunk_set_run(chunk_t *chunk, const void *run_ptr, run_t *run);
+
+/*!
+ * @brief Gets metadata of run of given size containing ptr.
+ *
+ * Runs are aligned to their size within chunk, so only run starting at ptr
+ * rounded down to run_size can contain it.
+ *
+ * @param[in] chunk Pointer to the allocated chunk structure.
+ * @param[in] ptr Pointer within the chunk.
+ * @param[in] run_size Size of the run, power of 2.
+ * @return Metadata linked with chunk_set_run(), NULL if there is none.
+ * @pre chunk is initialized
+ * @pre CHUNK_LEAST_REGION_SIZE_BYTES <= run_size <= CHUNK_SIZE_BYTES
+ */
+run_t *chunk_get_run(const chunk_t *chunk, const void *ptr, unsigned run_size);
+
+/*!
+ * @brief Memory usage of chunks.
+ */
+typedef struct chunk_usage {
+  size_t run_bytes;      /*!< Memory of runs in use */
+  size_t depleted_bytes; /*!< Memory of freed runs still mapped */
+  size_t unmapped_bytes; /*!< Memory of freed runs returned to system */
+  unsigned nlarge[CHUNK_BUDDY_TREE_DEPTH + 1]; /*!< Number of large regions of
+                                                  each order */
+  unsigned nruns[CHUNK_BUDDY_TREE_DEPTH + 1]; /*!< Number of runs in use of
+                                                 each order, runs of order k
+                                                 span 2^k leaves */
+  unsigned nsegments; /*!< Mapped ranges separated by unmapped runs */
+} chunk_usage_t;
+
+/*!
+ * @brief Adds memory usage of a chunk to usage.
+ *
+ * @param[in] chunk Pointer to the allocated chunk structure.
+ * @param[in,out] usage Usage to add to.
+ * @pre chunk is initialized
+ */
+void chunk_get_usage(chunk_t *chunk, chunk_usage_t *usage);
+
+/*!
+ * @brief Checks if nothing was ever allocated from the chunk.
+ *
+ * @param[in] chunk Pointer to the allocated chunk structure.
+ * @returns True if chunk is unused, false otherwise
+ * @pre chunk is initialized
+ */
+bool chunk_is_empty(chunk_t *chunk);
+
+/*!
+ * @brief Unmaps whole memory of unused chunk.
+ *
+ * @param[in,out] chunk Pointer to the allocated chunk structure.
+ * @pre chunk_is_empty(chunk)
+ * @post chunk is fully unmapped
+ */
+void chunk_release(chunk_t *chunk);
+
+/*!
+ * @brief Grows large run in place by merging it with free buddies.
+ *
+ * Run is merged with its right buddy as long as the buddy was never allocated
+ * and the run stays within max_run_size. Nothing is changed if min_run_size
+ * cannot be reached.
+ *
+ * @param[in,out] chunk Pointer to the allocated chunk structure.
+ * @param[in] run_ptr Pointer to a valid large run in a chunk.
+ * @param[in] run_size Current size of the run.
+ * @param[in] min_run_size Smallest acceptable size of the run, power of 2.
+ * @param[in] max_run_size Biggest wanted size of the run, power of 2.
+ * @return New size of the run, run_size if it was not grown.
+ * @pre chunk is initialized
+ * @pre run_ptr is a valid pointer acquired from chunk_allocate_run for large
+ * class
+ * @pre run_size <= min_run_size <= max_run_size
+ */
+unsigned chunk_expand_run(chunk_t *chunk, void *run_ptr, unsigned run_size,
+                          unsigned min_run_size, unsigned max_run_size);
+
 /*!
  * @brief check if chunk is unmapped
  *
@@ -162,7 +327,7 @@ bool chunk_is_full(chunk_t *chunk);
  * @param[out] run_ptr Pointer to run memory.
  * @param[out] run_size Run size of found run.
  * @param[out] reg_size Reg size of found run. Aligned to size in its size
- * class.
+ * class. Left as 0 for large runs.
  * @pre chunk is initialized
  * @pre *run_ptr is NULL
  * @pre *run_size is 0
@@ -0,0 +1,97 @@
+/*!
+ * @file conf.h
+ * @brief Runtime tuning of allocator policy.
+ *
+ * Policy constants can be overridden with a string of comma separated
+ * key:value pairs, for example "bin_min_regions:64,chunks_per_mapping:8".
+ * Arena reads it from SEALLOC_CONF environment variable on initialization.
+ * Parsing does not allocate, so it is safe before any heap exists.
+ */
+
+#ifndef SEALLOC_CONF_H_
+#define SEALLOC_CONF_H_
+
+#include <stdbool.h>
+
+/*!
+ * @brief Name of environment variable holding configuration string.
+ */
+#define CONF_ENV_NAME "SEALLOC_CONF"
+
+/*!
+ * @brief Biggest run size of small and medium classes.
+ *
+ * Small runs of that size hold as many regions as fit into run_t counters.
+ */
+#define CONF_RUN_SIZE_MAX_BYTES 524288
+
+/*!
+ * @brief Values of tunable policy constants.
+ *
+ * Defaults are the compile-time constants, each field lists its key.
+ */
+typedef struct arena_conf {
+  unsigned bin_min_regions;      /*!< bin_min_regions, regions bin keeps
+                                    available, BIN_MINIMUM_REGIONS */
+  unsigned chunks_per_mapping;   /*!< chunks_per_mapping, chunks mapped at
+                                    once, CHUNKS_PER_MAPPING */
+  unsigned run_size_small_pages; /*!< run_size_small, run size in bytes for
+                                    small classes, RUN_SIZE_SMALL_BYTES */
+  unsigned run_size_medium_pages; /*!< run_size_medium, run size in bytes for
+                                     medium classes, RUN_SIZE_MEDIUM_BYTES */
+  unsigned random_lookup_tries;   /*!< random_lookup_tries, random probes for
+                                     a free run, RANDOM_LOOKUP_TRIES */
+  unsigned random_lookup_threshold; /*!< random_lookup_threshold, percentage
+                                       of free runs above which random probes
+                                       are tried,
+                                       RANDOM_LOOKUP_TRESHOLD_PERCENTAGE */
+  unsigned chunk_unmap_threshold; /*!< chunk_unmap_threshold, tree levels
+                                     above leaves from which freed run memory
+                                     is unmapped, CHUNK_UNMAP_THRESHOLD */
+  unsigned prof_interval; /*!< prof_interval, mean bytes between sampled
+                             allocations, 0 disables heap profiling,
+                             PROF_DEFAULT_INTERVAL */
+} arena_conf_t;
+
+/*!
+ * @brief Fills configuration with compile-time defaults.
+ *
+ * @param[out] conf Pointer to configuration structure.
+ */
+void conf_init(arena_conf_t *conf);
+
+/*!
+ * @brief Applies configuration string on top of current values.
+ *
+ * Unknown keys and values out of range are reported and skipped, the rest of
+ * the string is still applied. Run sizes are given in bytes and must be power
+ * of 2 multiples of CHUNK_LEAST_REGION_SIZE_BYTES up to
+ * CONF_RUN_SIZE_MAX_BYTES.
+ *
+ * @param[in,out] conf Pointer to initialized configuration structure.
+ * @param[in] str Configuration string.
+ * @return True if every entry was applied.
+ */
+bool conf_parse(arena_conf_t *conf, const char *str);
+
+/*!
+ * @brief Reads single value in units of configuration string.
+ *
+ * @param[in] conf Pointer to initialized configuration structure.
+ * @param[in] name Key of the value.
+ * @param[out] val Current value, run sizes are in bytes.
+ * @return False if key is unknown.
+ */
+bool conf_get(const arena_conf_t *conf, const char *name, unsigned *val);
+
+/*!
+ * @brief Sets single value with the same checks as conf_parse().
+ *
+ * @param[in,out] conf Pointer to initialized configuration structure.
+ * @param[in] name Key of the value.
+ * @param[in] val New value, run sizes are in bytes.
+ * @return False if key is unknown or value is out of range.
+ */
+bool conf_set(arena_conf_t *conf, const char *name, unsigned val);
+
+#endif /* SEALLOC_CONF_H_ */
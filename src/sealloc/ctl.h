@@ -0,0 +1,37 @@
+/*!
+ * @file ctl.h
+ * @brief Runtime control of a running allocator.
+ *
+ * Values are addressed by dot separated names, for example
+ * "arena.0.bins.12.min_regions". Numeric components index arenas and bins.
+ * Reading and writing follows mallctl() convention, old value is copied to
+ * oldp if it is given and new value is taken from newp if it is given. Both
+ * lengths must match the size of the value type. Lookup walks static tables
+ * and does not allocate.
+ */
+
+#ifndef SEALLOC_CTL_H_
+#define SEALLOC_CTL_H_
+
+#include <stddef.h>
+
+#include "arena.h"
+
+/*!
+ * @brief Reads or writes value addressed by name.
+ *
+ * @param[in,out] arena Pointer to the arena with index 0.
+ * @param[in] name Dot separated name of the value.
+ * @param[out] oldp Buffer for current value or NULL.
+ * @param[in,out] oldlenp Size of oldp buffer, set to size of the value.
+ * @param[in] newp New value or NULL.
+ * @param[in] newlen Size of new value.
+ * @return 0 on success, ENOENT if name does not exist, EINVAL if length or
+ * value is invalid, EPERM if value is read-only, EIO if histogram dump
+ * couldn't be written.
+ * @pre arena is initialized
+ */
+int ctl_by_name(arena_t *arena, const char *name, void *oldp, size_t *oldlenp,
+                const void *newp, size_t newlen);
+
+#endif /* SEALLOC_CTL_H_ */
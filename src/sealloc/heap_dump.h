@@ -0,0 +1,114 @@
+/*!
+ * @file heap_dump.h
+ * @brief Binary dump of heap layout.
+ *
+ * Dump starts with heap_dump_header_t, which is followed by records, each one
+ * starting with heap_dump_record_t and ending with HEAP_DUMP_END. Record
+ * payloads are padded to 8 bytes. Dumps may be appended to the same file one
+ * after another to follow the heap over time. All values are in native byte
+ * order.
+ *
+ * Payloads:
+ * - HEAP_DUMP_CHUNK: heap_dump_chunk_t, then the buddy tree as kept by chunk,
+ *   2 bits per node in heap order, node i (root is 1) at bits 2 * ((i - 1) % 4)
+ *   of byte (i - 1) / 4, then uint16_t mark of each leaf, see
+ *   reg_size_small_medium of chunk_t.
+ * - HEAP_DUMP_RUN: heap_dump_run_t, then state of each region, 2 bits per
+ *   region packed the same way with region 0 at bits 0 of byte 0.
+ * - HEAP_DUMP_HUGE: heap_dump_huge_t.
+ *
+ * Dumping does not allocate and writes directly to a descriptor.
+ */
+
+#ifndef SEALLOC_HEAP_DUMP_H_
+#define SEALLOC_HEAP_DUMP_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "arena.h"
+
+/*!
+ * @brief Magic bytes at the start of each dump.
+ */
+#define HEAP_DUMP_MAGIC "SEAHEAP"
+
+/*!
+ * @brief Version of dump format.
+ */
+#define HEAP_DUMP_FORMAT_VERSION 1
+
+/*!
+ * @brief Type of record.
+ */
+typedef enum heap_dump_type {
+  HEAP_DUMP_END,   /*!< Last record of a dump, no payload */
+  HEAP_DUMP_CHUNK, /*!< Buddy tree and leaf marks of chunk */
+  HEAP_DUMP_RUN,   /*!< Region states of small or medium run */
+  HEAP_DUMP_HUGE   /*!< Huge mapping */
+} heap_dump_type_t;
+
+/*!
+ * @brief Header of single dump.
+ */
+typedef struct heap_dump_header {
+  char magic[8];         /*!< HEAP_DUMP_MAGIC, zero terminated */
+  uint32_t version;      /*!< HEAP_DUMP_FORMAT_VERSION */
+  uint32_t pid;          /*!< Dumped process */
+  uint64_t timestamp;    /*!< Wall clock time of dump in nanoseconds */
+  uint32_t page_size;    /*!< PAGE_SIZE */
+  uint32_t chunk_size;   /*!< CHUNK_SIZE_BYTES */
+  uint32_t leaf_size;    /*!< CHUNK_LEAST_REGION_SIZE_BYTES */
+  uint32_t tree_depth;   /*!< CHUNK_BUDDY_TREE_DEPTH, root is at depth 0 */
+  uint32_t chunks_left;  /*!< Mapped chunks not handed out yet */
+  uint32_t pad;
+} heap_dump_header_t;
+
+/*!
+ * @brief Header of record.
+ */
+typedef struct heap_dump_record {
+  uint32_t type; /*!< One of heap_dump_type_t */
+  uint32_t len;  /*!< Bytes of payload following, multiple of 8 */
+} heap_dump_record_t;
+
+/*!
+ * @brief Fixed part of HEAP_DUMP_CHUNK payload.
+ */
+typedef struct heap_dump_chunk {
+  uint64_t addr; /*!< Start of chunk memory */
+} heap_dump_chunk_t;
+
+/*!
+ * @brief Fixed part of HEAP_DUMP_RUN payload.
+ */
+typedef struct heap_dump_run {
+  uint64_t addr;     /*!< Start of run memory */
+  uint32_t reg_size; /*!< Size of single region */
+  uint32_t nregs;    /*!< Number of regions */
+  uint32_t run_size; /*!< Size of run in bytes */
+  uint32_t retired;  /*!< 1 if run is depleted and waits for frees */
+} heap_dump_run_t;
+
+/*!
+ * @brief HEAP_DUMP_HUGE payload.
+ */
+typedef struct heap_dump_huge {
+  uint64_t addr; /*!< Start of mapping */
+  uint64_t len;  /*!< Length of mapping */
+} heap_dump_huge_t;
+
+/*!
+ * @brief Writes layout of arena heap.
+ *
+ * Runs of object pools are not known to arena and are only seen as used
+ * nodes of chunks marked with REG_MARK_POOL.
+ *
+ * @param[in] arena Pointer to the allocated arena structure.
+ * @param[in] fd Descriptor to write to.
+ * @return true on success, false if write failed.
+ * @pre arena is initialized
+ */
+bool heap_dump(arena_t *arena, int fd);
+
+#endif /* SEALLOC_HEAP_DUMP_H_ */
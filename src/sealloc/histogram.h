@@ -0,0 +1,118 @@
+/*!
+ * @file histogram.h
+ * @brief Allocation request histograms kept in memory.
+ *
+ * Each request bumps counter of its size class and of its log2 size bucket
+ * with relaxed atomic increments, nothing is written out on allocation path.
+ * Histogram is dumped as single line JSON document, which is appended to a
+ * file so that consecutive dumps of one process can be compared. Dumping does
+ * not allocate and only uses async-signal-safe calls.
+ */
+
+#ifndef SEALLOC_HISTOGRAM_H_
+#define SEALLOC_HISTOGRAM_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*!
+ * @brief Name of environment variable holding path of dump file.
+ */
+#define HIST_ENV_PATH "SEALLOC_STATS_FILE"
+
+/*!
+ * @brief Name of environment variable holding signal number triggering dump.
+ */
+#define HIST_ENV_SIGNAL "SEALLOC_STATS_SIGNAL"
+
+/*!
+ * @brief Dump file used if HIST_ENV_PATH is not set.
+ */
+#define HIST_DEFAULT_PATH "./heap_stats.sealloc"
+
+/*!
+ * @brief Version of dumped document, bumped on incompatible changes.
+ */
+#define HIST_FORMAT_VERSION 1
+
+/*!
+ * @brief Size classes counted by histogram.
+ */
+typedef enum hist_class {
+  HIST_CLASS_SMALL,  /*!< Small size class */
+  HIST_CLASS_MEDIUM, /*!< Medium size class */
+  HIST_CLASS_LARGE,  /*!< Large size class */
+  HIST_CLASS_HUGE,   /*!< Requests mapped directly */
+  HIST_NO_CLASSES
+} hist_class_t;
+
+/*!
+ * @brief Number of log2 buckets.
+ *
+ * Bucket 0 counts zero sized requests, bucket k > 0 counts sizes in
+ * [2^(k-1), 2^k).
+ */
+#define HIST_NO_BUCKETS 65
+
+/*!
+ * @brief Counters of allocation requests.
+ *
+ * All fields are updated with relaxed atomics, readers get values which may
+ * lag behind, but are never torn.
+ */
+typedef struct alloc_hist {
+  uint64_t class_count[HIST_NO_CLASSES]; /*!< Requests of each class */
+  uint64_t class_bytes[HIST_NO_CLASSES]; /*!< Requested bytes of each class */
+  uint64_t bucket_count[HIST_NO_BUCKETS]; /*!< Requests of each log2 bucket */
+} alloc_hist_t;
+
+/*!
+ * @brief Resets all counters.
+ *
+ * @param[out] hist Pointer to the histogram.
+ */
+void hist_init(alloc_hist_t *hist);
+
+/*!
+ * @brief Gets size class of request.
+ *
+ * @param[in] size Requested size.
+ * @return Size class of request.
+ */
+hist_class_t hist_class(size_t size);
+
+/*!
+ * @brief Gets log2 bucket of request.
+ *
+ * @param[in] size Requested size.
+ * @return Index of bucket, less than HIST_NO_BUCKETS.
+ */
+unsigned hist_bucket(size_t size);
+
+/*!
+ * @brief Counts single request.
+ *
+ * @param[in,out] hist Pointer to the histogram.
+ * @param[in] size Requested size.
+ */
+void hist_record(alloc_hist_t *hist, size_t size);
+
+/*!
+ * @brief Writes histogram as single line JSON document.
+ *
+ * @param[in] hist Pointer to the histogram.
+ * @param[in] fd Descriptor to write to.
+ */
+void hist_write_json(const alloc_hist_t *hist, int fd);
+
+/*!
+ * @brief Appends histogram to file.
+ *
+ * @param[in] hist Pointer to the histogram.
+ * @param[in] path Path of file, created if it does not exist.
+ * @return true on success, false if file couldn't be opened.
+ */
+bool hist_dump(const alloc_hist_t *hist, const char *path);
+
+#endif /* SEALLOC_HISTOGRAM_H_ */
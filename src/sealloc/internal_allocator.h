@@ -65,4 +65,18 @@ void *internal_alloc(int_alloc_t *ia, size_t size);
  */
 void internal_free(int_alloc_t *ia, void *ptr);
 
+/*!
+ * @brief Shrink metadata in place
+ *
+ * Block is split while its first half still holds size bytes, the other
+ * halves are given back. Pointer stays valid and can be freed as usual.
+ *
+ * @param[in,out] ia internal allocator state.
+ * @param[in] ptr ptr to metadata to shrink.
+ * @param[in] size new size of metadata.
+ * @pre ptr must come from internal_alloc();
+ * @pre size is not bigger than the size ptr was allocated with
+ */
+void internal_shrink(int_alloc_t *ia, void *ptr, size_t size);
+
 #endif /* SEALLOC_INTERNAL_ALLOCATOR_H_ */
@@ -0,0 +1,176 @@
+/*!
+ * @file latency.h
+ * @brief Latency histograms of allocator phases.
+ *
+ * Library built with LATENCY defined timestamps main phases of allocation and
+ * free with the cycle counter, or with monotonic clock where there is none,
+ * and counts the duration in log-linear buckets of its phase. Each power of
+ * two is split into LAT_SUB_BUCKETS linear buckets, so relative error of a
+ * bucket is at most 1 / LAT_SUB_BUCKETS and tail latencies are kept instead of
+ * being averaged away. Without LATENCY timing macros expand to nothing.
+ *
+ * Histograms are dumped like allocation histograms, as single line JSON
+ * document appended to a file, without allocating.
+ */
+
+#ifndef SEALLOC_LATENCY_H_
+#define SEALLOC_LATENCY_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+/*!
+ * @brief Name of environment variable holding path of dump file.
+ */
+#define LAT_ENV_PATH "SEALLOC_LATENCY_FILE"
+
+/*!
+ * @brief Dump file used if LAT_ENV_PATH is not set.
+ */
+#define LAT_DEFAULT_PATH "./latency.sealloc"
+
+/*!
+ * @brief Version of dumped document, bumped on incompatible changes.
+ */
+#define LAT_FORMAT_VERSION 1
+
+/*!
+ * @brief Log2 of number of linear buckets per power of two.
+ */
+#define LAT_SUB_BITS 3
+#define LAT_SUB_BUCKETS (1U << LAT_SUB_BITS)
+
+/*!
+ * @brief Number of buckets covering whole range of 64-bit durations.
+ *
+ * Durations below LAT_SUB_BUCKETS have a bucket each, every following power
+ * of two has LAT_SUB_BUCKETS buckets.
+ */
+#define LAT_NO_BUCKETS ((64 - LAT_SUB_BITS + 1) * LAT_SUB_BUCKETS)
+
+/*!
+ * @brief Timed phase of allocator operation.
+ */
+typedef enum lat_phase {
+  LAT_MALLOC_SIZE_CLASS,    /*!< Rounding size and finding its bin */
+  LAT_MALLOC_SUPPLY_RUNS,   /*!< Refilling bin with arena_supply_runs() */
+  LAT_MALLOC_RUN_SELECT,    /*!< Choosing run of the bin */
+  LAT_MALLOC_REGION_SELECT, /*!< Choosing region within the run */
+  LAT_FREE_LOCATE,          /*!< Finding metadata of freed pointer */
+  LAT_FREE_RELEASE,         /*!< Releasing region and emptied run or chunk */
+  LAT_MORECORE,             /*!< Mapping memory, including probe retries */
+  LAT_CHUNK_INIT,           /*!< Initializing chunk metadata */
+  LAT_NO_PHASES
+} lat_phase_t;
+
+/*!
+ * @brief Histograms of all phases.
+ *
+ * Counters are updated with relaxed atomics, same as alloc_hist_t.
+ */
+typedef struct lat_hist {
+  uint64_t count[LAT_NO_PHASES][LAT_NO_BUCKETS]; /*!< Durations in ticks */
+  uint64_t start_ticks; /*!< Ticks at initialization, to calibrate ticks */
+  uint64_t start_ns;    /*!< Monotonic time at initialization */
+} lat_hist_t;
+
+/*!
+ * @brief Reads the tick counter.
+ *
+ * Ticks are time stamp counter cycles on x86, virtual counter ticks on ARM64
+ * and nanoseconds elsewhere. Reads are not serializing, which is good enough
+ * for durations of at least tens of ticks.
+ *
+ * @return Current tick.
+ */
+static inline uint64_t lat_now(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  return __builtin_ia32_rdtsc();
+#elif defined(__aarch64__)
+  uint64_t val;
+  __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(val));
+  return val;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/*!
+ * @brief Gets bucket of duration.
+ *
+ * @param[in] ticks Duration in ticks.
+ * @return Index of bucket, less than LAT_NO_BUCKETS.
+ */
+static inline unsigned lat_bucket(uint64_t ticks) {
+  unsigned exp;
+  if (ticks < LAT_SUB_BUCKETS) return (unsigned)ticks;
+  exp = 63 - (unsigned)__builtin_clzll((unsigned long long)ticks);
+  return (exp - LAT_SUB_BITS + 1) * LAT_SUB_BUCKETS +
+         (unsigned)((ticks >> (exp - LAT_SUB_BITS)) & (LAT_SUB_BUCKETS - 1));
+}
+
+/*!
+ * @brief Gets the smallest duration counted by bucket.
+ *
+ * @param[in] bucket Index of bucket, less than LAT_NO_BUCKETS.
+ * @return Lower bound of bucket in ticks.
+ */
+uint64_t lat_bucket_lower(unsigned bucket);
+
+/*!
+ * @brief Resets all counters and calibration point.
+ *
+ * @param[out] hist Pointer to the histograms.
+ */
+void lat_init(lat_hist_t *hist);
+
+/*!
+ * @brief Counts single duration of phase.
+ *
+ * @param[in,out] hist Pointer to the histograms.
+ * @param[in] phase Timed phase.
+ * @param[in] ticks Duration in ticks.
+ */
+static inline void lat_record(lat_hist_t *hist, lat_phase_t phase,
+                              uint64_t ticks) {
+  __atomic_fetch_add(&hist->count[phase][lat_bucket(ticks)], 1,
+                     __ATOMIC_RELAXED);
+}
+
+/*!
+ * @brief Writes histograms as single line JSON document.
+ *
+ * Only non-empty buckets are written, as pairs of lower bound and count.
+ *
+ * @param[in] hist Pointer to the histograms.
+ * @param[in] fd Descriptor to write to.
+ */
+void lat_write_json(const lat_hist_t *hist, int fd);
+
+/*!
+ * @brief Appends histograms to file.
+ *
+ * @param[in] hist Pointer to the histograms.
+ * @param[in] path Path of file, created if it does not exist.
+ * @return true on success, false if file couldn't be opened.
+ */
+bool lat_dump(const lat_hist_t *hist, const char *path);
+
+#ifdef LATENCY
+#define se_lat_start(var) const uint64_t var = lat_now()
+#define se_lat_end(arena, phase, var) \
+  lat_record(&(arena)->latency, phase, lat_now() - (var))
+#else
+#define se_lat_start(var) \
+  do {                    \
+  } while (0)
+#define se_lat_end(arena, phase, var) \
+  do {                                \
+  } while (0)
+#endif
+
+#endif /* SEALLOC_LATENCY_H_ */
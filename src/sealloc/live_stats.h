@@ -0,0 +1,173 @@
+/*!
+ * @file live_stats.h
+ * @brief Statistics published to shared memory.
+ *
+ * With SEALLOC_LIVE_STATS set, process keeps snapshot of arena statistics in
+ * /dev/shm/sealloc.<pid>, which other processes, like sealloc-top, map
+ * read-only. Segment is readable only by its owner unless
+ * SEALLOC_LIVE_STATS_SHARED is set too. Every LIVE_CHECK_OPS API calls clock
+ * is read and snapshot is collected again if the interval passed, so an idle
+ * process keeps its last snapshot.
+ *
+ * Snapshot is guarded by sequence counter, which is odd while snapshot is
+ * written. Reader copies the snapshot between two reads of the counter and
+ * retries if they differ or are odd.
+ */
+
+#ifndef SEALLOC_LIVE_STATS_H_
+#define SEALLOC_LIVE_STATS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "arena.h"
+#include "stats.h"
+
+/*!
+ * @brief Name of environment variable enabling publishing.
+ *
+ * Value is interval between snapshots in milliseconds.
+ */
+#define LIVE_ENV "SEALLOC_LIVE_STATS"
+
+/*!
+ * @brief Name of environment variable making segment world-readable.
+ */
+#define LIVE_ENV_SHARED "SEALLOC_LIVE_STATS_SHARED"
+
+/*!
+ * @brief Prefix of segment path, followed by pid.
+ */
+#define LIVE_PATH_PREFIX "/dev/shm/sealloc."
+
+/*!
+ * @brief Magic bytes at the start of segment.
+ */
+#define LIVE_MAGIC "SEALIVE"
+
+/*!
+ * @brief Version of segment layout.
+ */
+#define LIVE_FORMAT_VERSION 1
+
+/*!
+ * @brief API calls between reads of the clock.
+ */
+#define LIVE_CHECK_OPS 1024
+
+/*!
+ * @brief Longest path of segment, with terminating zero.
+ */
+#define LIVE_PATH_MAX 32
+
+/*!
+ * @brief Layout of shared memory segment.
+ */
+typedef struct live_segment {
+  char magic[8];        /*!< LIVE_MAGIC, zero terminated */
+  uint32_t version;     /*!< LIVE_FORMAT_VERSION */
+  uint32_t size;        /*!< sizeof(live_segment_t) */
+  uint32_t pid;         /*!< Publishing process */
+  uint32_t interval_ms; /*!< Interval between snapshots */
+  uint64_t seq;         /*!< Odd while snapshot is being written */
+  uint64_t timestamp;   /*!< Monotonic time of snapshot in nanoseconds */
+  uint64_t nallocs;     /*!< Allocating API calls, realloc included */
+  uint64_t nfrees;      /*!< Freeing API calls */
+  arena_stats_t stats;  /*!< Arena statistics */
+} live_segment_t;
+
+/*!
+ * @brief State of publishing process.
+ */
+typedef struct live_stats {
+  live_segment_t *seg;      /*!< Mapped segment, NULL if closed or detached */
+  uint64_t interval_ns;     /*!< Interval between snapshots */
+  uint64_t last;            /*!< Monotonic time of last snapshot */
+  uint64_t nallocs;         /*!< Allocating API calls */
+  uint64_t nfrees;          /*!< Freeing API calls */
+  unsigned nops;            /*!< Calls since clock was read */
+  bool shared;              /*!< Segment is readable by other users */
+  char path[LIVE_PATH_MAX]; /*!< Path of segment */
+} live_stats_t;
+
+/*!
+ * @brief Formats path of segment of a process.
+ *
+ * @param[in] pid Publishing process.
+ * @param[out] buf Buffer of LIVE_PATH_MAX bytes.
+ */
+void live_stats_path(unsigned pid, char *buf);
+
+/*!
+ * @brief Creates segment of current process and publishes first snapshot.
+ *
+ * Stale file at the path is removed first and segment is created exclusively,
+ * so the call fails if something else takes the path in between.
+ *
+ * @param[out] live Pointer to the state.
+ * @param[in] arena Pointer to the arena whose statistics are published.
+ * @param[in] interval_ms Interval between snapshots, 0 collects one every
+ * LIVE_CHECK_OPS calls.
+ * @param[in] shared true makes segment world-readable, otherwise only owner
+ * can read it.
+ * @return true on success, false if segment couldn't be created.
+ * @pre arena is initialized
+ */
+bool live_stats_open(live_stats_t *live, arena_t *arena, unsigned interval_ms,
+                     bool shared);
+
+/*!
+ * @brief Collects snapshot into segment.
+ *
+ * @param[in,out] live Pointer to open state.
+ * @param[in] arena Pointer to the arena whose statistics are published.
+ */
+void live_stats_publish(live_stats_t *live, arena_t *arena);
+
+/*!
+ * @brief Publishes snapshot if interval passed since the last one.
+ *
+ * Detached state creates segment of current process instead. Arena stops
+ * publishing if that fails.
+ *
+ * @param[in,out] live Pointer to open state.
+ * @param[in] arena Pointer to the arena whose statistics are published.
+ */
+void live_stats_check(live_stats_t *live, arena_t *arena);
+
+/*!
+ * @brief Counts API call.
+ *
+ * @param[in,out] live Pointer to the state, NULL if publishing is disabled.
+ * @param[in] arena Pointer to the arena whose statistics are published.
+ * @param[in] is_free true for freeing calls.
+ */
+static inline void live_stats_tick(live_stats_t *live, arena_t *arena,
+                                   bool is_free) {
+  if (__builtin_expect(live == NULL, 1)) return;
+  if (is_free)
+    live->nfrees++;
+  else
+    live->nallocs++;
+  if (++live->nops == LIVE_CHECK_OPS) live_stats_check(live, arena);
+}
+
+/*!
+ * @brief Unmaps and removes segment.
+ *
+ * @param[in,out] live Pointer to open or detached state, closed on return.
+ */
+void live_stats_close(live_stats_t *live);
+
+/*!
+ * @brief Unmaps segment inherited by forked child, file is left to parent.
+ *
+ * Counters start from zero and segment of the child is created by the first
+ * live_stats_check(), so children which exec right away leave nothing behind.
+ *
+ * @param[in,out] live Pointer to the state, detached on return.
+ */
+void live_stats_detach(live_stats_t *live);
+
+#endif /* SEALLOC_LIVE_STATS_H_ */
@@ -19,6 +19,21 @@ typedef enum status_code {
   PLATFORM_DIFFERENT_ADDRESS
 } platform_status_code_t;
 
+/*!
+ * @brief Number of calls made to platform mapping functions.
+ *
+ * Counters are process-wide and count calls, including failed ones.
+ */
+typedef struct platform_counters {
+  size_t nmap;         /*!< platform_map() calls */
+  size_t nprobe;       /*!< Mapping attempts made by probing functions */
+  size_t nprobe_retry; /*!< Probing attempts which hit existing mapping */
+  size_t nunmap;       /*!< platform_unmap() calls */
+  size_t nguard;       /*!< platform_guard() calls */
+  size_t nunguard;     /*!< platform_unguard() calls */
+  size_t nexpand;      /*!< platform_expand_in_place() calls */
+} platform_counters_t;
+
 #ifdef __aarch64__
 extern int is_mte_enabled;
 #endif
@@ -31,6 +46,13 @@ extern int is_mte_enabled;
  */
 const char *platform_strerror(platform_status_code_t code);
 
+/*!
+ * @brief Copies current call counters.
+ *
+ * @param[out] counters Storage for counters.
+ */
+void platform_get_counters(platform_counters_t *counters);
+
 /*!
  * @brief Allocates a mapping from the operating system.
  *
@@ -67,6 +89,41 @@ platform_status_code_t platform_get_program_break(void **result);
 platform_status_code_t platform_map_probe(volatile uintptr_t *probe, uintptr_t ceiling,
                                           size_t len);
 
+/*!
+ * @brief Allocates a mapping aligned to alignment from the operating system,
+ * by probing incrementally at aligned addresses.
+ *
+ * @param[in, out] probe Start probe parameter, updated to new mapping address
+ * @param[in] ceiling Maximum address for a mapping (exclusive).
+ * @param[in] len Length of requested mapping
+ * @param[in] alignment Alignment of the mapping, power of 2
+ * @return error code.
+ * @pre probe is page-aligned
+ * @pre len is page-aligned
+ * @pre alignment is a power of 2 and at least PAGE_SIZE
+ * @warning On PLATFORM_DIFFERENT_ADDRESS mapping may be unaligned.
+ */
+platform_status_code_t platform_map_probe_aligned(volatile uintptr_t *probe,
+                                                  uintptr_t ceiling, size_t len,
+                                                  size_t alignment);
+
+/*!
+ * @brief Grows a mapping without moving it.
+ *
+ * Succeeds only if gap bytes after the grown mapping are not mapped either,
+ * so that the mapping does not touch its neighbour.
+ *
+ * @param[in] ptr Pointer to existing mapping
+ * @param[in] len Page-aligned length of the mapping
+ * @param[in] new_len Page-aligned length of grown mapping
+ * @param[in] gap Page-aligned length of space left free after the mapping
+ * @return error code.
+ * @pre len < new_len
+ * @post Mapping spans new_len bytes iff return code is PLATFORM_STATUS_OK
+ */
+platform_status_code_t platform_expand_in_place(void *ptr, size_t len,
+                                                size_t new_len, size_t gap);
+
 /*!
  * @brief Unmaps/decommits page-aligned piece of memory
  *
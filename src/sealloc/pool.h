@@ -0,0 +1,89 @@
+/*!
+ * @file pool.h
+ * @brief Object pools, dedicated bins for objects of single fixed size.
+ *
+ * Pool owns a bin which is not part of arena bins. Its region size is the
+ * object size rounded only to requested alignment and its run size is tuned to
+ * the object size, so objects are packed tighter than in size classes. Runs
+ * still come from arena chunks and keep randomized allocation order and double
+ * free detection.
+ */
+
+#ifndef SEALLOC_POOL_H_
+#define SEALLOC_POOL_H_
+
+#include <stddef.h>
+
+#include "arena.h"
+#include "bin.h"
+#include "chunk.h"
+#include "size_class.h"
+
+/*!
+ * @brief Smallest object size, smaller objects are rounded up to it.
+ */
+#define POOL_MIN_OBJ_SIZE 8
+
+/*!
+ * @brief Biggest object size pool can hold.
+ */
+#define POOL_MAX_OBJ_SIZE MEDIUM_SIZE_MAX_REGION
+
+/*!
+ * @brief Biggest run size considered when tuning run size.
+ */
+#define POOL_RUN_SIZE_MAX_BYTES (16 * CHUNK_LEAST_REGION_SIZE_BYTES)
+
+/*!
+ * @brief Run is big enough once it holds this many objects.
+ */
+#define POOL_MIN_REGIONS_PER_RUN 32
+
+/*!
+ * @brief Run is tight enough once at most 1 / 2^POOL_MAX_WASTE_SHIFT of it is
+ * left unused at its tail.
+ */
+#define POOL_MAX_WASTE_SHIFT 6
+
+/*!
+ * @brief Holds state of object pool.
+ */
+struct pool_state {
+  bin_t bin;       /*!< Bin of the pool, not reachable from arena */
+  arena_t *arena;  /*!< Arena which supplies chunks for pool runs */
+};
+typedef struct pool_state pool_t;
+
+/*!
+ * @brief Computes region size for objects of given size and alignment.
+ *
+ * @param[in] obj_size Size of single object.
+ * @param[in] align Alignment of objects, power of 2 or 0 for POOL_MIN_OBJ_SIZE.
+ * @return Region size or 0 if objects cannot be pooled.
+ */
+unsigned pool_reg_size(size_t obj_size, size_t align);
+
+/*!
+ * @brief Chooses run size for given region size.
+ *
+ * Picks smallest run which holds at least POOL_MIN_REGIONS_PER_RUN regions
+ * and wastes at most 1 / 2^POOL_MAX_WASTE_SHIFT of its memory, or the biggest
+ * considered run if there is none.
+ *
+ * @param[in] reg_size Region size of the pool.
+ * @return Number of pages of the run.
+ * @pre POOL_MIN_OBJ_SIZE <= reg_size <= POOL_MAX_OBJ_SIZE
+ */
+unsigned pool_run_size_pages(unsigned reg_size);
+
+/*!
+ * @brief Initializes an uninitialized pool structure.
+ *
+ * @param[in,out] pool Pointer to the allocated pool structure.
+ * @param[in] arena Arena which will supply memory for runs.
+ * @param[in] reg_size Region size as returned by pool_reg_size().
+ * @pre arena is initialized
+ */
+void pool_init(pool_t *pool, arena_t *arena, unsigned reg_size);
+
+#endif /* SEALLOC_POOL_H_ */
@@ -0,0 +1,40 @@
+/*!
+ * @file probes.h
+ * @brief USDT probes of provider sealloc.
+ *
+ * Probes are placed with sys/sdt.h if library is built with PROBES defined.
+ * Unattached probe is a single nop and its arguments are only described in
+ * ELF notes, so probes are cheap enough for hot paths. Without PROBES macros
+ * expand to nothing.
+ *
+ * Probes and their arguments:
+ * - malloc_entry(size), malloc_exit(size, ptr)
+ * - free_entry(ptr), free_exit(ptr)
+ * - run_create(run_ptr, reg_size, run_size), run_retire(run_ptr, reg_size)
+ * - chunk_create(chunk_ptr, mapped), chunk_destroy(chunk_ptr)
+ * - morecore_retry(probe_ptr, size, status)
+ * - unmap(ptr, len)
+ */
+
+#ifndef SEALLOC_PROBES_H_
+#define SEALLOC_PROBES_H_
+
+#ifdef PROBES
+#include <sys/sdt.h>
+
+#define se_probe1(name, a) DTRACE_PROBE1(sealloc, name, a)
+#define se_probe2(name, a, b) DTRACE_PROBE2(sealloc, name, a, b)
+#define se_probe3(name, a, b, c) DTRACE_PROBE3(sealloc, name, a, b, c)
+#else
+#define se_probe1(name, a) \
+  do {                     \
+  } while (0)
+#define se_probe2(name, a, b) \
+  do {                        \
+  } while (0)
+#define se_probe3(name, a, b, c) \
+  do {                           \
+  } while (0)
+#endif
+
+#endif /* SEALLOC_PROBES_H_ */
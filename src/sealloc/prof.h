@@ -0,0 +1,157 @@
+/*!
+ * @file prof.h
+ * @brief Sampling heap profiler.
+ *
+ * On average one allocation per interval bytes is sampled. Distances between
+ * samples are drawn from exponential distribution, so every allocated byte has
+ * the same chance to be sampled and sampled sizes are not biased. Sampled
+ * allocation keeps its backtrace, taken by walking frame pointers, in metadata
+ * from internal allocator, found by address in a hash table. Freed samples are
+ * reused. Chunks mark leaves holding sampled regions, runs
+ * and huge mappings carry a flag, so free looks into the table only for
+ * sampled memory. Live samples are written in legacy heap profile format read by
+ * pprof.
+ */
+
+#ifndef SEALLOC_PROF_H_
+#define SEALLOC_PROF_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "container_ll.h"
+
+struct arena_state;
+
+/*!
+ * @brief Name of environment variable holding path of profile dump.
+ */
+#define PROF_ENV_PATH "SEALLOC_PROF_FILE"
+
+/*!
+ * @brief Profile dump used if PROF_ENV_PATH is not set.
+ */
+#define PROF_DEFAULT_PATH "./sealloc.heap"
+
+/*!
+ * @brief Sampling interval in bytes, 0 disables profiling.
+ */
+#define PROF_DEFAULT_INTERVAL 0
+
+/*!
+ * @brief Biggest sampling interval in bytes.
+ */
+#define PROF_MAX_INTERVAL 1073741824
+
+/*!
+ * @brief Deepest backtrace kept for a sample.
+ */
+#define PROF_MAX_FRAMES 32
+
+/*!
+ * @brief Number of buckets of sample table.
+ */
+#define PROF_TABLE_SIZE 256
+
+/*!
+ * @brief Sampled allocation.
+ */
+typedef struct prof_sample {
+  ll_entry_t entry; /*!< Linkage field, key is address of allocation */
+  size_t size;      /*!< Requested size */
+  unsigned nframes; /*!< Number of valid frames */
+  void *frames[PROF_MAX_FRAMES]; /*!< Return addresses, innermost first */
+} prof_sample_t;
+
+/*!
+ * @brief State of profiler of single arena.
+ */
+typedef struct prof_state {
+  int64_t bytes_left; /*!< Bytes to allocate until next sample, INT64_MAX if
+                         profiling is disabled */
+  unsigned interval;  /*!< Mean distance between samples in bytes */
+  uint64_t rng;       /*!< State of generator of sampling distances */
+  size_t nlive;       /*!< Samples not freed yet */
+  size_t nsamples;    /*!< Samples taken since initialization */
+  size_t sampled_bytes; /*!< Bytes of samples taken since initialization */
+  const char *path;     /*!< File profile is dumped to */
+  ll_head_t table[PROF_TABLE_SIZE]; /*!< Live samples hashed by address */
+  ll_entry_t *spare; /*!< Freed samples kept for reuse, linked through
+                        link.fd */
+} prof_t;
+
+/*!
+ * @brief Initializes profiler.
+ *
+ * @param[out] prof Pointer to the profiler.
+ * @param[in] interval Mean distance between samples in bytes, 0 disables
+ * profiling.
+ * @param[in] seed Seed of generator of sampling distances.
+ */
+void prof_init(prof_t *prof, unsigned interval, uint64_t seed);
+
+/*!
+ * @brief Changes sampling interval, live samples are kept.
+ *
+ * @param[in,out] prof Pointer to the profiler.
+ * @param[in] interval Mean distance between samples in bytes, 0 disables
+ * profiling.
+ */
+void prof_set_interval(prof_t *prof, unsigned interval);
+
+/*!
+ * @brief Counts allocated bytes towards next sample.
+ *
+ * @param[in,out] prof Pointer to the profiler.
+ * @param[in] size Size of allocation.
+ * @return true if allocation has to be sampled with prof_sample().
+ */
+static inline bool prof_tick(prof_t *prof, size_t size) {
+  prof->bytes_left -= (int64_t)size;
+  return __builtin_expect(prof->bytes_left < 0, 0);
+}
+
+/*!
+ * @brief Records backtrace of allocation and draws distance to next sample.
+ *
+ * @param[in,out] arena Pointer to the arena the allocation comes from.
+ * @param[in] ptr Allocated region or huge mapping.
+ * @param[in] size Requested size.
+ * @pre arena is initialized
+ */
+void prof_sample(struct arena_state *arena, void *ptr, size_t size);
+
+/*!
+ * @brief Drops sample of allocation which is being freed.
+ *
+ * @param[in,out] arena Pointer to the arena the allocation comes from.
+ * @param[in] ptr Freed region or huge mapping.
+ * @return true if allocation was sampled.
+ * @pre arena is initialized
+ */
+bool prof_forget(struct arena_state *arena, const void *ptr);
+
+/*!
+ * @brief Writes live samples as pprof heap profile.
+ *
+ * Profile is followed by process memory map, which pprof uses to symbolize
+ * addresses.
+ *
+ * @param[in] arena Pointer to the arena.
+ * @param[in] fd Descriptor to write to.
+ * @pre arena is initialized
+ */
+void prof_write(const struct arena_state *arena, int fd);
+
+/*!
+ * @brief Writes live samples as pprof heap profile to file.
+ *
+ * @param[in] arena Pointer to the arena.
+ * @param[in] path Path of file, truncated if it exists.
+ * @return true on success, false if file couldn't be opened.
+ * @pre arena is initialized
+ */
+bool prof_dump(const struct arena_state *arena, const char *path);
+
+#endif /* SEALLOC_PROF_H_ */
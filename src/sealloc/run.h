@@ -19,19 +19,36 @@ struct bin_state;
 
 typedef struct bin_state bin_t;
 
+// Generator value marking compact descriptor of a retired run
+#define RUN_GEN_COMPACT 0
+
 typedef enum run_bitmap_state {
   STATE_FREE = 0,        // region is free
   STATE_ALLOC = 1,       // region is allocated
   STATE_ALLOC_FREE = 2,  // region is free but was allocated
 } bstate_t;
 
+/*
+ * Region bitmap holds two bitsets of run_bitset_words() words each.
+ * First one marks regions that were ever allocated, second one marks regions
+ * that were freed. Region state is then:
+ * alloc=0 freed=0 -> STATE_FREE
+ * alloc=1 freed=0 -> STATE_ALLOC
+ * alloc=1 freed=1 -> STATE_ALLOC_FREE
+ *
+ * Once run is depleted every region was allocated, so retired runs are
+ * compacted into a descriptor with gen == RUN_GEN_COMPACT and a single live
+ * bitset in place of the two above.
+ */
 typedef struct run_state {
-  ll_entry_t entry;      // Contains run_heap ptr as key
-  uint16_t navail;       // Number of remaining free regions
-  uint16_t nfreed;       // Number of freed regions
-  uint16_t gen;          // Generator
-  uint16_t current_idx;  // Current index
-  uint8_t reg_bitmap[];  // Region bitmap
+  ll_entry_t entry;       // Contains run_heap ptr as key
+  bin_t *bin;             // Bin the run belongs to
+  uint16_t navail;        // Number of remaining free regions
+  uint16_t nfreed;        // Number of freed regions
+  uint16_t gen;           // Generator
+  uint16_t current_idx;   // Current index
+  uint16_t sampled;       // Some region was sampled by heap profiler
+  uint64_t reg_bitmap[];  // Allocated bitset followed by freed bitset
 } run_t;
 
 // Allocate region from run
@@ -52,4 +69,33 @@ bool run_is_depleted(run_t *run);
 // Initialize run
 void run_init(run_t *run, bin_t *bin, void *heap);
 
+// Number of words in each of the run bitsets
+size_t run_bitset_words(const bin_t *bin);
+
+// Size of run metadata including region bitmap
+size_t run_metadata_size(const bin_t *bin);
+
+// Size of compact metadata of a retired run
+size_t run_compact_metadata_size(const bin_t *bin);
+
+// Turn depleted run into compact descriptor in place, metadata past
+// run_compact_metadata_size() is no longer used
+void run_compact(run_t *run, const bin_t *bin);
+
+// Returns true if run metadata is a compact descriptor
+bool run_is_compact(const run_t *run);
+
+// Prepare memory of a large region that has no run metadata, returns pointer
+// to be handed out
+void *run_tag_large(void *ptr, unsigned size);
+
+// Get state of a region
+bstate_t run_get_region_state(const run_t *run, const bin_t *bin, size_t idx);
+
+// Count regions that are allocated and not yet freed
+size_t run_count_live(const run_t *run, const bin_t *bin);
+
+// Find first live region with index >= start, SIZE_MAX if there is none
+size_t run_next_live(const run_t *run, const bin_t *bin, size_t start);
+
 #endif /* SEALLOC_RUN_H_ */
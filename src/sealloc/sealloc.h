@@ -6,13 +6,17 @@
 #include <stddef.h>
 
 #include "arena.h"
+#include "pool.h"
 
 typedef enum metadata_type {
   METADATA_INVALID,
   METADATA_REGULAR,
+  METADATA_LARGE,
   METADATA_HUGE
 } metadata_t;
 
+// Arena behind malloc(3) API, initialized on first use
+arena_t *sealloc_default_arena(void);
 metadata_t locate_metadata_for_ptr(arena_t *arena, void *ptr,
                                    chunk_t **chunk_ret, run_t **run_ret,
                                    bin_t **bin_ret, huge_chunk_t **huge_ret);
@@ -20,5 +24,22 @@ void *sealloc_malloc(arena_t *arena, size_t size);
 void sealloc_free(arena_t *arena, void *ptr);
 void *sealloc_calloc(arena_t *arena, size_t nmemb, size_t size);
 void *sealloc_realloc(arena_t *arena, void *ptr, size_t size);
+size_t sealloc_usable_size(arena_t *arena, void *ptr);
+size_t sealloc_round_size(size_t size);
+// Grows region without moving it, returns new usable size, which is below
+// min_size if region could not grow enough
+size_t sealloc_expand_in_place(arena_t *arena, void *ptr, size_t min_size,
+                               size_t max_size);
+void *sealloc_aligned_alloc(arena_t *arena, size_t alignment, size_t size);
+size_t sealloc_batch_malloc(arena_t *arena, size_t size, size_t n,
+                            void **out);
+void sealloc_batch_free(arena_t *arena, void **ptrs, size_t n);
+pool_t *sealloc_create_pool(arena_t *arena, size_t obj_size, size_t align);
+void *sealloc_malloc_from_pool(pool_t *pool);
+void sealloc_free_to_pool(pool_t *pool, void *ptr);
+void sealloc_destroy_pool(pool_t *pool);
+void sealloc_free_sized(arena_t *arena, void *ptr, size_t size);
+void sealloc_free_aligned_sized(arena_t *arena, void *ptr, size_t alignment,
+                                size_t size);
 
 #endif /* SEALLOC_H_ */
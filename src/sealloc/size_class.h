@@ -37,4 +37,10 @@ unsigned size_to_idx_large(unsigned n);
 unsigned alignup_medium_size(unsigned n);
 unsigned size_to_idx_medium(unsigned n);
 bool is_size_aligned(unsigned size);
+
+// Align size to its small, medium or large size class
+unsigned alignup_size(unsigned n);
+
+// Region size of arena bin with given index, reverse of SIZE_TO_IDX_* functions
+unsigned idx_to_size(unsigned idx);
 #endif /* SEALLOC_SIZE_CLASS_H_ */
@@ -0,0 +1,109 @@
+/*!
+ * @file stats.h
+ * @brief Snapshot of arena memory usage.
+ *
+ * Statistics are collected on demand by walking bins, chunks and mappings.
+ * Only allocation, free and run release counts cannot be recovered that way,
+ * bins keep them as plain counters updated on allocation paths.
+ */
+
+#ifndef SEALLOC_STATS_H_
+#define SEALLOC_STATS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "arena.h"
+#include "chunk.h"
+#include "platform_api.h"
+
+/*!
+ * @brief Usage of single arena bin.
+ */
+typedef struct bin_stats {
+  unsigned reg_size;  /*!< Size of single region */
+  unsigned run_size;  /*!< Size of run in bytes */
+  size_t nruns;       /*!< Runs holding regions, active and retired */
+  size_t nruns_active;   /*!< Runs servicing allocations */
+  size_t nruns_inactive; /*!< Depleted runs waiting for frees */
+  size_t nruns_released; /*!< Runs given back to chunks */
+  size_t nallocs;        /*!< Regions allocated from the bin */
+  size_t nfrees;         /*!< Regions freed to the bin */
+  size_t nregs_live;  /*!< Allocated regions */
+  size_t nregs_avail; /*!< Regions which were never allocated */
+  size_t nregs_freed; /*!< Freed regions of held runs, never reused */
+} bin_stats_t;
+
+/*!
+ * @brief Usage of whole arena.
+ */
+typedef struct arena_stats {
+  bin_stats_t bins[ARENA_NO_BINS]; /*!< Usage of each bin */
+  size_t small_bytes;              /*!< Live bytes of small regions */
+  size_t medium_bytes;             /*!< Live bytes of medium regions */
+  size_t large_bytes;              /*!< Live bytes of large regions */
+  size_t nchunks;                  /*!< Number of chunks */
+  size_t chunk_mapped_bytes;       /*!< Chunk memory which is still mapped */
+  size_t chunk_depleted_bytes; /*!< Mapped memory of freed runs, released by
+                                  decommit */
+  size_t chunk_cached_bytes;   /*!< Mapped chunks not handed out yet */
+  size_t chunk_unmapped_bytes; /*!< Chunk memory of freed runs returned to
+                                  system */
+  size_t chunk_nruns[CHUNK_BUDDY_TREE_DEPTH + 1]; /*!< Runs in use of each
+                                                     buddy order in all
+                                                     chunks */
+  size_t nhuge;                /*!< Number of huge mappings */
+  size_t huge_bytes;           /*!< Bytes of huge mappings */
+  size_t nunits;               /*!< Number of internal allocator units */
+  size_t internal_mapped_bytes; /*!< Memory of internal allocator units */
+  size_t internal_used_bytes;   /*!< Metadata allocated from the units */
+  size_t mapped_bytes; /*!< All memory mapped by arena, guard pages included */
+  size_t guard_bytes;  /*!< Guard pages after chunks */
+  size_t nvmas;        /*!< Upper bound of VMAs backing arena, kernel may merge
+                          adjacent mappings */
+  platform_counters_t platform; /*!< Process-wide mapping call counters */
+} arena_stats_t;
+
+/*!
+ * @brief Collects usage of arena.
+ *
+ * @param[in] arena Pointer to the allocated arena structure.
+ * @param[out] stats Usage of arena.
+ * @pre arena is initialized
+ */
+void stats_collect(arena_t *arena, arena_stats_t *stats);
+
+/*!
+ * @brief Collects usage of single chunk.
+ *
+ * @param[in] arena Pointer to the allocated arena structure.
+ * @param[in] idx Index of chunk in arena chunk list.
+ * @param[out] usage Usage of the chunk.
+ * @return true on success, false if arena has no chunk with index idx.
+ * @pre arena is initialized
+ */
+bool stats_collect_chunk(arena_t *arena, size_t idx, chunk_usage_t *usage);
+
+/*!
+ * @brief Writes usage of arena as malloc_info() XML document.
+ *
+ * @param[in] stats Usage of arena.
+ * @param[in] fp Stream to write to.
+ */
+void stats_write_xml(const arena_stats_t *stats, FILE *fp);
+
+/*!
+ * @brief Writes usage of arena as JSON document.
+ *
+ * Besides totals, document lists bins which ever held regions and usage of
+ * each chunk.
+ *
+ * @param[in] arena Pointer to the allocated arena structure.
+ * @param[in] stats Usage of arena collected with stats_collect().
+ * @param[in] fp Stream to write to.
+ * @pre arena is initialized
+ */
+void stats_write_json(arena_t *arena, const arena_stats_t *stats, FILE *fp);
+
+#endif /* SEALLOC_STATS_H_ */
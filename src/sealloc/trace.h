@@ -0,0 +1,149 @@
+/*!
+ * @file trace.h
+ * @brief Recording of allocation traces.
+ *
+ * Every call of the allocator API appends fixed size binary record to a
+ * file. Records are written directly to a window of the file mapped to
+ * memory, which slides forward once it is full, so recording costs neither
+ * syscall nor copy per event. File starts with trace_header_t, then records
+ * follow until the end of file or first record with TRACE_OP_NONE, so a trace
+ * of process which didn't exit cleanly can still be read.
+ *
+ * Pointers identify allocations, regions and mappings are never reused so
+ * address is unique during whole run.
+ */
+
+#ifndef SEALLOC_TRACE_H_
+#define SEALLOC_TRACE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*!
+ * @brief Name of environment variable holding path of trace file.
+ */
+#define TRACE_ENV_PATH "SEALLOC_TRACE_FILE"
+
+/*!
+ * @brief Magic bytes at the start of trace file.
+ */
+#define TRACE_MAGIC "SEATRACE"
+
+/*!
+ * @brief Version of trace file format.
+ */
+#define TRACE_FORMAT_VERSION 1
+
+/*!
+ * @brief Number of records in mapped window of the file.
+ */
+#define TRACE_WINDOW_RECORDS 16384
+
+/*!
+ * @brief Traced operation.
+ */
+typedef enum trace_op {
+  TRACE_OP_NONE,    /*!< Unused record, terminates trace */
+  TRACE_OP_MALLOC,  /*!< malloc(size) returned id */
+  TRACE_OP_CALLOC,  /*!< calloc(arg, size) returned id */
+  TRACE_OP_REALLOC, /*!< realloc(arg, size) returned id */
+  TRACE_OP_ALIGNED, /*!< Allocation of size aligned to arg returned id */
+  TRACE_OP_FREE     /*!< id was freed, size is 0 unless it was sized free */
+} trace_op_t;
+
+/*!
+ * @brief Single traced event.
+ */
+typedef struct trace_record {
+  uint64_t timestamp; /*!< Nanoseconds since trace was opened */
+  uint64_t id;        /*!< Address of allocation, 0 if it failed */
+  uint64_t size;      /*!< Requested size */
+  uint64_t arg;       /*!< Operation specific, see trace_op_t */
+  uint32_t tid;       /*!< Thread which called allocator */
+  uint8_t op;         /*!< One of trace_op_t */
+  uint8_t pad[3];
+} trace_record_t;
+
+/*!
+ * @brief First record sized entry of trace file.
+ */
+typedef struct trace_header {
+  char magic[8];        /*!< TRACE_MAGIC, not terminated */
+  uint32_t version;     /*!< TRACE_FORMAT_VERSION */
+  uint32_t record_size; /*!< sizeof(trace_record_t) */
+  uint64_t start;       /*!< Wall clock time of first record in nanoseconds */
+  uint32_t pid;         /*!< Traced process */
+  uint32_t pad;
+  uint64_t reserved;
+} trace_header_t;
+
+/*!
+ * @brief State of trace file being written.
+ */
+typedef struct trace_state {
+  int fd;                  /*!< Descriptor of trace file, -1 if closed */
+  trace_record_t *window;  /*!< Mapped part of the file, NULL if closed */
+  size_t window_idx;       /*!< Index of mapped window within the file */
+  unsigned pos;            /*!< Next free record within the window */
+  uint64_t start;          /*!< Monotonic time trace was opened at */
+  size_t nrecords;         /*!< Records written, without header */
+} trace_t;
+
+/*!
+ * @brief Marks trace as closed.
+ *
+ * Zeroed trace is closed as well.
+ *
+ * @param[out] trace Pointer to the trace.
+ */
+void trace_init(trace_t *trace);
+
+/*!
+ * @brief Creates trace file and writes its header.
+ *
+ * @param[in,out] trace Pointer to closed trace.
+ * @param[in] path Path of file, truncated if it exists.
+ * @return true on success, false if file couldn't be created or mapped.
+ */
+bool trace_open(trace_t *trace, const char *path);
+
+/*!
+ * @brief Checks if trace file is open.
+ *
+ * @param[in] trace Pointer to the trace.
+ * @return true if events are recorded.
+ */
+static inline bool trace_is_open(const trace_t *trace) {
+  return __builtin_expect(trace->window != NULL, 0);
+}
+
+/*!
+ * @brief Appends record of single event.
+ *
+ * Trace is closed if the file can't be extended.
+ *
+ * @param[in,out] trace Pointer to open trace.
+ * @param[in] op Traced operation.
+ * @param[in] id Address of allocation.
+ * @param[in] size Requested size.
+ * @param[in] arg Operation specific argument.
+ */
+void trace_record(trace_t *trace, trace_op_t op, const void *id, size_t size,
+                  uint64_t arg);
+
+/*!
+ * @brief Unmaps window and truncates file to records written.
+ *
+ * @param[in,out] trace Pointer to the trace, closed on return.
+ */
+void trace_close(trace_t *trace);
+
+/*!
+ * @brief Closes trace inherited by forked child, file is left to the parent.
+ *
+ * @param[in,out] trace Pointer to the trace, closed on return.
+ */
+void trace_detach(trace_t *trace);
+
+#endif /* SEALLOC_TRACE_H_ */
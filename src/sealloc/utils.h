@@ -15,6 +15,8 @@
 #define ALIGNUP_8(n) (((n) + 7) & ~7)
 #define ALIGNUP_16(n) (((n) + 15) & ~15)
 #define ALIGNUP_PAGE(n) (((n) + (PAGE_SIZE - 1)) & ~(PAGE_SIZE - 1))
+// Align n up to a, a must be a power of 2
+#define ALIGNUP(n, a) (((n) + ((a) - 1)) & ~((a) - 1))
 #define BITS2BYTES_CEIL(bits) (ALIGNUP_8(bits) / 8)
 
 #define IS_ALIGNED(X, Y) (((X) % (Y)) == 0)
@@ -24,4 +26,5 @@
 uint32_t str2u32(const char *str);
 unsigned msg_len(const char *msg);
 unsigned ctz(unsigned x);
+unsigned gcd(unsigned a, unsigned b);
 #endif /* SEALLOC_UTILS_H_ */
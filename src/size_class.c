@@ -39,6 +39,20 @@ unsigned size_to_idx_medium(unsigned n) {
   return ctz(n / MEDIUM_SIZE_MIN_REGION);
 }
 
+unsigned idx_to_size(unsigned idx) {
+  if (idx < NO_SMALL_SIZE_CLASSES) return (idx + 1) * SMALL_SIZE_CLASS_ALIGNMENT;
+  idx -= NO_SMALL_SIZE_CLASSES;
+  if (idx < NO_MEDIUM_SIZE_CLASSES) return MEDIUM_SIZE_MIN_REGION << idx;
+  idx -= NO_MEDIUM_SIZE_CLASSES;
+  return LARGE_SIZE_MIN_REGION << idx;
+}
+
+unsigned alignup_size(unsigned n) {
+  if (IS_SIZE_SMALL(n)) return ALIGNUP_SMALL_SIZE(n);
+  if (IS_SIZE_MEDIUM(n)) return alignup_medium_size(n);
+  return alignup_large_size(n);
+}
+
 bool is_size_aligned(unsigned size) {
   if (IS_SIZE_SMALL(size)) {
     return ALIGNUP_SMALL_SIZE(size) == size;
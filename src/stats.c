@@ -0,0 +1,228 @@
+#include "sealloc/stats.h"
+
+#include <string.h>
+
+#include "sealloc/arena.h"
+#include "sealloc/bin.h"
+#include "sealloc/chunk.h"
+#include "sealloc/container_ll.h"
+#include "sealloc/internal_allocator.h"
+#include "sealloc/platform_api.h"
+#include "sealloc/run.h"
+#include "sealloc/size_class.h"
+#include "sealloc/utils.h"
+
+// Returns number of runs on the list
+static size_t stats_add_runs(const bin_t *bin, const ll_entry_t *entry,
+                             bin_stats_t *stats) {
+  const unsigned nregs = bin->reg_mask_size_bits / 2;
+  const run_t *run;
+  size_t cnt = 0;
+  for (; entry != NULL; entry = entry->link.fd) {
+    run = CONTAINER_OF(entry, run_t, entry);
+    cnt++;
+    stats->nregs_avail += run->navail;
+    stats->nregs_freed += run->nfreed;
+    stats->nregs_live += nregs - run->navail - run->nfreed;
+  }
+  stats->nruns += cnt;
+  return cnt;
+}
+
+static void stats_collect_bin(arena_t *arena, unsigned idx,
+                              bin_stats_t *stats) {
+  const bin_t *bin = &arena->bins[idx];
+  stats->reg_size = idx_to_size(idx);
+  if (bin->reg_size != 0) {
+    stats->run_size = bin->run_size_pages * PAGE_SIZE;
+  } else if (IS_SIZE_SMALL(stats->reg_size)) {
+    stats->run_size = arena->conf.run_size_small_pages * PAGE_SIZE;
+  } else if (IS_SIZE_MEDIUM(stats->reg_size)) {
+    stats->run_size = arena->conf.run_size_medium_pages * PAGE_SIZE;
+  } else {
+    stats->run_size = stats->reg_size;
+  }
+  if (bin->reg_size == 0) return;
+  stats->nallocs = bin->nallocs;
+  stats->nfrees = bin->nfrees;
+  stats->nruns_released = bin->nruns_released;
+  // Large regions have no run metadata, they are counted from chunks
+  if (IS_SIZE_LARGE(bin->reg_size)) return;
+  stats->nruns_active = stats_add_runs(bin, bin->run_list_active.ll, stats);
+  stats->nruns_inactive =
+      stats_add_runs(bin, bin->run_list_inactive.ll, stats);
+}
+
+void stats_collect(arena_t *arena, arena_stats_t *stats) {
+  const unsigned large_base = NO_SMALL_SIZE_CLASSES + NO_MEDIUM_SIZE_CLASSES;
+  chunk_usage_t usage;
+  const int_alloc_t *unit;
+  size_t bytes;
+  memset(stats, 0, sizeof(*stats));
+  memset(&usage, 0, sizeof(usage));
+
+  for (ll_entry_t *e = arena->chunk_list.ll; e != NULL; e = e->link.fd) {
+    chunk_get_usage(CONTAINER_OF(e, chunk_t, entry), &usage);
+    stats->nchunks++;
+  }
+  stats->chunk_mapped_bytes =
+      stats->nchunks * CHUNK_SIZE_BYTES - usage.unmapped_bytes;
+  stats->chunk_depleted_bytes = usage.depleted_bytes;
+  stats->chunk_cached_bytes = (size_t)arena->chunks_left * CHUNK_SIZE_BYTES;
+  stats->chunk_unmapped_bytes = usage.unmapped_bytes;
+  stats->guard_bytes = stats->nchunks * PAGE_SIZE;
+  for (unsigned i = 0; i <= CHUNK_BUDDY_TREE_DEPTH; i++)
+    stats->chunk_nruns[i] = usage.nruns[i];
+
+  for (unsigned i = 0; i < ARENA_NO_BINS; i++) {
+    stats_collect_bin(arena, i, &stats->bins[i]);
+    if (i >= large_base) {
+      stats->bins[i].nruns = usage.nlarge[i - large_base];
+      stats->bins[i].nruns_active = usage.nlarge[i - large_base];
+      stats->bins[i].nregs_live = usage.nlarge[i - large_base];
+    }
+    bytes = stats->bins[i].nregs_live * stats->bins[i].reg_size;
+    if (IS_SIZE_SMALL(stats->bins[i].reg_size))
+      stats->small_bytes += bytes;
+    else if (IS_SIZE_MEDIUM(stats->bins[i].reg_size))
+      stats->medium_bytes += bytes;
+    else
+      stats->large_bytes += bytes;
+  }
+
+  for (ll_entry_t *e = arena->huge_alloc_list.ll; e != NULL; e = e->link.fd) {
+    stats->nhuge++;
+    stats->huge_bytes += CONTAINER_OF(e, huge_chunk_t, entry)->len;
+  }
+
+  for (ll_entry_t *e = arena->internal_alloc_list.ll; e != NULL;
+       e = e->link.fd) {
+    unit = CONTAINER_OF(e, int_alloc_t, entry);
+    stats->nunits++;
+    stats->internal_mapped_bytes += ALIGNUP_PAGE(sizeof(int_alloc_t));
+    stats->internal_used_bytes += sizeof(unit->memory) - unit->free_mem;
+  }
+
+  // Chunks not handed out yet share one mapping without guards
+  stats->mapped_bytes = stats->chunk_mapped_bytes + stats->guard_bytes +
+                        (size_t)arena->chunks_left * PAGE_SIZE +
+                        stats->chunk_cached_bytes + stats->huge_bytes +
+                        stats->internal_mapped_bytes;
+  stats->nvmas = usage.nsegments + stats->nchunks +
+                 (arena->chunks_left > 0 ? 1 : 0) + stats->nhuge +
+                 stats->nunits;
+  platform_get_counters(&stats->platform);
+}
+
+bool stats_collect_chunk(arena_t *arena, size_t idx, chunk_usage_t *usage) {
+  ll_entry_t *e = arena->chunk_list.ll;
+  for (; e != NULL && idx > 0; e = e->link.fd) idx--;
+  if (e == NULL) return false;
+  memset(usage, 0, sizeof(*usage));
+  chunk_get_usage(CONTAINER_OF(e, chunk_t, entry), usage);
+  return true;
+}
+
+static const char *stats_class_name(unsigned reg_size) {
+  if (IS_SIZE_SMALL(reg_size)) return "small";
+  if (IS_SIZE_MEDIUM(reg_size)) return "medium";
+  return "large";
+}
+
+void stats_write_xml(const arena_stats_t *stats, FILE *fp) {
+  const bin_stats_t *bin;
+  fprintf(fp, "<malloc version=\"sealloc-1\">\n<heap nr=\"0\">\n<sizes>\n");
+  for (unsigned i = 0; i < ARENA_NO_BINS; i++) {
+    bin = &stats->bins[i];
+    if (bin->nruns == 0) continue;
+    fprintf(fp,
+            "  <size class=\"%s\" size=\"%u\" run_size=\"%u\" runs=\"%zu\" "
+            "live=\"%zu\" avail=\"%zu\" freed=\"%zu\"/>\n",
+            stats_class_name(bin->reg_size), bin->reg_size, bin->run_size,
+            bin->nruns, bin->nregs_live, bin->nregs_avail, bin->nregs_freed);
+  }
+  fprintf(fp, "</sizes>\n");
+  fprintf(fp, "<total type=\"small\" size=\"%zu\"/>\n", stats->small_bytes);
+  fprintf(fp, "<total type=\"medium\" size=\"%zu\"/>\n", stats->medium_bytes);
+  fprintf(fp, "<total type=\"large\" size=\"%zu\"/>\n", stats->large_bytes);
+  fprintf(fp, "<total type=\"huge\" count=\"%zu\" size=\"%zu\"/>\n",
+          stats->nhuge, stats->huge_bytes);
+  fprintf(fp,
+          "<chunks count=\"%zu\" mapped=\"%zu\" depleted=\"%zu\" "
+          "cached=\"%zu\"/>\n",
+          stats->nchunks, stats->chunk_mapped_bytes,
+          stats->chunk_depleted_bytes, stats->chunk_cached_bytes);
+  fprintf(fp, "<metadata units=\"%zu\" mapped=\"%zu\" used=\"%zu\"/>\n",
+          stats->nunits, stats->internal_mapped_bytes,
+          stats->internal_used_bytes);
+  fprintf(fp, "</heap>\n</malloc>\n");
+}
+
+static void stats_write_json_orders(const char *name, const size_t *nruns,
+                                    FILE *fp) {
+  fprintf(fp, "\"%s\":[", name);
+  for (unsigned i = 0; i <= CHUNK_BUDDY_TREE_DEPTH; i++)
+    fprintf(fp, "%s%zu", i == 0 ? "" : ",", nruns[i]);
+  fprintf(fp, "]");
+}
+
+void stats_write_json(arena_t *arena, const arena_stats_t *stats, FILE *fp) {
+  const bin_stats_t *bin;
+  chunk_usage_t usage;
+  size_t nruns[CHUNK_BUDDY_TREE_DEPTH + 1];
+  bool first = true;
+  fprintf(fp, "{\"bins\":[");
+  for (unsigned i = 0; i < ARENA_NO_BINS; i++) {
+    bin = &stats->bins[i];
+    if (bin->nallocs == 0) continue;
+    fprintf(fp,
+            "%s{\"class\":\"%s\",\"reg_size\":%u,\"run_size\":%u,"
+            "\"nallocs\":%zu,\"nfrees\":%zu,\"nruns_active\":%zu,"
+            "\"nruns_inactive\":%zu,\"nruns_released\":%zu,\"live\":%zu,"
+            "\"avail\":%zu,\"freed\":%zu}",
+            first ? "" : ",", stats_class_name(bin->reg_size), bin->reg_size,
+            bin->run_size, bin->nallocs, bin->nfrees, bin->nruns_active,
+            bin->nruns_inactive, bin->nruns_released, bin->nregs_live,
+            bin->nregs_avail, bin->nregs_freed);
+    first = false;
+  }
+  fprintf(fp, "],\"chunks\":[");
+  first = true;
+  for (ll_entry_t *e = arena->chunk_list.ll; e != NULL; e = e->link.fd) {
+    memset(&usage, 0, sizeof(usage));
+    chunk_get_usage(CONTAINER_OF(e, chunk_t, entry), &usage);
+    for (unsigned k = 0; k <= CHUNK_BUDDY_TREE_DEPTH; k++)
+      nruns[k] = usage.nruns[k];
+    fprintf(fp,
+            "%s{\"run_bytes\":%zu,\"depleted_bytes\":%zu,"
+            "\"unmapped_bytes\":%zu,",
+            first ? "" : ",", usage.run_bytes, usage.depleted_bytes,
+            usage.unmapped_bytes);
+    stats_write_json_orders("nruns", nruns, fp);
+    fprintf(fp, "}");
+    first = false;
+  }
+  fprintf(fp,
+          "],\"totals\":{\"small\":%zu,\"medium\":%zu,\"large\":%zu,"
+          "\"huge\":%zu,\"nhuge\":%zu,\"nchunks\":%zu,"
+          "\"chunk_mapped\":%zu,\"chunk_depleted\":%zu,"
+          "\"chunk_unmapped\":%zu,\"chunk_cached\":%zu,",
+          stats->small_bytes, stats->medium_bytes, stats->large_bytes,
+          stats->huge_bytes, stats->nhuge, stats->nchunks,
+          stats->chunk_mapped_bytes, stats->chunk_depleted_bytes,
+          stats->chunk_unmapped_bytes, stats->chunk_cached_bytes);
+  stats_write_json_orders("chunk_nruns", stats->chunk_nruns, fp);
+  fprintf(fp,
+          ",\"metadata_units\":%zu,\"metadata_mapped\":%zu,"
+          "\"metadata_used\":%zu},\"mappings\":{\"mapped\":%zu,"
+          "\"guard\":%zu,\"vmas\":%zu,\"map_calls\":%zu,"
+          "\"probe_calls\":%zu,\"probe_retries\":%zu,\"unmap_calls\":%zu,"
+          "\"guard_calls\":%zu,\"unguard_calls\":%zu,"
+          "\"expand_calls\":%zu}}\n",
+          stats->nunits, stats->internal_mapped_bytes,
+          stats->internal_used_bytes, stats->mapped_bytes, stats->guard_bytes,
+          stats->nvmas, stats->platform.nmap, stats->platform.nprobe,
+          stats->platform.nprobe_retry, stats->platform.nunmap,
+          stats->platform.nguard, stats->platform.nunguard,
+          stats->platform.nexpand);
+}
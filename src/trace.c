@@ -0,0 +1,121 @@
+#include "sealloc/trace.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sealloc/logging.h"
+
+#define TRACE_WINDOW_BYTES (TRACE_WINDOW_RECORDS * sizeof(trace_record_t))
+
+_Static_assert(sizeof(trace_header_t) == sizeof(trace_record_t),
+               "Header occupies slot of one record");
+_Static_assert(TRACE_WINDOW_BYTES % 4096 == 0,
+               "Windows are mapped at page aligned offsets");
+
+// Initial-exec model never allocates, unlike lookup of dynamic TLS
+static __thread __attribute__((tls_model("initial-exec"))) uint32_t trace_tid;
+
+static uint64_t trace_clock(clockid_t clock) {
+  struct timespec ts;
+  clock_gettime(clock, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t trace_get_tid(void) {
+  if (trace_tid == 0) trace_tid = (uint32_t)syscall(SYS_gettid);
+  return trace_tid;
+}
+
+void trace_init(trace_t *trace) {
+  trace->fd = -1;
+  trace->window = NULL;
+  trace->window_idx = 0;
+  trace->pos = 0;
+  trace->start = 0;
+  trace->nrecords = 0;
+}
+
+// Extends file by one window and maps it, false on failure
+static bool trace_map_window(trace_t *trace, size_t idx) {
+  void *map;
+  off_t off = (off_t)(idx * TRACE_WINDOW_BYTES);
+  if (ftruncate(trace->fd, off + (off_t)TRACE_WINDOW_BYTES) != 0) return false;
+  map = mmap(NULL, TRACE_WINDOW_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED,
+             trace->fd, off);
+  if (map == MAP_FAILED) return false;
+  trace->window = map;
+  trace->window_idx = idx;
+  trace->pos = 0;
+  return true;
+}
+
+// Drops unused tail of the last window and closes the file
+static void trace_finish(trace_t *trace) {
+  // Header takes one slot
+  if (ftruncate(trace->fd,
+                (off_t)((trace->nrecords + 1) * sizeof(trace_record_t))) != 0)
+    se_log("Couldn't truncate allocation trace\n");
+  close(trace->fd);
+  trace_init(trace);
+}
+
+bool trace_open(trace_t *trace, const char *path) {
+  int perms = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
+  trace_header_t *header;
+  trace->fd = open(path, O_RDWR | O_TRUNC | O_CREAT | O_CLOEXEC, perms);
+  if (trace->fd < 0) return false;
+  if (!trace_map_window(trace, 0)) {
+    close(trace->fd);
+    trace_init(trace);
+    return false;
+  }
+  trace->start = trace_clock(CLOCK_MONOTONIC);
+  trace->nrecords = 0;
+  header = (trace_header_t *)&trace->window[0];
+  memcpy(header->magic, TRACE_MAGIC, sizeof(header->magic));
+  header->version = TRACE_FORMAT_VERSION;
+  header->record_size = sizeof(trace_record_t);
+  header->start = trace_clock(CLOCK_REALTIME);
+  header->pid = (uint32_t)getpid();
+  trace->pos = 1;
+  return true;
+}
+
+void trace_record(trace_t *trace, trace_op_t op, const void *id, size_t size,
+                  uint64_t arg) {
+  trace_record_t *rec;
+  if (trace->pos == TRACE_WINDOW_RECORDS) {
+    munmap(trace->window, TRACE_WINDOW_BYTES);
+    if (!trace_map_window(trace, trace->window_idx + 1)) {
+      se_log("Couldn't extend allocation trace, tracing stopped\n");
+      trace_finish(trace);
+      return;
+    }
+  }
+  rec = &trace->window[trace->pos++];
+  rec->timestamp = trace_clock(CLOCK_MONOTONIC) - trace->start;
+  rec->id = (uintptr_t)id;
+  rec->size = size;
+  rec->arg = arg;
+  rec->tid = trace_get_tid();
+  rec->op = (uint8_t)op;
+  trace->nrecords++;
+}
+
+void trace_close(trace_t *trace) {
+  if (!trace_is_open(trace)) return;
+  munmap(trace->window, TRACE_WINDOW_BYTES);
+  trace_finish(trace);
+}
+
+void trace_detach(trace_t *trace) {
+  if (!trace_is_open(trace)) return;
+  munmap(trace->window, TRACE_WINDOW_BYTES);
+  close(trace->fd);
+  trace_init(trace);
+}
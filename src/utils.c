@@ -18,6 +18,16 @@ unsigned ctz(unsigned x) {
   return cnt;
 }
 
+unsigned gcd(unsigned a, unsigned b) {
+  unsigned t;
+  while (b != 0) {
+    t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
 uint32_t str2u32(const char* str) {
   uint32_t res = 0, base = 1, idx = msg_len(str);
   while (idx > 0) {
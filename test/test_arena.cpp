@@ -127,6 +127,16 @@ TEST_F(ArenaUtilsTest, ArenaAllocateHugeChunk) {
   EXPECT_NE(huge_chunk, nullptr);
 }
 
+TEST_F(ArenaUtilsTest, ArenaAllocateHugeChunkAligned) {
+  for (size_t alignment : {2 * PAGE_SIZE, 65536, 2097152}) {
+    huge_chunk_t *huge =
+        arena_allocate_huge_mapping_aligned(&arena, PAGE_SIZE, alignment);
+    EXPECT_TRUE(IS_ALIGNED((uintptr_t)huge->entry.key, alignment));
+    EXPECT_EQ(huge->len, PAGE_SIZE);
+    std::memset(huge->entry.key, 0x41, PAGE_SIZE);
+  }
+}
+
 TEST_F(ArenaUtilsTest, ArenaReallocateHugeChunkSameSize) {
   huge_chunk_t *huge_chunk1;
   void *key;
@@ -170,6 +180,24 @@ TEST_F(ArenaUtilsTest, ArenaAllocateRun) {
   EXPECT_NE(run, nullptr);
 }
 
+TEST_F(ArenaUtilsTest, ArenaRetireRun) {
+  bin_t *bin = arena_get_bin_by_reg_size(&arena, SMALL_SIZE_CLASS_ALIGNMENT);
+  run_t *run = arena_allocate_run(&arena, bin);
+  void *heap = run->entry.key;
+  bin_add_run(bin, run);
+  while (!run_is_depleted(run)) {
+    bin_get_run_for_allocation(bin);
+    run_allocate(run, bin);
+  }
+  run_t *compact = arena_retire_run(&arena, bin, run);
+  // Descriptor is compacted in place
+  EXPECT_EQ(compact, run);
+  EXPECT_TRUE(run_is_compact(compact));
+  EXPECT_EQ(bin->run_list_active_cnt, 0);
+  EXPECT_EQ(bin_get_run_by_addr(bin, heap), compact);
+  EXPECT_EQ(run_count_live(compact, bin), bin->reg_mask_size_bits / 2);
+}
+
 TEST_F(ArenaUtilsTest, ArenaInternalAlloc) {
   void *a, *b, *full;
 
@@ -6,12 +6,12 @@ extern "C" {
 #include <sealloc/bin.h>
 #include <sealloc/random.h>
 #include <sealloc/run.h>
+#include <sealloc/size_class.h>
 #include <sealloc/utils.h>
 }
 
 run_t *alloc_run(bin_t *bin) {
-  return (run_t *)malloc(sizeof(run_t) +
-                         BITS2BYTES_CEIL(bin->reg_mask_size_bits));
+  return (run_t *)malloc(run_metadata_size(bin));
 }
 
 TEST(BinUtils, BinInitSmall) {
@@ -134,3 +134,18 @@ TEST(BinUtils, BinGetRunForAllocationMulti) {
   init_splitmix32(1);
   EXPECT_EQ(bin_get_run_for_allocation(bin), runs[30 - 7]);
 }
+
+TEST(BinUtils, BinGetRunForBatchClamps) {
+  bin_t *bin = (bin_t *)malloc(sizeof(bin_t));
+  bin_init(bin, MEDIUM_SIZE_MAX_REGION);
+  run_t *run1 = alloc_run(bin);
+  void *run_heap = malloc(16);
+  EXPECT_NE(run_heap, nullptr);
+  run_init(run1, bin, run_heap);
+  bin_add_run(bin, run1);
+  unsigned elems = run1->navail;
+  unsigned nregs = elems + 10;
+  EXPECT_EQ(bin_get_run_for_batch(bin, &nregs), run1);
+  EXPECT_EQ(nregs, elems);
+  EXPECT_EQ(bin->avail_regs, 0);
+}
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+extern "C" {
+#include <sealloc/bitset.h>
+}
+
+namespace {
+class BitsetKernelsTest : public ::testing::TestWithParam<bitset_impl_t> {
+ protected:
+  void SetUp() override {
+    if (!bitset_select_impl(GetParam()))
+      GTEST_SKIP() << "Implementation not supported by CPU";
+  }
+  void TearDown() override { bitset_select_impl(bitset_best_impl()); }
+};
+
+// Sizes cover partial AVX2 blocks and single words
+const size_t kWords[] = {1, 2, 3, 4, 5, 8, 13, 16};
+
+TEST_P(BitsetKernelsTest, SingleBitAccess) {
+  uint64_t set[2] = {0, 0};
+  bitset_set(set, 0);
+  bitset_set(set, 63);
+  bitset_set(set, 64);
+  EXPECT_EQ(set[0], 0x8000000000000001ULL);
+  EXPECT_EQ(set[1], 1ULL);
+  EXPECT_TRUE(bitset_get(set, 63));
+  EXPECT_FALSE(bitset_get(set, 65));
+  bitset_clear(set, 63);
+  EXPECT_FALSE(bitset_get(set, 63));
+}
+
+TEST_P(BitsetKernelsTest, MatchesBitSerial) {
+  std::mt19937_64 engine{1};
+  for (size_t words : kWords) {
+    std::vector<uint64_t> a(words), b(words);
+    for (size_t i = 0; i < words; i++) {
+      a[i] = engine();
+      b[i] = engine() & engine();
+    }
+    size_t cnt = 0, cnt_andnot = 0;
+    for (size_t i = 0; i < words * 64; i++) {
+      cnt += bitset_get(a.data(), i);
+      cnt_andnot += bitset_get(a.data(), i) && !bitset_get(b.data(), i);
+    }
+    EXPECT_EQ(bitset_count(a.data(), words), cnt);
+    EXPECT_EQ(bitset_count_andnot(a.data(), b.data(), words), cnt_andnot);
+
+    size_t found = 0;
+    for (size_t idx = bitset_find_next_andnot(a.data(), b.data(), words, 0);
+         idx != SIZE_MAX;
+         idx = bitset_find_next_andnot(a.data(), b.data(), words, idx + 1)) {
+      EXPECT_TRUE(bitset_get(a.data(), idx) && !bitset_get(b.data(), idx));
+      found++;
+    }
+    EXPECT_EQ(found, cnt_andnot);
+
+    found = 0;
+    for (size_t idx = bitset_find_next(a.data(), words, 0); idx != SIZE_MAX;
+         idx = bitset_find_next(a.data(), words, idx + 1)) {
+      EXPECT_TRUE(bitset_get(a.data(), idx));
+      found++;
+    }
+    EXPECT_EQ(found, cnt);
+  }
+}
+
+TEST_P(BitsetKernelsTest, FindNextSkipsEmptyWords) {
+  for (size_t words : kWords) {
+    std::vector<uint64_t> a(words, 0), b(words, 0);
+    EXPECT_EQ(bitset_find_next_andnot(a.data(), b.data(), words, 0), SIZE_MAX);
+    EXPECT_EQ(bitset_find_next(a.data(), words, 0), SIZE_MAX);
+    bitset_set(a.data(), words * 64 - 1);
+    EXPECT_EQ(bitset_find_next(a.data(), words, 0), words * 64 - 1);
+    EXPECT_EQ(bitset_find_next_andnot(a.data(), b.data(), words, 0),
+              words * 64 - 1);
+    EXPECT_EQ(bitset_find_next_andnot(a.data(), b.data(), words, words * 64),
+              SIZE_MAX);
+    bitset_set(b.data(), words * 64 - 1);
+    EXPECT_EQ(bitset_find_next_andnot(a.data(), b.data(), words, 0), SIZE_MAX);
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Bitset, BitsetKernelsTest,
+                         ::testing::Values(BITSET_IMPL_GENERIC,
+                                           BITSET_IMPL_POPCNT,
+                                           BITSET_IMPL_AVX2));
+}  // namespace
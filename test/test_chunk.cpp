@@ -244,6 +244,28 @@ TEST_F(ChunkUtilsTest, ChunkRegSizeArrayLargeHandling) {
   EXPECT_EQ(reg_size, 0);
 }
 
+TEST_F(ChunkUtilsTest, ChunkRegMarkLarge) {
+  void *run_ptr = nullptr,
+       *alloc = chunk_allocate_run(chunk, LARGE_SIZE_MAX_REGION,
+                                   LARGE_SIZE_MAX_REGION);
+  unsigned run_size = 0, reg_size = 0;
+  size_t leaf = ((uintptr_t)alloc - (uintptr_t)chunk->entry.key) /
+                CHUNK_LEAST_REGION_SIZE_BYTES;
+  unsigned order = LARGE_SIZE_MAX_REGION / CHUNK_LEAST_REGION_SIZE_BYTES;
+  EXPECT_EQ(chunk->reg_size_small_medium[leaf],
+            REG_MARK_LARGE | __builtin_ctz(order));
+  // Only first leaf of the run is marked
+  EXPECT_EQ(chunk->reg_size_small_medium[leaf + 1], REG_MARK_BAD_VALUE);
+
+  chunk_get_run_ptr(chunk, (char *)alloc + 42, &run_ptr, &run_size, &reg_size);
+  EXPECT_EQ(alloc, run_ptr);
+  EXPECT_EQ(run_size, LARGE_SIZE_MAX_REGION);
+  EXPECT_EQ(reg_size, 0);
+
+  chunk_deallocate_run(chunk, alloc);
+  EXPECT_EQ(chunk->reg_size_small_medium[leaf], REG_MARK_BAD_VALUE);
+}
+
 TEST_F(ChunkUtilsTest, ChunkSingleDeallocate) {
   void *alloc;
   alloc = chunk_allocate_run(chunk, run_size_small, 16);
@@ -457,6 +479,24 @@ TEST_F(ChunkUtilsTest, ChunkGetRunPointerNegative) {
   EXPECT_EQ(run_ptr, nullptr);
 }
 
+TEST_F(ChunkUtilsTest, ChunkGetRunByLeaf) {
+  run_t *run = (run_t *)0x1000;
+  unsigned run_size = 4 * CHUNK_LEAST_REGION_SIZE_BYTES;
+  void *run_ptr = chunk_allocate_run(chunk, run_size, 1024);
+  ASSERT_NE(run_ptr, nullptr);
+  EXPECT_EQ(chunk_get_run(chunk, run_ptr, run_size), nullptr);
+  chunk_set_run(chunk, run_ptr, run);
+  EXPECT_EQ(chunk_get_run(chunk, run_ptr, run_size), run);
+  EXPECT_EQ(chunk_get_run(chunk, (uint8_t *)run_ptr + run_size - 1, run_size),
+            run);
+  // Smaller runs would start inside this one
+  EXPECT_EQ(chunk_get_run(chunk, (uint8_t *)run_ptr + run_size - 1,
+                          CHUNK_LEAST_REGION_SIZE_BYTES),
+            nullptr);
+  chunk_deallocate_run(chunk, run_ptr);
+  EXPECT_EQ(chunk_get_run(chunk, run_ptr, run_size), nullptr);
+}
+
 TEST_F(ChunkUtilsTest, ChunkIsFull) {
   constexpr unsigned CHUNKS = 32;
   chunk_init(chunk, heap);
@@ -468,4 +508,73 @@ TEST_F(ChunkUtilsTest, ChunkIsFull) {
   EXPECT_TRUE(chunk_is_full(chunk));
 }
 
+TEST_F(ChunkUtilsTest, ChunkExpandRunIntoFreeBuddies) {
+  void *run_ptr, *found;
+  unsigned run_size, reg_size, expected;
+  uintptr_t offset;
+  for (uint32_t seed = 1; seed < 64; seed++) {
+    init_splitmix32(seed);
+    chunk_init(chunk, heap);
+    run_ptr = chunk_allocate_run(chunk, LARGE_SIZE_MIN_REGION,
+                                 LARGE_SIZE_MIN_REGION);
+    ASSERT_NE(run_ptr, nullptr);
+    // Chunk is empty, run grows until it becomes a right child
+    offset = (uintptr_t)run_ptr - (uintptr_t)chunk->entry.key;
+    expected = LARGE_SIZE_MIN_REGION;
+    while (expected < LARGE_SIZE_MAX_REGION && offset % (expected * 2) == 0)
+      expected *= 2;
+    ASSERT_EQ(chunk_expand_run(chunk, run_ptr, LARGE_SIZE_MIN_REGION,
+                               LARGE_SIZE_MIN_REGION, LARGE_SIZE_MAX_REGION),
+              expected);
+    validate_entire_tree();
+
+    found = nullptr;
+    run_size = reg_size = 0;
+    chunk_get_run_ptr(chunk, run_ptr, &found, &run_size, &reg_size);
+    EXPECT_EQ(found, run_ptr);
+    EXPECT_EQ(run_size, expected);
+
+    // Merged buddies are never handed out again
+    for (void *p = chunk_allocate_run(chunk, LARGE_SIZE_MIN_REGION,
+                                      LARGE_SIZE_MIN_REGION);
+         p != nullptr; p = chunk_allocate_run(chunk, LARGE_SIZE_MIN_REGION,
+                                              LARGE_SIZE_MIN_REGION)) {
+      EXPECT_TRUE((uintptr_t)p < (uintptr_t)run_ptr ||
+                  (uintptr_t)p >= (uintptr_t)run_ptr + expected);
+    }
+    EXPECT_TRUE(chunk_is_full(chunk));
+    EXPECT_FALSE(chunk_deallocate_run(chunk, run_ptr));
+  }
+}
+
+TEST_F(ChunkUtilsTest, ChunkExpandRunBlocked) {
+  void *run_ptr, *p;
+  for (uint32_t seed = 1; seed < 64; seed++) {
+    init_splitmix32(seed);
+    chunk_init(chunk, heap);
+    run_ptr = chunk_allocate_run(chunk, LARGE_SIZE_MIN_REGION,
+                                 LARGE_SIZE_MIN_REGION);
+    uintptr_t offset = (uintptr_t)run_ptr - (uintptr_t)chunk->entry.key;
+    if (offset % (2 * LARGE_SIZE_MIN_REGION) != 0) {
+      // Right child has no buddy to grow into
+      EXPECT_EQ(chunk_expand_run(chunk, run_ptr, LARGE_SIZE_MIN_REGION,
+                                 2 * LARGE_SIZE_MIN_REGION,
+                                 LARGE_SIZE_MAX_REGION),
+                LARGE_SIZE_MIN_REGION);
+      continue;
+    }
+    // Take the buddy
+    do {
+      p = chunk_allocate_run(chunk, LARGE_SIZE_MIN_REGION,
+                             LARGE_SIZE_MIN_REGION);
+      ASSERT_NE(p, nullptr);
+    } while ((uintptr_t)p != (uintptr_t)run_ptr + LARGE_SIZE_MIN_REGION);
+    EXPECT_EQ(chunk_expand_run(chunk, run_ptr, LARGE_SIZE_MIN_REGION,
+                               2 * LARGE_SIZE_MIN_REGION,
+                               LARGE_SIZE_MAX_REGION),
+              LARGE_SIZE_MIN_REGION);
+    validate_entire_tree();
+  }
+}
+
 }  // namespace
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+extern "C" {
+#include <sealloc/arena.h>
+#include <sealloc/bin.h>
+#include <sealloc/chunk.h>
+#include <sealloc/conf.h>
+#include <sealloc/run.h>
+#include <sealloc/utils.h>
+}
+
+TEST(Conf, Defaults) {
+  arena_conf_t conf;
+  conf_init(&conf);
+  EXPECT_EQ(conf.bin_min_regions, BIN_MINIMUM_REGIONS);
+  EXPECT_EQ(conf.chunks_per_mapping, CHUNKS_PER_MAPPING);
+  EXPECT_EQ(conf.run_size_small_pages, RUN_SIZE_SMALL_PAGES);
+  EXPECT_EQ(conf.run_size_medium_pages, RUN_SIZE_MEDIUM_PAGES);
+  EXPECT_EQ(conf.random_lookup_tries, RANDOM_LOOKUP_TRIES);
+  EXPECT_EQ(conf.random_lookup_threshold, RANDOM_LOOKUP_TRESHOLD_PERCENTAGE);
+  EXPECT_EQ(conf.chunk_unmap_threshold, CHUNK_UNMAP_THRESHOLD);
+  EXPECT_EQ(conf.prof_interval, PROF_DEFAULT_INTERVAL);
+}
+
+TEST(Conf, ParseValid) {
+  arena_conf_t conf;
+  conf_init(&conf);
+  EXPECT_TRUE(conf_parse(&conf,
+                         "bin_min_regions:64,chunks_per_mapping:8,"
+                         "run_size_small:65536,run_size_medium:32768,"
+                         "random_lookup_tries:0,random_lookup_threshold:100,"
+                         "chunk_unmap_threshold:3,"));
+  EXPECT_EQ(conf.bin_min_regions, 64);
+  EXPECT_EQ(conf.chunks_per_mapping, 8);
+  EXPECT_EQ(conf.run_size_small_pages, 65536 / PAGE_SIZE);
+  EXPECT_EQ(conf.run_size_medium_pages, 32768 / PAGE_SIZE);
+  EXPECT_EQ(conf.random_lookup_tries, 0);
+  EXPECT_EQ(conf.random_lookup_threshold, 100);
+  EXPECT_EQ(conf.chunk_unmap_threshold, 3);
+  EXPECT_TRUE(conf_parse(&conf, ""));
+  EXPECT_TRUE(conf_parse(&conf, ",,"));
+  EXPECT_EQ(conf.bin_min_regions, 64);
+}
+
+TEST(Conf, ParseInvalidSkipped) {
+  arena_conf_t conf;
+  conf_init(&conf);
+  EXPECT_FALSE(conf_parse(&conf,
+                          "unknown:1,bin_min_regions:48,chunks_per_mapping,"
+                          "chunks_per_mapping:x,chunks_per_mapping:-1,"
+                          "chunks_per_mapping:0,chunks_per_mapping:65,"
+                          "random_lookup_threshold:101,"
+                          "chunk_unmap_threshold:99999999999,"
+                          "bin_min_regions_:1,:1,chunks_per_mapping:2"));
+  EXPECT_EQ(conf.bin_min_regions, 48);
+  EXPECT_EQ(conf.chunks_per_mapping, 2);
+  EXPECT_EQ(conf.random_lookup_threshold, RANDOM_LOOKUP_TRESHOLD_PERCENTAGE);
+  EXPECT_EQ(conf.chunk_unmap_threshold, CHUNK_UNMAP_THRESHOLD);
+}
+
+TEST(Conf, ParseRunSize) {
+  arena_conf_t conf;
+  conf_init(&conf);
+  // Below leaf size, not a power of 2, above run_t limits
+  EXPECT_FALSE(conf_parse(&conf, "run_size_small:4096"));
+  EXPECT_FALSE(conf_parse(&conf, "run_size_small:49152"));
+  EXPECT_FALSE(conf_parse(&conf, "run_size_small:1048576"));
+  EXPECT_EQ(conf.run_size_small_pages, RUN_SIZE_SMALL_PAGES);
+  EXPECT_TRUE(conf_parse(&conf, "run_size_small:524288"));
+  EXPECT_EQ(conf.run_size_small_pages, CONF_RUN_SIZE_MAX_BYTES / PAGE_SIZE);
+}
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <string>
+
+extern "C" {
+#include <sealloc/histogram.h>
+#include <sealloc/size_class.h>
+#include <sealloc/utils.h>
+}
+
+static std::string read_fd(int fd) {
+  std::string out;
+  char buf[256];
+  ssize_t len;
+  lseek(fd, 0, SEEK_SET);
+  while ((len = read(fd, buf, sizeof(buf))) > 0) out.append(buf, len);
+  return out;
+}
+
+TEST(Histogram, Bucket) {
+  EXPECT_EQ(hist_bucket(0), 0);
+  EXPECT_EQ(hist_bucket(1), 1);
+  EXPECT_EQ(hist_bucket(2), 2);
+  EXPECT_EQ(hist_bucket(3), 2);
+  EXPECT_EQ(hist_bucket(4), 3);
+  EXPECT_EQ(hist_bucket(4095), 12);
+  EXPECT_EQ(hist_bucket(4096), 13);
+  EXPECT_EQ(hist_bucket(SIZE_MAX), HIST_NO_BUCKETS - 1);
+}
+
+TEST(Histogram, Class) {
+  EXPECT_EQ(hist_class(SMALL_SIZE_MAX_REGION), HIST_CLASS_SMALL);
+  EXPECT_EQ(hist_class(MEDIUM_SIZE_MIN_REGION), HIST_CLASS_MEDIUM);
+  EXPECT_EQ(hist_class(LARGE_SIZE_MIN_REGION), HIST_CLASS_LARGE);
+  EXPECT_EQ(hist_class(LARGE_SIZE_MAX_REGION + 1), HIST_CLASS_HUGE);
+}
+
+TEST(Histogram, Record) {
+  alloc_hist_t hist;
+  hist_init(&hist);
+  hist_record(&hist, 16);
+  hist_record(&hist, 24);
+  hist_record(&hist, MEDIUM_SIZE_MIN_REGION);
+  hist_record(&hist, LARGE_SIZE_MAX_REGION + 1);
+  EXPECT_EQ(hist.class_count[HIST_CLASS_SMALL], 2);
+  EXPECT_EQ(hist.class_bytes[HIST_CLASS_SMALL], 40);
+  EXPECT_EQ(hist.class_count[HIST_CLASS_MEDIUM], 1);
+  EXPECT_EQ(hist.class_bytes[HIST_CLASS_MEDIUM], MEDIUM_SIZE_MIN_REGION);
+  EXPECT_EQ(hist.class_count[HIST_CLASS_LARGE], 0);
+  EXPECT_EQ(hist.class_count[HIST_CLASS_HUGE], 1);
+  EXPECT_EQ(hist.bucket_count[hist_bucket(16)], 2);
+  EXPECT_EQ(hist.bucket_count[hist_bucket(MEDIUM_SIZE_MIN_REGION)], 1);
+}
+
+TEST(Histogram, WriteJson) {
+  alloc_hist_t hist;
+  FILE *fp = tmpfile();
+  ASSERT_NE(fp, nullptr);
+  hist_init(&hist);
+  hist_record(&hist, 16);
+  hist_record(&hist, 0);
+  hist_write_json(&hist, fileno(fp));
+  std::string out = read_fd(fileno(fp));
+  fclose(fp);
+
+  EXPECT_EQ(out.rfind("{\"version\":1,\"pid\":", 0), 0);
+  EXPECT_NE(out.find("\"small\":{\"count\":2,\"bytes\":16}"), std::string::npos);
+  EXPECT_NE(out.find("\"huge\":{\"count\":0,\"bytes\":0}"), std::string::npos);
+  EXPECT_NE(out.find("\"log2_buckets\":[1,0,0,0,0,1,0"), std::string::npos);
+  EXPECT_EQ(out.back(), '\n');
+  EXPECT_EQ(out.find('\n'), out.size() - 1);
+}
+
+TEST(Histogram, DumpAppends) {
+  alloc_hist_t hist;
+  char path[] = "/tmp/sealloc_hist_XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_GE(fd, 0);
+  hist_init(&hist);
+  ASSERT_TRUE(hist_dump(&hist, path));
+  hist_record(&hist, 16);
+  ASSERT_TRUE(hist_dump(&hist, path));
+  std::string out = read_fd(fd);
+  close(fd);
+  unlink(path);
+
+  size_t first = out.find('\n');
+  ASSERT_NE(first, std::string::npos);
+  EXPECT_EQ(out.find('\n', first + 1), out.size() - 1);
+  EXPECT_NE(out.find("\"count\":1"), std::string::npos);
+  EXPECT_FALSE(hist_dump(&hist, "/nonexistent/dir/stats"));
+}
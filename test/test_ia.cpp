@@ -32,6 +32,23 @@ TEST_F(InternalAllocatorTest, BasicAllocations) {
   EXPECT_EQ(b, d);
 }
 
+TEST_F(InternalAllocatorTest, Shrink) {
+  void *a, *b, *c;
+  a = internal_alloc(&ia, 512);
+  ASSERT_NE(a, nullptr);
+  internal_shrink(&ia, a, 100);
+  EXPECT_EQ(ia.free_mem, INTERNAL_ALLOC_CHUNK_SIZE_BYTES - 128);
+  // Halves given back are reused
+  b = internal_alloc(&ia, 256);
+  c = internal_alloc(&ia, 128);
+  EXPECT_EQ(b, (uint8_t *)a + 256);
+  EXPECT_EQ(c, (uint8_t *)a + 128);
+  internal_free(&ia, a);
+  internal_free(&ia, b);
+  internal_free(&ia, c);
+  EXPECT_EQ(ia.free_mem, INTERNAL_ALLOC_CHUNK_SIZE_BYTES);
+}
+
 TEST_F(InternalAllocatorTest, Exhaust) {
   void *a, *b;
   a = internal_alloc(&ia, INTERNAL_ALLOC_CHUNK_SIZE_BYTES);
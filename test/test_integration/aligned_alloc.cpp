@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <tuple>
+#include <vector>
+
+extern "C" {
+#include <sealloc/arena.h>
+#include <sealloc/sealloc.h>
+#include <sealloc/size_class.h>
+#include <sealloc/utils.h>
+}
+
+class AlignedAllocTest
+    : public ::testing::TestWithParam<std::tuple<size_t, size_t>> {
+ protected:
+  arena_t arena;
+  void SetUp() override {
+    arena.is_initialized = 0;
+    arena_init(&arena);
+  }
+};
+
+TEST_P(AlignedAllocTest, RegionsAligned) {
+  auto [alignment, size] = GetParam();
+  constexpr size_t N = 50;
+  std::vector<void *> ptrs;
+  for (size_t i = 0; i < N; i++) {
+    void *ptr = sealloc_aligned_alloc(&arena, alignment, size);
+    ASSERT_NE(ptr, nullptr);
+    EXPECT_TRUE(IS_ALIGNED((uintptr_t)ptr, alignment))
+        << ptr << " not aligned to " << alignment;
+    std::memset(ptr, 0x41, size);
+    ptrs.push_back(ptr);
+  }
+  for (size_t i = 0; i < N; i++) {
+    if (i % 2)
+      sealloc_free_aligned_sized(&arena, ptrs[i], alignment, size);
+    else
+      sealloc_free(&arena, ptrs[i]);
+  }
+  EXPECT_EQ(arena.huge_alloc_list.ll, nullptr);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    AlignedAlloc, AlignedAllocTest,
+    ::testing::Combine(::testing::Values(8, 16, 32, 64, 256, 1024, PAGE_SIZE,
+                                         2 * PAGE_SIZE, 65536, 2097152),
+                       ::testing::Values(1, 24, 100, 600, 5000,
+                                         LARGE_SIZE_MIN_REGION + 1,
+                                         LARGE_SIZE_MAX_REGION + 1)));
+
+TEST(MallocApiTest, AlignedAllocNoOverallocation) {
+  arena_t arena;
+  arena.is_initialized = 0;
+  arena_init(&arena);
+  chunk_t *chunk;
+  run_t *run;
+  bin_t *bin;
+  huge_chunk_t *huge;
+  // Class is picked by stride, 32-byte alignment of 40 bytes is served from
+  // class of 64 bytes, not class of 40 + 32
+  void *ptr = sealloc_aligned_alloc(&arena, 32, 40);
+  ASSERT_EQ(locate_metadata_for_ptr(&arena, ptr, &chunk, &run, &bin, &huge),
+            METADATA_REGULAR);
+  EXPECT_EQ(bin->reg_size, 64);
+  sealloc_free(&arena, ptr);
+  // Above a page alignment comes from the mapping placement
+  ptr = sealloc_aligned_alloc(&arena, 65536, 100);
+  ASSERT_EQ(locate_metadata_for_ptr(&arena, ptr, &chunk, &run, &bin, &huge),
+            METADATA_HUGE);
+  EXPECT_EQ(huge->len, PAGE_SIZE);
+  sealloc_free(&arena, ptr);
+}
+
+TEST(MallocApiTest, FreeAlignedSizedWrongSize) {
+  arena_t arena;
+  arena.is_initialized = 0;
+  arena_init(&arena);
+  void *ptr = sealloc_aligned_alloc(&arena, 65536, 100);
+  ASSERT_NE(ptr, nullptr);
+  EXPECT_DEATH({ sealloc_free_aligned_sized(&arena, ptr, 65536, 3 * PAGE_SIZE); },
+               ".*Invalid call to free_sized().*");
+  sealloc_free_aligned_sized(&arena, ptr, 65536, 100);
+}
+
+TEST(MallocApiTest, ReallocAlignedMappingToLarger) {
+  arena_t arena;
+  arena.is_initialized = 0;
+  arena_init(&arena);
+  // Mapping of one page is smaller than the regular region it moves to
+  void *ptr = sealloc_aligned_alloc(&arena, 2 * PAGE_SIZE, 16);
+  ASSERT_NE(ptr, nullptr);
+  std::memset(ptr, 0x41, 16);
+  ptr = sealloc_realloc(&arena, ptr, 512 * 1024);
+  ASSERT_NE(ptr, nullptr);
+  for (size_t i = 0; i < 16; i++) EXPECT_EQ(((unsigned char *)ptr)[i], 0x41);
+  sealloc_free(&arena, ptr);
+}
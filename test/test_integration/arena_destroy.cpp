@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+extern "C" {
+#include <sealloc/arena.h>
+#include <sealloc/sealloc.h>
+#include <sealloc/size_class.h>
+#include <sealloc/utils.h>
+}
+
+static bool is_mapped(void *ptr) {
+  void *page = (void *)((uintptr_t)ptr & ~(uintptr_t)PAGE_MASK);
+  return msync(page, PAGE_SIZE, MS_ASYNC) == 0 || errno != ENOMEM;
+}
+
+TEST(MallocApiTest, ArenaDestroyUnmapsEverything) {
+  arena_t arena;
+  arena.is_initialized = 0;
+  arena_init(&arena);
+  std::vector<size_t> SIZES{16, 100, 512, 3000, LARGE_SIZE_MIN_REGION,
+                            LARGE_SIZE_MAX_REGION + 1};
+  std::vector<void *> ptrs;
+  for (int i = 0; i < 500; i++) {
+    size_t size = SIZES[i % SIZES.size()];
+    void *ptr = sealloc_malloc(&arena, size);
+    ASSERT_NE(ptr, nullptr);
+    std::memset(ptr, 0x41, size);
+    ptrs.push_back(ptr);
+  }
+  // Leave some holes in chunks
+  for (size_t i = 0; i < ptrs.size(); i += 3) sealloc_free(&arena, ptrs[i]);
+  std::vector<void *> units;
+  for (ll_entry_t *e = arena.internal_alloc_list.ll; e != NULL; e = e->link.fd)
+    units.push_back(e);
+
+  arena_destroy(&arena);
+  EXPECT_EQ(arena.is_initialized, 0);
+  for (void *ptr : ptrs) EXPECT_FALSE(is_mapped(ptr)) << ptr;
+  for (void *unit : units) EXPECT_FALSE(is_mapped(unit)) << unit;
+
+  // Arena can be used again
+  arena_init(&arena);
+  void *ptr = sealloc_malloc(&arena, 64);
+  ASSERT_NE(ptr, nullptr);
+  sealloc_free(&arena, ptr);
+  arena_destroy(&arena);
+}
+
+TEST(MallocApiTest, ArenaDestroyEmpty) {
+  arena_t arena;
+  arena.is_initialized = 0;
+  arena_init(&arena);
+  arena_destroy(&arena);
+  EXPECT_EQ(arena.is_initialized, 0);
+}
+
+TEST(MallocApiTest, SeededArenaRepeatsLayout) {
+  std::vector<size_t> SIZES{16, 100, 512, 3000, LARGE_SIZE_MIN_REGION,
+                            LARGE_SIZE_MAX_REGION + 1};
+  std::vector<void *> first, second;
+  arena_t arena;
+  for (auto *ptrs : {&first, &second}) {
+    arena.is_initialized = 0;
+    arena_init_seeded(&arena, 1234);
+    for (int i = 0; i < 200; i++) {
+      void *ptr = sealloc_malloc(&arena, SIZES[i % SIZES.size()]);
+      ptrs->push_back(ptr);
+      if (i % 4 == 0) sealloc_free(&arena, ptr);
+    }
+    // Same addresses are free to be probed again
+    arena_destroy(&arena);
+  }
+  EXPECT_EQ(first, second);
+}
@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <set>
+#include <vector>
+
+extern "C" {
+#include <sealloc/arena.h>
+#include <sealloc/sealloc.h>
+#include <sealloc/size_class.h>
+}
+
+class BatchApiTest : public ::testing::TestWithParam<size_t> {
+ protected:
+  arena_t arena;
+  void SetUp() override {
+    arena.is_initialized = 0;
+    arena_init(&arena);
+  }
+};
+
+TEST_P(BatchApiTest, MallocBatchDistinctAndWritable) {
+  size_t size = GetParam();
+  constexpr size_t N = 300;
+  std::vector<void *> ptrs(N);
+  EXPECT_EQ(sealloc_batch_malloc(&arena, size, N, ptrs.data()), N);
+  std::set<void *> unique(ptrs.begin(), ptrs.end());
+  EXPECT_EQ(unique.size(), N);
+  EXPECT_EQ(unique.count(nullptr), 0);
+  for (size_t i = 0; i < N; i++) {
+    std::memset(ptrs[i], (int)i, size);
+  }
+  for (size_t i = 0; i < N; i++) {
+    EXPECT_EQ(((unsigned char *)ptrs[i])[size - 1], (unsigned char)i);
+  }
+  std::shuffle(ptrs.begin(), ptrs.end(), std::mt19937{1});
+  sealloc_batch_free(&arena, ptrs.data(), N);
+  if (!IS_SIZE_HUGE(size)) {
+    bin_t *bin = arena_get_bin_by_reg_size(&arena, alignup_size(size));
+    EXPECT_EQ(bin->run_list_inactive.ll, nullptr);
+  } else {
+    EXPECT_EQ(arena.huge_alloc_list.ll, nullptr);
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Batch, BatchApiTest,
+                         ::testing::Values(1, 16, 100, 512, 2048,
+                                           LARGE_SIZE_MIN_REGION + 1,
+                                           LARGE_SIZE_MAX_REGION + 1));
+
+TEST(MallocApiTest, FreeBatchMixedClasses) {
+  arena_t arena;
+  arena.is_initialized = 0;
+  arena_init(&arena);
+  std::vector<size_t> SIZES{5, 16, 17, 50, 4535, 12343, 544223, 2000000};
+  std::vector<void *> ptrs;
+  std::srand(123);
+  for (int i = 0; i < 2000; i++) {
+    ptrs.push_back(sealloc_malloc(&arena, SIZES[rand() % SIZES.size()]));
+    if (i % 100 == 0) ptrs.push_back(nullptr);
+  }
+  std::shuffle(ptrs.begin(), ptrs.end(), std::mt19937{1});
+  sealloc_batch_free(&arena, ptrs.data(), ptrs.size());
+  EXPECT_EQ(arena.huge_alloc_list.ll, nullptr);
+  for (int i = 0; i < ARENA_NO_BINS; i++) {
+    EXPECT_EQ(arena.bins[i].run_list_inactive.ll, nullptr);
+  }
+}
+
+TEST(MallocApiTest, FreeBatchDoubleFree) {
+  arena_t arena;
+  arena.is_initialized = 0;
+  arena_init(&arena);
+  void *reg[3];
+  ASSERT_EQ(sealloc_batch_malloc(&arena, 16, 2, reg), 2);
+  reg[2] = reg[0];
+  EXPECT_DEATH({ sealloc_batch_free(&arena, reg, 3); },
+               ".*Invalid call to free().*");
+}
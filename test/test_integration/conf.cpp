@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+extern "C" {
+#include <sealloc/arena.h>
+#include <sealloc/conf.h>
+#include <sealloc/run.h>
+#include <sealloc/sealloc.h>
+#include <sealloc/size_class.h>
+#include <sealloc/utils.h>
+}
+
+static bool is_mapped(void *ptr) {
+  void *page = (void *)((uintptr_t)ptr & ~(uintptr_t)PAGE_MASK);
+  return msync(page, PAGE_SIZE, MS_ASYNC) == 0 || errno != ENOMEM;
+}
+
+class ConfTest : public ::testing::Test {
+ protected:
+  arena_t arena;
+  void init(const char *conf) {
+    setenv(CONF_ENV_NAME, conf, 1);
+    arena.is_initialized = 0;
+    arena_init(&arena);
+    unsetenv(CONF_ENV_NAME);
+  }
+  void TearDown() override { arena_destroy(&arena); }
+};
+
+TEST_F(ConfTest, ReadFromEnvironment) {
+  init("bin_min_regions:64,chunks_per_mapping:8,bogus:1");
+  EXPECT_EQ(arena.conf.bin_min_regions, 64);
+  EXPECT_EQ(arena.conf.chunks_per_mapping, 8);
+  EXPECT_EQ(arena.conf.run_size_small_pages, RUN_SIZE_SMALL_PAGES);
+
+  void *ptr = sealloc_malloc(&arena, 64);
+  ASSERT_NE(ptr, nullptr);
+  EXPECT_GE(arena_get_bin_by_reg_size(&arena, 64)->avail_regs, 64);
+  // One mapping of chunks was made and one chunk was taken out of it
+  EXPECT_EQ(arena.chunks_left, 7);
+  sealloc_free(&arena, ptr);
+}
+
+TEST_F(ConfTest, BigSmallRuns) {
+  init("run_size_small:65536,run_size_medium:131072");
+  bin_t *bin = arena_get_bin_by_reg_size(&arena, 16);
+  EXPECT_EQ(bin->run_size_pages * PAGE_SIZE, 65536);
+  EXPECT_EQ(arena_get_bin_by_reg_size(&arena, 4096)->run_size_pages * PAGE_SIZE,
+            131072);
+
+  // Regions past the first leaf of a run are found as well
+  std::vector<size_t> sizes{16, 96, 512, 1024, 8192};
+  std::vector<char *> ptrs;
+  for (int i = 0; i < 30000; i++) {
+    size_t size = sizes[i % sizes.size()];
+    char *ptr = (char *)sealloc_malloc(&arena, size);
+    ASSERT_NE(ptr, nullptr);
+    std::memset(ptr, 0x41, size);
+    ASSERT_EQ(sealloc_usable_size(&arena, ptr), size);
+    ptrs.push_back(ptr);
+  }
+  for (char *ptr : ptrs) sealloc_free(&arena, ptr);
+}
+
+TEST_F(ConfTest, UnmapThreshold) {
+  init("chunk_unmap_threshold:1");
+  // Fill whole chunks, so that they can be released
+  std::vector<void *> ptrs;
+  for (int i = 0; i < 4 * 1024; i++) {
+    void *ptr = sealloc_malloc(&arena, LARGE_SIZE_MIN_REGION);
+    ASSERT_NE(ptr, nullptr);
+    std::memset(ptr, 0x41, LARGE_SIZE_MIN_REGION);
+    ptrs.push_back(ptr);
+  }
+  // Freed leaf stays mapped until it merges with its buddy
+  sealloc_free(&arena, ptrs.back());
+  EXPECT_TRUE(is_mapped(ptrs.back()));
+  ptrs.pop_back();
+  for (void *ptr : ptrs) sealloc_free(&arena, ptr);
+  // Chunks with nothing allocated are still released
+  EXPECT_EQ(arena.chunk_list.ll, nullptr);
+}
@@ -0,0 +1,167 @@
+#include <gtest/gtest.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+extern "C" {
+#include <sealloc/arena.h>
+#include <sealloc/ctl.h>
+#include <sealloc/sealloc.h>
+#include <sealloc/size_class.h>
+#include <sealloc/utils.h>
+}
+
+class CtlTest : public ::testing::Test {
+ protected:
+  arena_t arena;
+  void SetUp() override {
+    arena.is_initialized = 0;
+    arena_init(&arena);
+  }
+  void TearDown() override { arena_destroy(&arena); }
+
+  int read(const char *name, unsigned *val) {
+    size_t len = sizeof(*val);
+    return ctl_by_name(&arena, name, val, &len, nullptr, 0);
+  }
+  int write(const char *name, unsigned val) {
+    return ctl_by_name(&arena, name, nullptr, nullptr, &val, sizeof(val));
+  }
+};
+
+TEST_F(CtlTest, UnknownNames) {
+  unsigned val;
+  EXPECT_EQ(read("", &val), ENOENT);
+  EXPECT_EQ(read("arena", &val), ENOENT);
+  EXPECT_EQ(read("arena.0", &val), ENOENT);
+  EXPECT_EQ(read("arena.1.nbins", &val), ENOENT);
+  EXPECT_EQ(read("arena.x.nbins", &val), ENOENT);
+  EXPECT_EQ(read("arena..nbins", &val), ENOENT);
+  EXPECT_EQ(read("arena.0.nbins.", &val), ENOENT);
+  EXPECT_EQ(read("arena.0.nbin", &val), ENOENT);
+  EXPECT_EQ(read("arena.0.nbinsx", &val), ENOENT);
+  EXPECT_EQ(read("arena.0.bins.43.reg_size", &val), ENOENT);
+  EXPECT_EQ(read("arena.0.bins.99999999999.reg_size", &val), ENOENT);
+  EXPECT_EQ(read("arena.0.bins.1", &val), ENOENT);
+}
+
+TEST_F(CtlTest, ReadOnly) {
+  unsigned val = 0;
+  size_t len = sizeof(val);
+  EXPECT_EQ(read("arena.0.nbins", &val), 0);
+  EXPECT_EQ(val, ARENA_NO_BINS);
+  EXPECT_EQ(write("arena.0.nbins", 1), EPERM);
+  EXPECT_EQ(write("arena.0.conf.run_size_small", 65536), EPERM);
+  len = 1;
+  EXPECT_EQ(ctl_by_name(&arena, "arena.0.nbins", &val, &len, nullptr, 0),
+            EINVAL);
+  // Length alone can be queried
+  len = 0;
+  EXPECT_EQ(ctl_by_name(&arena, "arena.0.nbins", nullptr, &len, nullptr, 0),
+            0);
+  EXPECT_EQ(len, sizeof(unsigned));
+}
+
+TEST_F(CtlTest, Bins) {
+  unsigned val;
+  void *small = sealloc_malloc(&arena, SMALL_SIZE_MIN_REGION);
+  void *large = sealloc_malloc(&arena, LARGE_SIZE_MAX_REGION);
+  EXPECT_EQ(read("arena.0.bins.0.reg_size", &val), 0);
+  EXPECT_EQ(val, SMALL_SIZE_MIN_REGION);
+  EXPECT_EQ(read("arena.0.bins.42.reg_size", &val), 0);
+  EXPECT_EQ(val, LARGE_SIZE_MAX_REGION);
+  sealloc_free(&arena, small);
+  sealloc_free(&arena, large);
+
+  EXPECT_EQ(write("arena.0.bins.3.min_regions", 0), EINVAL);
+  EXPECT_EQ(write("arena.0.bins.3.min_regions", 500), 0);
+  EXPECT_EQ(read("arena.0.bins.3.min_regions", &val), 0);
+  EXPECT_EQ(val, 500);
+  void *ptr = sealloc_malloc(&arena, 64);
+  ASSERT_NE(ptr, nullptr);
+  EXPECT_EQ(read("arena.0.bins.3.run_size", &val), 0);
+  EXPECT_EQ(val, arena.conf.run_size_small_pages * PAGE_SIZE);
+  EXPECT_EQ(read("arena.0.bins.3.avail_regs", &val), 0);
+  EXPECT_GE(val, 500);
+  EXPECT_EQ(read("arena.0.bins.3.nruns", &val), 0);
+  EXPECT_GE(val, 2);
+  // Other bins keep configured minimum
+  void *other = sealloc_malloc(&arena, 80);
+  EXPECT_EQ(read("arena.0.bins.4.min_regions", &val), 0);
+  EXPECT_EQ(val, arena.conf.bin_min_regions);
+  sealloc_free(&arena, other);
+  sealloc_free(&arena, ptr);
+}
+
+TEST_F(CtlTest, UnusedBinReadsZeros) {
+  const char *leaves[] = {"reg_size", "run_size", "avail_regs", "nruns",
+                          "min_regions"};
+  char name[64];
+  unsigned val;
+  for (const char *leaf : leaves) {
+    snprintf(name, sizeof(name), "arena.0.bins.10.%s", leaf);
+    val = 1;
+    EXPECT_EQ(read(name, &val), 0) << name;
+    EXPECT_EQ(val, 0) << name;
+  }
+  // Reading leaves the bin untouched
+  EXPECT_EQ(arena.bins[10].reg_size, 0);
+}
+
+TEST_F(CtlTest, Conf) {
+  unsigned val, old;
+  size_t len = sizeof(val);
+  val = 7;
+  EXPECT_EQ(ctl_by_name(&arena, "arena.0.conf.random_lookup_tries", &old, &len,
+                        &val, sizeof(val)),
+            0);
+  EXPECT_EQ(old, RANDOM_LOOKUP_TRIES);
+  EXPECT_EQ(arena.conf.random_lookup_tries, 7);
+  EXPECT_EQ(write("arena.0.conf.random_lookup_threshold", 101), EINVAL);
+  EXPECT_EQ(ctl_by_name(&arena, "arena.0.conf.chunks_per_mapping", nullptr,
+                        nullptr, &val, 1),
+            EINVAL);
+
+  void *ptr = sealloc_malloc(&arena, 64);
+  ASSERT_NE(ptr, nullptr);
+  chunk_t *chunk = arena_get_chunk_from_ptr(&arena, ptr, NULL);
+  ASSERT_NE(chunk, nullptr);
+  EXPECT_EQ(chunk->random_lookup_tries, 7);
+  // Existing chunks and bins follow changes
+  EXPECT_EQ(write("arena.0.conf.random_lookup_tries", 2), 0);
+  EXPECT_EQ(chunk->random_lookup_tries, 2);
+  EXPECT_EQ(write("arena.0.conf.bin_min_regions", 100), 0);
+  EXPECT_EQ(arena_get_bin_by_reg_size(&arena, 64)->min_regions, 100);
+  sealloc_free(&arena, ptr);
+}
+
+TEST_F(CtlTest, Decommit) {
+  size_t released = 1, len = sizeof(released);
+  unsigned nchunks;
+  EXPECT_EQ(ctl_by_name(&arena, "arena.0.decommit", &released, &len, nullptr,
+                        0),
+            0);
+  EXPECT_EQ(released, 0);
+  ASSERT_EQ(write("arena.0.conf.chunk_unmap_threshold", 11), 0);
+
+  std::vector<void *> ptrs;
+  for (int i = 0; i < 8; i++) {
+    void *ptr = sealloc_malloc(&arena, LARGE_SIZE_MIN_REGION);
+    ASSERT_NE(ptr, nullptr);
+    ptrs.push_back(ptr);
+  }
+  for (void *ptr : ptrs) sealloc_free(&arena, ptr);
+  EXPECT_EQ(read("arena.0.nchunks", &nchunks), 0);
+  EXPECT_GE(nchunks, 1);
+  // Freed runs were kept mapped until now
+  EXPECT_EQ(ctl_by_name(&arena, "arena.0.decommit", &released, &len, nullptr,
+                        0),
+            0);
+  EXPECT_EQ(released, ptrs.size() * LARGE_SIZE_MIN_REGION);
+  EXPECT_EQ(ctl_by_name(&arena, "arena.0.decommit", &released, &len, nullptr,
+                        0),
+            0);
+  EXPECT_EQ(released, 0);
+}
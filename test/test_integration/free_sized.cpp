@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+extern "C" {
+#include <sealloc/arena.h>
+#include <sealloc/sealloc.h>
+#include <sealloc/size_class.h>
+}
+
+class FreeSizedTest : public ::testing::TestWithParam<size_t> {
+ protected:
+  arena_t arena;
+  void SetUp() override {
+    arena.is_initialized = 0;
+    arena_init(&arena);
+  }
+};
+
+TEST_P(FreeSizedTest, FreeSizedReleasesEverything) {
+  size_t size = GetParam();
+  constexpr size_t N = 200;
+  std::vector<void *> ptrs;
+  for (size_t i = 0; i < N; i++) {
+    ptrs.push_back(sealloc_malloc(&arena, size));
+    ASSERT_NE(ptrs.back(), nullptr);
+  }
+  std::shuffle(ptrs.begin(), ptrs.end(), std::mt19937{7});
+  for (void *ptr : ptrs) sealloc_free_sized(&arena, ptr, size);
+  if (!IS_SIZE_HUGE(size)) {
+    bin_t *bin = arena_get_bin_by_reg_size(&arena, alignup_size(size));
+    EXPECT_EQ(bin->run_list_inactive.ll, nullptr);
+  } else {
+    EXPECT_EQ(arena.huge_alloc_list.ll, nullptr);
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(FreeSized, FreeSizedTest,
+                         ::testing::Values(1, 16, 100, 512, 2048,
+                                           LARGE_SIZE_MIN_REGION + 1,
+                                           LARGE_SIZE_MAX_REGION + 1));
+
+TEST(MallocApiTest, FreeSizedAnySizeWithinClass) {
+  arena_t arena;
+  arena.is_initialized = 0;
+  arena_init(&arena);
+  void *reg = sealloc_malloc(&arena, 20);
+  ASSERT_NE(reg, nullptr);
+  // 20 and 30 both fall into class of 32 bytes
+  sealloc_free_sized(&arena, reg, 30);
+  reg = sealloc_malloc(&arena, 0);
+  ASSERT_NE(reg, nullptr);
+  sealloc_free_sized(&arena, reg, 0);
+  sealloc_free_sized(&arena, nullptr, 100);
+}
+
+TEST(MallocApiTest, FreeAlignedSized) {
+  arena_t arena;
+  arena.is_initialized = 0;
+  arena_init(&arena);
+  void *reg = sealloc_malloc(&arena, 64);
+  ASSERT_NE(reg, nullptr);
+  sealloc_free_aligned_sized(&arena, reg, 64, 40);
+}
+
+TEST(MallocApiTest, FreeSizedWrongClass) {
+  arena_t arena;
+  arena.is_initialized = 0;
+  arena_init(&arena);
+  void *reg = sealloc_malloc(&arena, 16);
+  ASSERT_NE(reg, nullptr);
+  EXPECT_DEATH({ sealloc_free_sized(&arena, reg, 64); },
+               ".*Invalid call to free_sized().*");
+  void *large = sealloc_malloc(&arena, LARGE_SIZE_MIN_REGION);
+  ASSERT_NE(large, nullptr);
+  EXPECT_DEATH({ sealloc_free_sized(&arena, large, LARGE_SIZE_MIN_REGION * 2); },
+               ".*Invalid call to free_sized().*");
+}
+
+TEST(MallocApiTest, FreeSizedDoubleFree) {
+  arena_t arena;
+  arena.is_initialized = 0;
+  arena_init(&arena);
+  void *reg = sealloc_malloc(&arena, 16);
+  ASSERT_NE(reg, nullptr);
+  sealloc_free_sized(&arena, reg, 16);
+  EXPECT_DEATH({ sealloc_free_sized(&arena, reg, 16); },
+               ".*Invalid call to free_sized().*");
+}
+
+TEST(MallocApiTest, FreeSizedWrongHugeSize) {
+  arena_t arena;
+  arena.is_initialized = 0;
+  arena_init(&arena);
+  size_t size = LARGE_SIZE_MAX_REGION + 1;
+  void *reg = sealloc_malloc(&arena, size);
+  ASSERT_NE(reg, nullptr);
+  EXPECT_DEATH({ sealloc_free_sized(&arena, reg, size + 2 * PAGE_SIZE); },
+               ".*Invalid call to free_sized().*");
+  sealloc_free_sized(&arena, reg, size);
+}
@@ -0,0 +1,199 @@
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <sealloc/arena.h>
+#include <sealloc/chunk.h>
+#include <sealloc/heap_dump.h>
+#include <sealloc/run.h>
+#include <sealloc/sealloc.h>
+#include <sealloc/size_class.h>
+#include <sealloc/utils.h>
+}
+
+struct parsed_run {
+  heap_dump_run_t run;
+  std::vector<unsigned> states;
+};
+
+struct parsed_chunk {
+  uint64_t addr;
+  std::vector<uint8_t> tree;
+  std::vector<uint16_t> marks;
+};
+
+struct parsed_dump {
+  heap_dump_header_t header;
+  std::vector<parsed_chunk> chunks;
+  std::vector<parsed_run> runs;
+  std::vector<heap_dump_huge_t> huge;
+};
+
+static std::string read_fd(int fd) {
+  std::string out;
+  char buf[4096];
+  ssize_t len;
+  lseek(fd, 0, SEEK_SET);
+  while ((len = read(fd, buf, sizeof(buf))) > 0) out.append(buf, len);
+  return out;
+}
+
+// Parses dumps one after another, fails if any of them is malformed
+static std::vector<parsed_dump> parse(const std::string &data) {
+  std::vector<parsed_dump> dumps;
+  size_t off = 0;
+  while (off < data.size()) {
+    parsed_dump dump;
+    heap_dump_record_t rec;
+    EXPECT_GE(data.size() - off, sizeof(dump.header));
+    memcpy(&dump.header, data.data() + off, sizeof(dump.header));
+    EXPECT_STREQ(dump.header.magic, HEAP_DUMP_MAGIC);
+    EXPECT_EQ(dump.header.version, HEAP_DUMP_FORMAT_VERSION);
+    off += sizeof(dump.header);
+    do {
+      if (data.size() - off < sizeof(rec)) {
+        ADD_FAILURE() << "Dump is not terminated";
+        return dumps;
+      }
+      memcpy(&rec, data.data() + off, sizeof(rec));
+      off += sizeof(rec);
+      EXPECT_EQ(rec.len % 8, 0);
+      EXPECT_LE(rec.len, data.size() - off);
+      const char *payload = data.data() + off;
+      if (rec.type == HEAP_DUMP_CHUNK) {
+        parsed_chunk chunk;
+        memcpy(&chunk.addr, payload, sizeof(chunk.addr));
+        payload += sizeof(chunk.addr);
+        chunk.tree.assign(payload, payload + CHUNK_BUDDY_TREE_SIZE_BYTES);
+        payload += CHUNK_BUDDY_TREE_SIZE_BYTES;
+        chunk.marks.resize(CHUNK_NO_NODES_LAST_LAYER);
+        memcpy(chunk.marks.data(), payload,
+               CHUNK_NO_NODES_LAST_LAYER * sizeof(uint16_t));
+        dump.chunks.push_back(chunk);
+      } else if (rec.type == HEAP_DUMP_RUN) {
+        parsed_run run;
+        memcpy(&run.run, payload, sizeof(run.run));
+        payload += sizeof(run.run);
+        for (unsigned i = 0; i < run.run.nregs; i++)
+          run.states.push_back((payload[i / 4] >> (2 * (i % 4))) & 3);
+        dump.runs.push_back(run);
+      } else if (rec.type == HEAP_DUMP_HUGE) {
+        heap_dump_huge_t huge;
+        memcpy(&huge, payload, sizeof(huge));
+        dump.huge.push_back(huge);
+      } else {
+        EXPECT_EQ(rec.type, HEAP_DUMP_END);
+      }
+      off += rec.len;
+    } while (rec.type != HEAP_DUMP_END);
+    dumps.push_back(dump);
+  }
+  return dumps;
+}
+
+static unsigned tree_node(const parsed_chunk &chunk, unsigned idx) {
+  return (chunk.tree[(idx - 1) / 4] >> (2 * ((idx - 1) % 4))) & 3;
+}
+
+class HeapDumpTest : public ::testing::Test {
+ protected:
+  arena_t arena;
+  int fd;
+  char path[32];
+  void SetUp() override {
+    arena.is_initialized = 0;
+    arena_init(&arena);
+    strcpy(path, "/tmp/sealloc_heap_XXXXXX");
+    fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+  }
+  void TearDown() override {
+    close(fd);
+    unlink(path);
+    arena_destroy(&arena);
+  }
+};
+
+TEST_F(HeapDumpTest, EmptyArena) {
+  ASSERT_TRUE(heap_dump(&arena, fd));
+  auto dumps = parse(read_fd(fd));
+  ASSERT_EQ(dumps.size(), 1);
+  EXPECT_EQ(dumps[0].header.pid, (uint32_t)getpid());
+  EXPECT_EQ(dumps[0].header.chunk_size, CHUNK_SIZE_BYTES);
+  EXPECT_EQ(dumps[0].header.leaf_size, CHUNK_LEAST_REGION_SIZE_BYTES);
+  EXPECT_EQ(dumps[0].header.tree_depth, CHUNK_BUDDY_TREE_DEPTH);
+  EXPECT_TRUE(dumps[0].chunks.empty());
+  EXPECT_TRUE(dumps[0].runs.empty());
+  EXPECT_TRUE(dumps[0].huge.empty());
+}
+
+TEST_F(HeapDumpTest, Layout) {
+  std::vector<void *> ptrs;
+  for (int i = 0; i < 100; i++) ptrs.push_back(sealloc_malloc(&arena, 64));
+  for (int i = 0; i < 10; i++) sealloc_free(&arena, ptrs[i]);
+  void *large = sealloc_malloc(&arena, LARGE_SIZE_MIN_REGION);
+  void *huge = sealloc_malloc(&arena, LARGE_SIZE_MAX_REGION + 1);
+  ASSERT_TRUE(heap_dump(&arena, fd));
+  auto dumps = parse(read_fd(fd));
+  ASSERT_EQ(dumps.size(), 1);
+  const parsed_dump &dump = dumps[0];
+
+  unsigned live = 0, freed = 0;
+  for (const parsed_run &run : dump.runs) {
+    if (run.run.reg_size != 64) continue;
+    EXPECT_EQ(run.run.nregs, run.run.run_size / 64);
+    for (unsigned state : run.states) {
+      live += state == STATE_ALLOC;
+      freed += state == STATE_ALLOC_FREE;
+    }
+  }
+  EXPECT_EQ(live, 90);
+  EXPECT_EQ(freed, 10);
+
+  ASSERT_EQ(dump.huge.size(), 1);
+  EXPECT_EQ(dump.huge[0].addr, (uintptr_t)huge);
+  EXPECT_EQ(dump.huge[0].len, ALIGNUP_PAGE(LARGE_SIZE_MAX_REGION + 1));
+
+  // Large region is marked at its first leaf, which belongs to a used node
+  bool found = false;
+  for (const parsed_chunk &chunk : dump.chunks) {
+    uintptr_t off = (uintptr_t)large - chunk.addr;
+    if (off >= CHUNK_SIZE_BYTES) continue;
+    unsigned leaf = off / CHUNK_LEAST_REGION_SIZE_BYTES;
+    EXPECT_NE(chunk.marks[leaf] & REG_MARK_LARGE, 0);
+    unsigned idx = leaf + CHUNK_NO_NODES_LAST_LAYER;
+    unsigned order = chunk.marks[leaf] & REG_MARK_LARGE_ORDER_MASK;
+    EXPECT_EQ(tree_node(chunk, idx >> order), 1);
+    found = true;
+  }
+  EXPECT_TRUE(found);
+
+  for (size_t i = 10; i < ptrs.size(); i++) sealloc_free(&arena, ptrs[i]);
+  sealloc_free(&arena, large);
+  sealloc_free(&arena, huge);
+}
+
+TEST_F(HeapDumpTest, DumpsAppend) {
+  void *ptr = sealloc_malloc(&arena, 64);
+  ASSERT_TRUE(heap_dump(&arena, fd));
+  sealloc_free(&arena, ptr);
+  ASSERT_TRUE(heap_dump(&arena, fd));
+  auto dumps = parse(read_fd(fd));
+  ASSERT_EQ(dumps.size(), 2);
+  EXPECT_LE(dumps[0].header.timestamp, dumps[1].header.timestamp);
+  EXPECT_EQ(dumps[0].chunks.size(), 1);
+  EXPECT_EQ(dumps[0].runs.size(), 1);
+}
+
+TEST_F(HeapDumpTest, WriteError) {
+  int ro = open("/dev/null", O_RDONLY);
+  ASSERT_GE(ro, 0);
+  EXPECT_FALSE(heap_dump(&arena, ro));
+  close(ro);
+}
@@ -0,0 +1,155 @@
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <vector>
+
+extern "C" {
+#include <sealloc/arena.h>
+#include <sealloc/live_stats.h>
+#include <sealloc/sealloc.h>
+}
+
+class LiveStatsTest : public ::testing::Test {
+ protected:
+  arena_t arena;
+  live_stats_t live;
+  void SetUp() override {
+    arena.is_initialized = 0;
+    arena_init(&arena);
+    ASSERT_TRUE(live_stats_open(&live, &arena, 0, false));
+  }
+  void TearDown() override {
+    live_stats_close(&live);
+    arena_destroy(&arena);
+  }
+  // Maps segment the way a reader in another process does
+  const live_segment_t *attach() {
+    int fd = open(live.path, O_RDONLY);
+    EXPECT_GE(fd, 0);
+    void *seg =
+        mmap(NULL, sizeof(live_segment_t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    EXPECT_NE(seg, MAP_FAILED);
+    return static_cast<const live_segment_t *>(seg);
+  }
+};
+
+TEST_F(LiveStatsTest, Header) {
+  char path[LIVE_PATH_MAX];
+  live_stats_path(getpid(), path);
+  EXPECT_STREQ(live.path, path);
+  const live_segment_t *seg = attach();
+  EXPECT_STREQ(seg->magic, LIVE_MAGIC);
+  EXPECT_EQ(seg->version, LIVE_FORMAT_VERSION);
+  EXPECT_EQ(seg->size, sizeof(live_segment_t));
+  EXPECT_EQ(seg->pid, (uint32_t)getpid());
+  EXPECT_EQ(seg->seq, 2);
+  munmap((void *)seg, sizeof(live_segment_t));
+}
+
+TEST_F(LiveStatsTest, PublishesEveryCheck) {
+  const live_segment_t *seg = attach();
+  std::vector<void *> ptrs;
+  for (int i = 0; i < LIVE_CHECK_OPS; i++) {
+    ptrs.push_back(sealloc_malloc(&arena, 64));
+    live_stats_tick(&live, &arena, false);
+  }
+  // Zero interval publishes on every check
+  EXPECT_EQ(seg->seq, 4);
+  EXPECT_EQ(seg->seq % 2, 0);
+  EXPECT_EQ(seg->nallocs, LIVE_CHECK_OPS);
+  EXPECT_EQ(seg->nfrees, 0);
+  EXPECT_EQ(seg->stats.small_bytes, 64 * LIVE_CHECK_OPS);
+  for (void *ptr : ptrs) {
+    sealloc_free(&arena, ptr);
+    live_stats_tick(&live, &arena, true);
+  }
+  EXPECT_EQ(seg->seq, 6);
+  EXPECT_EQ(seg->nfrees, LIVE_CHECK_OPS);
+  EXPECT_EQ(seg->stats.small_bytes, 0);
+  munmap((void *)seg, sizeof(live_segment_t));
+}
+
+TEST_F(LiveStatsTest, IntervalNotPassed) {
+  const live_segment_t *seg = attach();
+  live_stats_close(&live);
+  ASSERT_TRUE(live_stats_open(&live, &arena, 3600 * 1000, false));
+  munmap((void *)seg, sizeof(live_segment_t));
+  seg = attach();
+  for (int i = 0; i < LIVE_CHECK_OPS; i++)
+    live_stats_tick(&live, &arena, false);
+  EXPECT_EQ(seg->seq, 2);
+  EXPECT_EQ(seg->nallocs, 0);
+  live_stats_publish(&live, &arena);
+  EXPECT_EQ(seg->nallocs, LIVE_CHECK_OPS);
+  munmap((void *)seg, sizeof(live_segment_t));
+}
+
+TEST_F(LiveStatsTest, CloseRemovesSegment) {
+  char path[LIVE_PATH_MAX];
+  memcpy(path, live.path, sizeof(path));
+  live_stats_close(&live);
+  EXPECT_EQ(live.seg, nullptr);
+  EXPECT_NE(access(path, F_OK), 0);
+  // Closing twice is harmless
+  live_stats_close(&live);
+}
+
+TEST_F(LiveStatsTest, DetachedCreatesOnCheck) {
+  char path[LIVE_PATH_MAX];
+  memcpy(path, live.path, sizeof(path));
+  live_stats_tick(&live, &arena, false);
+  live_stats_detach(&live);
+  EXPECT_EQ(live.seg, nullptr);
+  EXPECT_EQ(live.nallocs, 0);
+  // Segment of parent is left in place
+  EXPECT_EQ(access(path, F_OK), 0);
+  arena.live = &live;
+  for (int i = 0; i < LIVE_CHECK_OPS; i++)
+    live_stats_tick(&live, &arena, false);
+  ASSERT_NE(live.seg, nullptr);
+  EXPECT_EQ(arena.live, &live);
+  const live_segment_t *seg = attach();
+  EXPECT_EQ(seg->version, LIVE_FORMAT_VERSION);
+  EXPECT_EQ(seg->nallocs, LIVE_CHECK_OPS);
+  EXPECT_EQ(seg->interval_ms, 0);
+  munmap((void *)seg, sizeof(live_segment_t));
+}
+
+TEST_F(LiveStatsTest, OwnerOnlyByDefault) {
+  struct stat st;
+  ASSERT_EQ(stat(live.path, &st), 0);
+  EXPECT_EQ(st.st_mode & 0777, 0600);
+  live_stats_close(&live);
+  ASSERT_TRUE(live_stats_open(&live, &arena, 0, true));
+  ASSERT_EQ(stat(live.path, &st), 0);
+  EXPECT_EQ(st.st_mode & (S_IRGRP | S_IROTH), S_IRGRP | S_IROTH);
+  EXPECT_EQ(st.st_mode & (S_IWGRP | S_IWOTH), 0);
+}
+
+TEST_F(LiveStatsTest, ReplacesStaleFile) {
+  char path[LIVE_PATH_MAX];
+  char target[] = "/tmp/sealloc-live-XXXXXX";
+  struct stat st;
+  int fd = mkstemp(target);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(write(fd, "keep", 4), 4);
+  close(fd);
+  memcpy(path, live.path, sizeof(path));
+  live_stats_close(&live);
+  // Symlink planted at the path is removed, not followed
+  ASSERT_EQ(symlink(target, path), 0);
+  ASSERT_TRUE(live_stats_open(&live, &arena, 0, false));
+  ASSERT_EQ(lstat(path, &st), 0);
+  EXPECT_TRUE(S_ISREG(st.st_mode));
+  ASSERT_EQ(stat(target, &st), 0);
+  EXPECT_EQ(st.st_size, 4);
+  const live_segment_t *seg = attach();
+  EXPECT_STREQ(seg->magic, LIVE_MAGIC);
+  munmap((void *)seg, sizeof(live_segment_t));
+  unlink(target);
+}
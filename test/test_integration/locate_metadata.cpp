@@ -58,6 +58,30 @@ TEST(MallocApiTest, HugeInChunkHandlingUnmappedNode) {
             METADATA_HUGE);
 }
 
+TEST(MallocApiTest, LargeHasNoRunMetadata) {
+  arena_t arena;
+  arena.is_initialized = 0;
+  arena_init(&arena);
+  void *large = sealloc_malloc(&arena, 2 * LARGE_SIZE_MIN_REGION);
+#if __aarch64__
+  large = PTR_CLEAR_TAG(large);
+#endif
+  chunk_t *chunk;
+  bin_t *bin;
+  run_t *run;
+  huge_chunk_t *huge_m;
+  EXPECT_EQ(locate_metadata_for_ptr(&arena, large, &chunk, &run, &bin, &huge_m),
+            METADATA_LARGE);
+  EXPECT_EQ(run, nullptr);
+  EXPECT_EQ(bin->reg_size, 2 * LARGE_SIZE_MIN_REGION);
+  EXPECT_EQ(locate_metadata_for_ptr(&arena, (char *)large + 16, &chunk, &run,
+                                    &bin, &huge_m),
+            METADATA_INVALID);
+  sealloc_free(&arena, large);
+  EXPECT_EQ(locate_metadata_for_ptr(&arena, large, &chunk, &run, &bin, &huge_m),
+            METADATA_INVALID);
+}
+
 TEST(MallocApiTest, InvalidFreeHandling) {
   std::vector<void *> large;
   arena_t arena;
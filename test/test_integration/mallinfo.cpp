@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include <malloc.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <sealloc_api.h>
+
+TEST(MallinfoTest, CountsLiveBytes) {
+  std::vector<void *> ptrs;
+  ptrs.reserve(64);
+  struct mallinfo2 before = mallinfo2();
+  for (int i = 0; i < 64; i++) ptrs.push_back(malloc(1000));
+  void *huge = malloc(4 << 20);
+  ASSERT_NE(huge, nullptr);
+  struct mallinfo2 after = mallinfo2();
+  EXPECT_EQ(after.uordblks - before.uordblks, 64 * 1024);
+  EXPECT_EQ(after.hblks - before.hblks, 1);
+  EXPECT_EQ(after.hblkhd - before.hblkhd, 4 << 20);
+  EXPECT_GE(after.arena, after.uordblks);
+  EXPECT_EQ(after.arena, after.uordblks + after.fordblks);
+  for (void *ptr : ptrs) free(ptr);
+  free(huge);
+  after = mallinfo2();
+  EXPECT_EQ(after.hblks, before.hblks);
+}
+
+TEST(MallinfoTest, Trim) {
+  malloc_trim(0);
+  EXPECT_EQ(mallinfo2().keepcost, 0);
+  EXPECT_EQ(malloc_trim(0), 0);
+  void *ptr = malloc(64);
+  ASSERT_NE(ptr, nullptr);
+  free(ptr);
+}
+
+TEST(MallinfoTest, InfoXml) {
+  void *ptr = malloc(48);
+  ASSERT_NE(ptr, nullptr);
+  char *buf = nullptr;
+  size_t len = 0;
+  FILE *fp = open_memstream(&buf, &len);
+  ASSERT_NE(fp, nullptr);
+  EXPECT_EQ(malloc_info(0, fp), 0);
+  fclose(fp);
+  std::string xml(buf, len);
+  free(buf);
+  EXPECT_EQ(xml.rfind("<malloc version=", 0), 0);
+  EXPECT_NE(xml.find("<size class=\"small\" size=\"48\""), std::string::npos);
+  EXPECT_NE(xml.find("</malloc>"), std::string::npos);
+  EXPECT_EQ(malloc_info(1, stdout), -1);
+  free(ptr);
+}
+
+TEST(StatsApiTest, Get) {
+  struct sealloc_stats before, after;
+  sealloc_stats_get(&before);
+  void *ptr = malloc(200);
+  ASSERT_NE(ptr, nullptr);
+  sealloc_stats_get(&after);
+  const struct sealloc_bin_stats *bin = nullptr;
+  for (auto &b : after.bins)
+    if (b.reg_size == 208) bin = &b;
+  ASSERT_NE(bin, nullptr);
+  size_t idx = bin - after.bins;
+  EXPECT_EQ(bin->nallocs - before.bins[idx].nallocs, 1);
+  EXPECT_GE(bin->live_regs, 1);
+  EXPECT_GE(after.nchunks, 1);
+  EXPECT_GT(after.chunks.run_bytes, 0);
+
+  struct sealloc_chunk_stats chunk;
+  size_t run_bytes = 0;
+  for (size_t i = 0; i < after.nchunks; i++) {
+    ASSERT_EQ(sealloc_stats_get_chunk(i, &chunk), 0);
+    run_bytes += chunk.run_bytes;
+  }
+  EXPECT_EQ(run_bytes, after.chunks.run_bytes);
+  EXPECT_EQ(sealloc_stats_get_chunk(after.nchunks, &chunk), ENOENT);
+
+  free(ptr);
+  sealloc_stats_get(&after);
+  EXPECT_EQ(after.bins[idx].nfrees - before.bins[idx].nfrees, 1);
+}
+
+TEST(StatsApiTest, WriteJson) {
+  char *buf = nullptr;
+  size_t len = 0;
+  FILE *fp = open_memstream(&buf, &len);
+  ASSERT_NE(fp, nullptr);
+  EXPECT_EQ(sealloc_stats_write_json(fp), 0);
+  fclose(fp);
+  std::string json(buf, len);
+  free(buf);
+  EXPECT_EQ(json.rfind("{\"bins\":[", 0), 0);
+  EXPECT_NE(json.find("\"totals\":{"), std::string::npos);
+  EXPECT_EQ(sealloc_stats_write_json(nullptr), EINVAL);
+}
+
+TEST(StatsApiTest, Mappings) {
+  struct sealloc_stats before, after;
+  sealloc_stats_get(&before);
+  void *huge = malloc(8 << 20);
+  ASSERT_NE(huge, nullptr);
+  sealloc_stats_get(&after);
+  EXPECT_EQ(after.mapped_bytes - before.mapped_bytes, 8 << 20);
+  EXPECT_EQ(after.nvmas - before.nvmas, 1);
+  EXPECT_GE(after.nprobe_calls - before.nprobe_calls, 1);
+  EXPECT_EQ(after.guard_bytes, after.nchunks * 4096);
+  free(huge);
+  sealloc_stats_get(&after);
+  EXPECT_EQ(after.nunmap_calls - before.nunmap_calls, 1);
+  EXPECT_EQ(after.mapped_bytes, before.mapped_bytes);
+}
@@ -61,12 +61,16 @@ TEST(MallocApiTest, CorrectBinStateLarge) {
   void *reg;
   size_t base = NO_SMALL_SIZE_CLASSES + NO_MEDIUM_SIZE_CLASSES;
   size_t idx = base + size_to_idx_large(LARGE_SIZE_MIN_REGION);
+  // Large regions are tracked by chunks only, bin never holds runs
   reg = sealloc_malloc(&arena, LARGE_SIZE_MIN_REGION);
   EXPECT_NE(reg, nullptr);
-  EXPECT_EQ(arena.bins[idx].run_list_active_cnt, BIN_MINIMUM_REGIONS - 1);
-  EXPECT_EQ(arena.bins[idx].avail_regs, BIN_MINIMUM_REGIONS - 1);
+  EXPECT_EQ(arena.bins[idx].run_list_active_cnt, 0);
+  EXPECT_EQ(arena.bins[idx].avail_regs, 0);
+  EXPECT_EQ(arena.bins[idx].run_list_inactive.ll, nullptr);
 
   reg = sealloc_malloc(&arena, LARGE_SIZE_MIN_REGION);
-  EXPECT_EQ(arena.bins[idx].run_list_active_cnt, BIN_MINIMUM_REGIONS - 1);
-  EXPECT_EQ(arena.bins[idx].avail_regs, BIN_MINIMUM_REGIONS - 1);
+  EXPECT_NE(reg, nullptr);
+  EXPECT_EQ(arena.bins[idx].run_list_active_cnt, 0);
+  EXPECT_EQ(arena.bins[idx].avail_regs, 0);
+  EXPECT_EQ(arena.bins[idx].run_list_inactive.ll, nullptr);
 }
@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+#include <malloc.h>
+
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Node {
+  std::string name;
+  std::vector<int> items;
+};
+
+struct alignas(64) Line {
+  char data[64];
+};
+
+TEST(NewDeleteTest, RoutedToSealloc) {
+  void *ptr = ::operator new(20);
+  // Size classes of sealloc, glibc would report 24
+  EXPECT_EQ(malloc_usable_size(ptr), 32);
+  ::operator delete(ptr, 20);
+}
+
+TEST(NewDeleteTest, ObjectsAndArrays) {
+  std::vector<std::unique_ptr<Node>> nodes;
+  for (int i = 0; i < 1000; i++) {
+    nodes.push_back(std::make_unique<Node>());
+    nodes.back()->name = std::string(i % 100, 'a');
+    nodes.back()->items.resize(i % 50, i);
+  }
+  nodes.clear();
+  for (size_t n : {1, 10, 1000, 100000}) {
+    Node *arr = new Node[n];
+    arr[n - 1].items.push_back(1);
+    delete[] arr;
+  }
+  int *nothrow = new (std::nothrow) int[100];
+  ASSERT_NE(nothrow, nullptr);
+  delete[] nothrow;
+}
+
+TEST(NewDeleteTest, Aligned) {
+  for (size_t alignment : {32, 64, 256, 4096, 65536}) {
+    for (size_t size : {1, 100, 5000, 2000000}) {
+      void *ptr = ::operator new(size, std::align_val_t(alignment));
+      EXPECT_EQ((uintptr_t)ptr % alignment, 0);
+      ::operator delete(ptr, size, std::align_val_t(alignment));
+      ptr = ::operator new[](size, std::align_val_t(alignment), std::nothrow);
+      EXPECT_EQ((uintptr_t)ptr % alignment, 0);
+      ::operator delete[](ptr, std::align_val_t(alignment));
+    }
+  }
+  auto lines = std::make_unique<Line[]>(100);
+  EXPECT_EQ((uintptr_t)lines.get() % alignof(Line), 0);
+}
+
+TEST(NewDeleteTest, SizedDeleteChecksSize) {
+  void *ptr = ::operator new(16);
+  EXPECT_DEATH({ ::operator delete(ptr, 4096); },
+               ".*Invalid call to free_sized().*");
+  ::operator delete(ptr, 16);
+}
+
+}  // namespace
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory_resource>
+#include <sealloc_pmr.hpp>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+struct alignas(64) Line {
+  char data[64];
+};
+
+TEST(PmrTest, ResourceBacksContainers) {
+  sealloc::memory_resource mr;
+  std::pmr::vector<std::pmr::string> strings(&mr);
+  for (int i = 0; i < 10000; i++)
+    strings.emplace_back(std::string(i % 100, 'a' + i % 26));
+  for (int i = 0; i < 10000; i++)
+    ASSERT_EQ(std::string_view(strings[i]),
+              std::string(i % 100, 'a' + i % 26));
+  EXPECT_EQ(strings.back().get_allocator().resource(), &mr);
+
+  std::pmr::unordered_map<int, std::pmr::string> map(&mr);
+  for (int i = 0; i < 10000; i++) map.emplace(i, std::to_string(i));
+  for (int i = 0; i < 10000; i += 2) map.erase(i);
+  for (int i = 1; i < 10000; i += 2)
+    ASSERT_EQ(std::string_view(map.at(i)), std::to_string(i));
+}
+
+TEST(PmrTest, ResourceAligned) {
+  sealloc::memory_resource mr;
+  for (size_t alignment : {1, 8, 64, 4096, 65536}) {
+    for (size_t size : {1, 100, 5000, 2000000}) {
+      void *ptr = mr.allocate(size, alignment);
+      EXPECT_EQ((uintptr_t)ptr % alignment, 0);
+      mr.deallocate(ptr, size, alignment);
+    }
+  }
+  std::pmr::vector<Line> lines(100, &mr);
+  EXPECT_EQ((uintptr_t)lines.data() % alignof(Line), 0);
+}
+
+TEST(PmrTest, ResourceEquality) {
+  sealloc::memory_resource a, b;
+  sealloc::memory_resource shared(a.arena());
+  EXPECT_TRUE(a.is_equal(a));
+  EXPECT_TRUE(a.is_equal(shared));
+  EXPECT_FALSE(a.is_equal(b));
+  EXPECT_FALSE(a.is_equal(*std::pmr::new_delete_resource()));
+}
+
+TEST(PmrTest, ResourceReleasesOnDestroy) {
+  // Nothing is deallocated, arena is unmapped as a whole
+  for (int r = 0; r < 20; r++) {
+    sealloc::memory_resource mr;
+    for (int i = 0; i < 1000; i++)
+      static_cast<void>(mr.allocate(48 + i % 1000));
+    static_cast<void>(mr.allocate(4 << 20));
+  }
+}
+
+TEST(PmrTest, SizedDeallocateChecksSize) {
+  sealloc::memory_resource mr;
+  void *ptr = mr.allocate(16);
+  EXPECT_DEATH({ mr.deallocate(ptr, 4096); },
+               ".*Invalid call to free_sized().*");
+  mr.deallocate(ptr, 16);
+}
+
+TEST(PmrTest, AllocatorBacksContainers) {
+  sealloc::allocator<int> alloc;
+  std::vector<int, sealloc::allocator<int>> vec(alloc);
+  for (int i = 0; i < 100000; i++) vec.push_back(i);
+  for (int i = 0; i < 100000; i++) ASSERT_EQ(vec[i], i);
+
+  // Node types are rebound from the same arena
+  std::map<int, int, std::less<int>,
+           sealloc::allocator<std::pair<const int, int>>>
+      map(alloc);
+  std::list<Line, sealloc::allocator<Line>> list(alloc);
+  for (int i = 0; i < 1000; i++) {
+    map[i] = i;
+    list.emplace_back();
+    ASSERT_EQ((uintptr_t)&list.back() % alignof(Line), 0);
+  }
+  EXPECT_EQ(map.get_allocator(), alloc);
+  EXPECT_EQ(list.get_allocator(), alloc);
+}
+
+TEST(PmrTest, AllocatorEquality) {
+  sealloc::allocator<int> a, b;
+  sealloc::allocator<long> rebound(a);
+  sealloc::memory_resource mr;
+  EXPECT_EQ(a, rebound);
+  EXPECT_NE(a, b);
+  EXPECT_EQ(sealloc::allocator<char>(mr).arena(), mr.arena());
+}
+
+TEST(PmrTest, AllocatorOutlivesCopies) {
+  std::vector<int, sealloc::allocator<int>> vec;
+  {
+    sealloc::allocator<int> alloc;
+    vec = std::vector<int, sealloc::allocator<int>>(1000, 7, alloc);
+  }
+  // Arena is kept alive by allocator of the vector
+  vec.resize(100000, 7);
+  EXPECT_EQ(vec[99999], 7);
+}
+
+}  // namespace
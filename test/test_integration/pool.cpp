@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+
+extern "C" {
+#include <sealloc/arena.h>
+#include <sealloc/pool.h>
+#include <sealloc/sealloc.h>
+#include <sealloc/utils.h>
+}
+
+class PoolTest : public ::testing::TestWithParam<size_t> {
+ protected:
+  arena_t arena;
+  void SetUp() override {
+    arena.is_initialized = 0;
+    arena_init(&arena);
+  }
+};
+
+TEST_P(PoolTest, ObjectsDisjointAndReleased) {
+  size_t size = GetParam();
+  constexpr size_t N = 3000;
+  pool_t *pool = sealloc_create_pool(&arena, size, 8);
+  ASSERT_NE(pool, nullptr);
+  std::vector<void *> ptrs;
+  for (size_t i = 0; i < N; i++) {
+    void *ptr = sealloc_malloc_from_pool(pool);
+    ASSERT_NE(ptr, nullptr);
+    EXPECT_TRUE(IS_ALIGNED((uintptr_t)ptr, 8));
+    std::memset(ptr, (int)i, size);
+    ptrs.push_back(ptr);
+  }
+  std::vector<void *> sorted(ptrs);
+  std::sort(sorted.begin(), sorted.end());
+  for (size_t i = 1; i < N; i++)
+    EXPECT_GE((uintptr_t)sorted[i] - (uintptr_t)sorted[i - 1], size);
+  for (size_t i = 0; i < N; i++)
+    EXPECT_EQ(((unsigned char *)ptrs[i])[size - 1], (unsigned char)i);
+  std::shuffle(ptrs.begin(), ptrs.end(), std::mt19937{3});
+  for (void *ptr : ptrs) sealloc_free_to_pool(pool, ptr);
+  EXPECT_EQ(pool->bin.run_list_inactive.ll, nullptr);
+  sealloc_destroy_pool(pool);
+}
+
+INSTANTIATE_TEST_SUITE_P(Pool, PoolTest, ::testing::Values(24, 48, 200, 3000));
+
+TEST(MallocApiTest, PoolInvalidFree) {
+  arena_t arena;
+  arena.is_initialized = 0;
+  arena_init(&arena);
+  pool_t *pool = sealloc_create_pool(&arena, 24, 8);
+  pool_t *other = sealloc_create_pool(&arena, 24, 8);
+  void *ptr = sealloc_malloc_from_pool(pool);
+  void *reg = sealloc_malloc(&arena, 24);
+  // Pool regions are known only to the pool
+  EXPECT_DEATH({ sealloc_free(&arena, ptr); }, ".*Invalid call to free().*");
+  EXPECT_DEATH({ sealloc_usable_size(&arena, ptr); },
+               ".*Invalid call to malloc_usable_size().*");
+  EXPECT_DEATH({ sealloc_free_to_pool(other, ptr); },
+               ".*Invalid call to sealloc_pool_free().*");
+  EXPECT_DEATH({ sealloc_free_to_pool(pool, reg); },
+               ".*Invalid call to sealloc_pool_free().*");
+  EXPECT_DEATH({ sealloc_free_to_pool(pool, (char *)ptr + 8); },
+               ".*Invalid call to sealloc_pool_free().*");
+  sealloc_free_to_pool(pool, ptr);
+  EXPECT_DEATH({ sealloc_free_to_pool(pool, ptr); },
+               ".*Invalid call to sealloc_pool_free().*");
+  sealloc_free(&arena, reg);
+  sealloc_destroy_pool(other);
+  sealloc_destroy_pool(pool);
+}
+
+TEST(MallocApiTest, PoolDestroyWithLiveObjects) {
+  arena_t arena;
+  arena.is_initialized = 0;
+  arena_init(&arena);
+  EXPECT_EQ(sealloc_create_pool(&arena, 0, 8), nullptr);
+  pool_t *pool = sealloc_create_pool(&arena, 48, 16);
+  for (int i = 0; i < 1000; i++) ASSERT_NE(sealloc_malloc_from_pool(pool), nullptr);
+  sealloc_destroy_pool(pool);
+  // Memory of the pool is returned to chunks
+  pool = sealloc_create_pool(&arena, 48, 16);
+  for (int i = 0; i < 1000; i++) ASSERT_NE(sealloc_malloc_from_pool(pool), nullptr);
+  sealloc_destroy_pool(pool);
+}
@@ -0,0 +1,234 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <sealloc/arena.h>
+#include <sealloc/ctl.h>
+#include <sealloc/prof.h>
+#include <sealloc/run.h>
+#include <sealloc/sealloc.h>
+#include <sealloc/size_class.h>
+#include <sealloc/utils.h>
+}
+
+class ProfTest : public ::testing::Test {
+ protected:
+  arena_t arena;
+  void SetUp() override {
+    arena.is_initialized = 0;
+    arena_init(&arena);
+  }
+  void TearDown() override { arena_destroy(&arena); }
+
+  void set_interval(unsigned interval) {
+    ASSERT_EQ(ctl_by_name(&arena, "arena.0.conf.prof_interval", nullptr,
+                          nullptr, &interval, sizeof(interval)),
+              0);
+  }
+  size_t nsamples() {
+    size_t val = 0, len = sizeof(val);
+    EXPECT_EQ(
+        ctl_by_name(&arena, "arena.0.prof.nsamples", &val, &len, nullptr, 0),
+        0);
+    return val;
+  }
+};
+
+static std::string read_file(const char *path) {
+  std::string out;
+  char buf[256];
+  size_t len;
+  FILE *fp = fopen(path, "r");
+  if (fp == nullptr) return out;
+  while ((len = fread(buf, 1, sizeof(buf), fp)) > 0) out.append(buf, len);
+  fclose(fp);
+  return out;
+}
+
+TEST_F(ProfTest, DisabledByDefault) {
+  std::vector<void *> ptrs;
+  EXPECT_EQ(arena.conf.prof_interval, PROF_DEFAULT_INTERVAL);
+  for (int i = 0; i < 1000; i++) ptrs.push_back(sealloc_malloc(&arena, 1024));
+  ptrs.push_back(sealloc_malloc(&arena, LARGE_SIZE_MAX_REGION + 1));
+  EXPECT_EQ(nsamples(), 0);
+  EXPECT_EQ(arena.prof.nsamples, 0);
+  for (void *ptr : ptrs) sealloc_free(&arena, ptr);
+}
+
+TEST_F(ProfTest, SamplingRate) {
+  const size_t size = 64, n = 20000;
+  std::vector<void *> ptrs;
+  set_interval(4096);
+  for (size_t i = 0; i < n; i++) ptrs.push_back(sealloc_malloc(&arena, size));
+  // Expected n * size / interval = 312 samples
+  EXPECT_GT(arena.prof.nsamples, 200);
+  EXPECT_LT(arena.prof.nsamples, 450);
+  EXPECT_EQ(nsamples(), arena.prof.nsamples);
+  EXPECT_EQ(arena.prof.sampled_bytes, arena.prof.nsamples * size);
+  for (void *ptr : ptrs) sealloc_free(&arena, ptr);
+  EXPECT_EQ(nsamples(), 0);
+}
+
+TEST_F(ProfTest, BigAllocationsAlwaysSampled) {
+  std::vector<void *> ptrs;
+  set_interval(4096);
+  for (int i = 0; i < 8; i++)
+    ptrs.push_back(sealloc_malloc(&arena, LARGE_SIZE_MAX_REGION + 1));
+  EXPECT_EQ(nsamples(), 8);
+  for (void *ptr : ptrs) sealloc_free(&arena, ptr);
+  EXPECT_EQ(nsamples(), 0);
+}
+
+// Interval of 1 samples every allocation of at least 64 bytes
+TEST_F(ProfTest, ForgetOnEveryFreePath) {
+  void *batch[16];
+  set_interval(1);
+  void *small = sealloc_malloc(&arena, 64);
+  void *sized = sealloc_malloc(&arena, 128);
+  void *large = sealloc_malloc(&arena, LARGE_SIZE_MIN_REGION);
+  void *huge = sealloc_malloc(&arena, LARGE_SIZE_MAX_REGION + 1);
+  void *aligned = sealloc_aligned_alloc(&arena, 4 * PAGE_SIZE, 64);
+  ASSERT_EQ(sealloc_batch_malloc(&arena, 64, 16, batch), 16);
+  EXPECT_EQ(nsamples(), 21);
+
+  sealloc_free(&arena, small);
+  EXPECT_EQ(nsamples(), 20);
+  sealloc_free_sized(&arena, sized, 128);
+  EXPECT_EQ(nsamples(), 19);
+  sealloc_free_sized(&arena, large, LARGE_SIZE_MIN_REGION);
+  EXPECT_EQ(nsamples(), 18);
+  sealloc_free(&arena, huge);
+  EXPECT_EQ(nsamples(), 17);
+  sealloc_free_aligned_sized(&arena, aligned, 4 * PAGE_SIZE, 64);
+  EXPECT_EQ(nsamples(), 16);
+  sealloc_batch_free(&arena, batch, 16);
+  EXPECT_EQ(nsamples(), 0);
+  EXPECT_EQ(arena.prof.nsamples, 21);
+}
+
+// Sized free searches sample table only for runs holding samples
+TEST_F(ProfTest, RunsMarkedBySampling) {
+  chunk_t *chunk;
+  run_t *plain_run, *sampled_run;
+  bin_t *bin;
+  huge_chunk_t *huge;
+  void *plain = sealloc_malloc(&arena, 64);
+  set_interval(1);
+  void *sampled = sealloc_malloc(&arena, 256);
+  ASSERT_EQ(locate_metadata_for_ptr(&arena, plain, &chunk, &plain_run, &bin,
+                                    &huge),
+            METADATA_REGULAR);
+  ASSERT_EQ(locate_metadata_for_ptr(&arena, sampled, &chunk, &sampled_run,
+                                    &bin, &huge),
+            METADATA_REGULAR);
+  EXPECT_EQ(plain_run->sampled, 0);
+  EXPECT_EQ(sampled_run->sampled, 1);
+  sealloc_free_sized(&arena, sampled, 256);
+  EXPECT_EQ(nsamples(), 0);
+  sealloc_free_sized(&arena, plain, 64);
+}
+
+// Allocates sampled region, ret is where the caller continues
+__attribute__((noinline)) static void *malloc_sampled(arena_t *arena,
+                                                      void **ret) {
+  *ret = __builtin_return_address(0);
+  return sealloc_malloc(arena, LARGE_SIZE_MAX_REGION + 1);
+}
+
+TEST_F(ProfTest, BacktraceReachesCaller) {
+  void *ret;
+  const prof_sample_t *sample = nullptr;
+  set_interval(4096);
+  void *ptr = malloc_sampled(&arena, &ret);
+  for (unsigned i = 0; i < PROF_TABLE_SIZE && sample == nullptr; i++) {
+    for (ll_entry_t *entry = arena.prof.table[i].ll; entry != nullptr;
+         entry = entry->link.fd) {
+      if (entry->key == ptr) sample = CONTAINER_OF(entry, prof_sample_t, entry);
+    }
+  }
+  ASSERT_NE(sample, nullptr);
+  std::vector<void *> frames(sample->frames, sample->frames + sample->nframes);
+  // Frames of the allocator and of malloc_sampled() come first
+  EXPECT_NE(std::find(frames.begin(), frames.end(), ret), frames.end());
+  sealloc_free(&arena, ptr);
+}
+
+TEST_F(ProfTest, ReallocMovesSample) {
+  set_interval(1);
+  void *ptr = sealloc_malloc(&arena, 64);
+  ptr = sealloc_realloc(&arena, ptr, 256);
+  EXPECT_EQ(nsamples(), 1);
+  ptr = sealloc_realloc(&arena, ptr, LARGE_SIZE_MAX_REGION + 1);
+  EXPECT_EQ(nsamples(), 1);
+  ptr = sealloc_realloc(&arena, ptr, 2 * LARGE_SIZE_MAX_REGION);
+  EXPECT_EQ(nsamples(), 1);
+  ptr = sealloc_realloc(&arena, ptr, 64);
+  EXPECT_EQ(nsamples(), 1);
+  EXPECT_EQ(arena.prof.nsamples, 5);
+  sealloc_free(&arena, ptr);
+  EXPECT_EQ(nsamples(), 0);
+}
+
+TEST_F(ProfTest, DisableKeepsLiveSamples) {
+  set_interval(1);
+  void *ptr = sealloc_malloc(&arena, 64);
+  set_interval(0);
+  void *other = sealloc_malloc(&arena, LARGE_SIZE_MAX_REGION + 1);
+  EXPECT_EQ(nsamples(), 1);
+  sealloc_free(&arena, other);
+  sealloc_free(&arena, ptr);
+  EXPECT_EQ(nsamples(), 0);
+}
+
+TEST_F(ProfTest, DumpFormat) {
+  char path[] = "/tmp/sealloc_prof_XXXXXX";
+  const char *path_ptr = path;
+  int fd = mkstemp(path);
+  ASSERT_GE(fd, 0);
+  close(fd);
+  set_interval(1);
+  void *live = sealloc_malloc(&arena, 64);
+  void *freed = sealloc_malloc(&arena, 128);
+  sealloc_free(&arena, freed);
+  ASSERT_EQ(ctl_by_name(&arena, "arena.0.prof.dump", nullptr, nullptr,
+                        &path_ptr, sizeof(path_ptr)),
+            0);
+  std::string out = read_file(path);
+  unlink(path);
+
+  EXPECT_EQ(out.rfind("heap profile: 1: 64 [2: 192] @ heap_v2/1\n", 0), 0);
+  size_t line = out.find('\n') + 1;
+  EXPECT_EQ(out.compare(line, 15, "1: 64 [1: 64] @"), 0);
+  // Backtrace has at least the caller of sealloc_malloc()
+  EXPECT_EQ(out.compare(line + 15, 3, " 0x"), 0);
+  EXPECT_NE(out.find("\nMAPPED_LIBRARIES:\n"), std::string::npos);
+  sealloc_free(&arena, live);
+}
+
+TEST_F(ProfTest, DumpErrors) {
+  const char *bad = "/nonexistent/dir/prof";
+  const char *null_path = nullptr;
+  size_t len = sizeof(size_t);
+  size_t val;
+  EXPECT_EQ(ctl_by_name(&arena, "arena.0.prof.dump", nullptr, nullptr, &bad,
+                        sizeof(bad)),
+            EIO);
+  EXPECT_EQ(ctl_by_name(&arena, "arena.0.prof.dump", nullptr, nullptr,
+                        &null_path, sizeof(null_path)),
+            EINVAL);
+  EXPECT_EQ(ctl_by_name(&arena, "arena.0.prof.dump", &val, &len, nullptr, 0),
+            EPERM);
+  EXPECT_EQ(ctl_by_name(&arena, "arena.0.prof.nsamples", nullptr, nullptr,
+                        &val, sizeof(val)),
+            EPERM);
+  unsigned interval = PROF_MAX_INTERVAL + 1U;
+  EXPECT_EQ(ctl_by_name(&arena, "arena.0.conf.prof_interval", nullptr,
+                        nullptr, &interval, sizeof(interval)),
+            EINVAL);
+}
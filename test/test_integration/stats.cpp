@@ -0,0 +1,214 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+extern "C" {
+#include <sealloc/arena.h>
+#include <sealloc/platform_api.h>
+#include <sealloc/run.h>
+#include <sealloc/sealloc.h>
+#include <sealloc/size_class.h>
+#include <sealloc/stats.h>
+#include <sealloc/utils.h>
+}
+
+class StatsTest : public ::testing::Test {
+ protected:
+  arena_t arena;
+  arena_stats_t stats;
+  void SetUp() override {
+    arena.is_initialized = 0;
+    arena_init(&arena);
+  }
+  void TearDown() override { arena_destroy(&arena); }
+};
+
+TEST_F(StatsTest, LiveBytesPerClass) {
+  std::vector<void *> ptrs;
+  for (int i = 0; i < 100; i++) ptrs.push_back(sealloc_malloc(&arena, 32));
+  for (int i = 0; i < 10; i++) ptrs.push_back(sealloc_malloc(&arena, 2048));
+  for (int i = 0; i < 3; i++)
+    ptrs.push_back(sealloc_malloc(&arena, LARGE_SIZE_MIN_REGION));
+  ptrs.push_back(sealloc_malloc(&arena, 2 * LARGE_SIZE_MAX_REGION));
+  for (void *ptr : ptrs) ASSERT_NE(ptr, nullptr);
+
+  stats_collect(&arena, &stats);
+  EXPECT_EQ(stats.small_bytes, 100 * 32);
+  EXPECT_EQ(stats.medium_bytes, 10 * 2048);
+  EXPECT_EQ(stats.large_bytes, 3 * LARGE_SIZE_MIN_REGION);
+  EXPECT_EQ(stats.nhuge, 1);
+  EXPECT_EQ(stats.huge_bytes, 2 * LARGE_SIZE_MAX_REGION);
+  bin_stats_t *bin = &stats.bins[SIZE_TO_IDX_SMALL(32)];
+  EXPECT_EQ(bin->reg_size, 32);
+  EXPECT_EQ(bin->nregs_live, 100);
+  EXPECT_EQ(bin->nregs_freed, 0);
+  EXPECT_GE(bin->nruns, 1);
+  EXPECT_EQ(bin->nruns * (bin->run_size / 32),
+            bin->nregs_live + bin->nregs_avail);
+  EXPECT_EQ(stats.nchunks, 1);
+  EXPECT_EQ(stats.chunk_mapped_bytes, CHUNK_SIZE_BYTES);
+  EXPECT_GE(stats.nunits, 1);
+  EXPECT_GT(stats.internal_used_bytes, 0);
+
+  sealloc_free(&arena, ptrs[0]);
+  sealloc_free(&arena, ptrs.back());
+  ptrs.pop_back();
+  stats_collect(&arena, &stats);
+  EXPECT_EQ(stats.small_bytes, 99 * 32);
+  EXPECT_EQ(stats.bins[SIZE_TO_IDX_SMALL(32)].nregs_freed, 1);
+  EXPECT_EQ(stats.nhuge, 0);
+  for (size_t i = 1; i < ptrs.size(); i++) sealloc_free(&arena, ptrs[i]);
+}
+
+TEST_F(StatsTest, TrimReleasesMemory) {
+  char conf[] = "chunk_unmap_threshold:11";
+  conf_parse(&arena.conf, conf);
+  std::vector<void *> ptrs;
+  for (int i = 0; i < 8; i++) {
+    void *ptr = sealloc_malloc(&arena, LARGE_SIZE_MIN_REGION);
+    ASSERT_NE(ptr, nullptr);
+    ptrs.push_back(ptr);
+  }
+  for (void *ptr : ptrs) sealloc_free(&arena, ptr);
+  stats_collect(&arena, &stats);
+  EXPECT_EQ(stats.chunk_depleted_bytes, 8 * LARGE_SIZE_MIN_REGION);
+  EXPECT_GT(stats.chunk_cached_bytes, 0);
+
+  size_t expected = stats.chunk_depleted_bytes + stats.chunk_cached_bytes;
+  EXPECT_GE(arena_trim(&arena), expected);
+  stats_collect(&arena, &stats);
+  EXPECT_EQ(stats.chunk_depleted_bytes, 0);
+  EXPECT_EQ(stats.chunk_cached_bytes, 0);
+  EXPECT_EQ(arena_trim(&arena), 0);
+
+  // Arena still works after trimming
+  void *ptr = sealloc_malloc(&arena, 64);
+  ASSERT_NE(ptr, nullptr);
+  sealloc_free(&arena, ptr);
+}
+
+TEST_F(StatsTest, TrimReleasesUnusedChunk) {
+  chunk_t *chunk = arena_allocate_chunk(&arena);
+  ASSERT_NE(chunk, nullptr);
+  stats_collect(&arena, &stats);
+  EXPECT_EQ(stats.nchunks, 1);
+  EXPECT_GE(arena_trim(&arena), CHUNK_SIZE_BYTES);
+  stats_collect(&arena, &stats);
+  EXPECT_EQ(stats.nchunks, 0);
+  // Metadata of released chunk went with its unit
+  EXPECT_EQ(stats.nunits, 0);
+}
+
+TEST_F(StatsTest, BinCounters) {
+  const unsigned idx = SIZE_TO_IDX_SMALL(64);
+  std::vector<void *> ptrs;
+  for (int i = 0; i < 300; i++) {
+    void *ptr = sealloc_malloc(&arena, 64);
+    ASSERT_NE(ptr, nullptr);
+    ptrs.push_back(ptr);
+  }
+  stats_collect(&arena, &stats);
+  bin_stats_t *bin = &stats.bins[idx];
+  EXPECT_EQ(bin->nallocs, 300);
+  EXPECT_EQ(bin->nfrees, 0);
+  EXPECT_EQ(bin->nruns, bin->nruns_active + bin->nruns_inactive);
+  EXPECT_EQ(bin->nruns_released, 0);
+
+  // Freeing every region of a run gives it back to its chunk
+  for (void *ptr : ptrs) sealloc_free(&arena, ptr);
+  stats_collect(&arena, &stats);
+  EXPECT_EQ(bin->nfrees, 300);
+  EXPECT_EQ(bin->nregs_live, 0);
+  EXPECT_EQ(bin->nregs_freed + bin->nregs_avail,
+            bin->nruns * (bin->run_size / 64));
+
+  const unsigned per_run = RUN_SIZE_SMALL_BYTES / 64;
+  for (unsigned i = 0; i < 2 * per_run; i++) {
+    void *ptr = sealloc_malloc(&arena, 64);
+    ASSERT_NE(ptr, nullptr);
+    sealloc_free(&arena, ptr);
+  }
+  stats_collect(&arena, &stats);
+  EXPECT_GE(bin->nruns_released, 1);
+  EXPECT_EQ(bin->nallocs, 300 + 2 * per_run);
+  EXPECT_EQ(bin->nfrees, bin->nallocs);
+}
+
+TEST_F(StatsTest, LargeCountersAndChunkOrders) {
+  const unsigned idx = NO_SMALL_SIZE_CLASSES + NO_MEDIUM_SIZE_CLASSES;
+  void *ptr = sealloc_malloc(&arena, LARGE_SIZE_MIN_REGION);
+  ASSERT_NE(ptr, nullptr);
+  stats_collect(&arena, &stats);
+  EXPECT_EQ(stats.bins[idx].nallocs, 1);
+  EXPECT_EQ(stats.bins[idx].nruns_active, 1);
+  // Large region of 16K is a single leaf
+  EXPECT_EQ(stats.chunk_nruns[0], 1);
+
+  chunk_usage_t usage;
+  ASSERT_TRUE(stats_collect_chunk(&arena, 0, &usage));
+  EXPECT_EQ(usage.nruns[0], 1);
+  EXPECT_EQ(usage.run_bytes, LARGE_SIZE_MIN_REGION);
+  EXPECT_FALSE(stats_collect_chunk(&arena, 1, &usage));
+
+  sealloc_free(&arena, ptr);
+  stats_collect(&arena, &stats);
+  EXPECT_EQ(stats.bins[idx].nfrees, 1);
+  EXPECT_EQ(stats.bins[idx].nruns_released, 1);
+  EXPECT_EQ(stats.chunk_nruns[0], 0);
+  EXPECT_EQ(stats.chunk_depleted_bytes + stats.chunk_unmapped_bytes,
+            LARGE_SIZE_MIN_REGION);
+}
+
+TEST_F(StatsTest, WriteJson) {
+  void *ptr = sealloc_malloc(&arena, 100);
+  ASSERT_NE(ptr, nullptr);
+  char *buf = nullptr;
+  size_t len = 0;
+  FILE *fp = open_memstream(&buf, &len);
+  ASSERT_NE(fp, nullptr);
+  stats_collect(&arena, &stats);
+  stats_write_json(&arena, &stats, fp);
+  fclose(fp);
+  std::string out(buf, len);
+  free(buf);
+
+  EXPECT_EQ(out.rfind("{\"bins\":[{\"class\":\"small\",\"reg_size\":112,", 0),
+            0);
+  EXPECT_NE(out.find("\"nallocs\":1,"), std::string::npos);
+  EXPECT_NE(out.find("\"chunks\":[{\"run_bytes\":"), std::string::npos);
+  EXPECT_NE(out.find("\"chunk_nruns\":["), std::string::npos);
+  EXPECT_EQ(out.substr(out.size() - 3), "}}\n");
+  sealloc_free(&arena, ptr);
+}
+
+TEST_F(StatsTest, MappingAccounting) {
+  platform_counters_t before;
+  platform_get_counters(&before);
+  void *ptr = sealloc_malloc(&arena, LARGE_SIZE_MIN_REGION);
+  void *keep = sealloc_malloc(&arena, LARGE_SIZE_MIN_REGION);
+  ASSERT_NE(ptr, nullptr);
+  ASSERT_NE(keep, nullptr);
+  stats_collect(&arena, &stats);
+  EXPECT_EQ(stats.nchunks, 1);
+  EXPECT_EQ(stats.guard_bytes, PAGE_SIZE);
+  EXPECT_EQ(stats.mapped_bytes,
+            stats.chunk_mapped_bytes + stats.guard_bytes +
+                arena.chunks_left * (CHUNK_SIZE_BYTES + PAGE_SIZE) +
+                stats.internal_mapped_bytes);
+  // Whole chunk, its guard, rest of chunk mapping and metadata units
+  EXPECT_EQ(stats.nvmas, 3 + stats.nunits);
+  EXPECT_GE(stats.platform.nprobe - before.nprobe, 1);
+  EXPECT_EQ(stats.platform.nguard - before.nguard, 1);
+  EXPECT_GE(stats.platform.nprobe, stats.platform.nprobe_retry);
+
+  // Freed large run is unmapped at once, leaving a hole in the chunk
+  size_t nvmas = stats.nvmas;
+  sealloc_free(&arena, ptr);
+  stats_collect(&arena, &stats);
+  EXPECT_EQ(stats.platform.nunmap - before.nunmap, 1);
+  EXPECT_EQ(stats.chunk_unmapped_bytes, LARGE_SIZE_MIN_REGION);
+  EXPECT_GE(stats.nvmas, nvmas);
+  EXPECT_LE(stats.nvmas, nvmas + 1);
+  sealloc_free(&arena, keep);
+}
@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+extern "C" {
+#include <sealloc/arena.h>
+#include <sealloc/sealloc.h>
+#include <sealloc/size_class.h>
+#include <sealloc/utils.h>
+}
+
+class TryExpandTest : public ::testing::Test {
+ protected:
+  arena_t arena;
+  void SetUp() override {
+    arena.is_initialized = 0;
+    arena_init(&arena);
+  }
+};
+
+TEST_F(TryExpandTest, SameClass) {
+  void *ptr = sealloc_malloc(&arena, 20);
+  ASSERT_NE(ptr, nullptr);
+  EXPECT_EQ(sealloc_expand_in_place(&arena, ptr, 30, 100), 32);
+  // Region cannot leave its class
+  EXPECT_EQ(sealloc_expand_in_place(&arena, ptr, 40, 100), 32);
+  EXPECT_EQ(sealloc_expand_in_place(&arena, nullptr, 40, 100), 0);
+  sealloc_free(&arena, ptr);
+}
+
+TEST_F(TryExpandTest, LargeGrowsIntoBuddies) {
+  std::vector<char *> ptrs;
+  char *grown = nullptr;
+  size_t usable = LARGE_SIZE_MIN_REGION;
+  // Some region is a left child with a free buddy
+  for (int i = 0; i < 64 && grown == nullptr; i++) {
+    char *ptr = (char *)sealloc_malloc(&arena, LARGE_SIZE_MIN_REGION);
+    ASSERT_NE(ptr, nullptr);
+    std::memset(ptr, 0x41, LARGE_SIZE_MIN_REGION);
+    usable = sealloc_expand_in_place(&arena, ptr, 2 * LARGE_SIZE_MIN_REGION,
+                                     LARGE_SIZE_MAX_REGION);
+    if (usable > LARGE_SIZE_MIN_REGION)
+      grown = ptr;
+    else
+      ptrs.push_back(ptr);
+  }
+  ASSERT_NE(grown, nullptr);
+  EXPECT_GE(usable, 2 * LARGE_SIZE_MIN_REGION);
+  EXPECT_LE(usable, LARGE_SIZE_MAX_REGION);
+  EXPECT_EQ(sealloc_usable_size(&arena, grown), usable);
+  for (size_t i = 0; i < LARGE_SIZE_MIN_REGION; i++) ASSERT_EQ(grown[i], 0x41);
+  std::memset(grown, 0x42, usable);
+
+  // Grown region does not overlap with regions allocated later
+  for (int i = 0; i < 64; i++) {
+    char *ptr = (char *)sealloc_malloc(&arena, LARGE_SIZE_MIN_REGION);
+    ASSERT_NE(ptr, nullptr);
+    EXPECT_TRUE(ptr + LARGE_SIZE_MIN_REGION <= grown || ptr >= grown + usable);
+    ptrs.push_back(ptr);
+  }
+  for (size_t i = 0; i < usable; i++) ASSERT_EQ(grown[i], 0x42);
+
+  // Region belongs to its new class
+  sealloc_free_sized(&arena, grown, usable);
+  for (char *ptr : ptrs) sealloc_free(&arena, ptr);
+}
+
+TEST_F(TryExpandTest, LargeStaysLarge) {
+  void *ptr = sealloc_malloc(&arena, LARGE_SIZE_MAX_REGION);
+  ASSERT_NE(ptr, nullptr);
+  EXPECT_EQ(sealloc_expand_in_place(&arena, ptr, LARGE_SIZE_MAX_REGION + 1,
+                                    2 * LARGE_SIZE_MAX_REGION),
+            LARGE_SIZE_MAX_REGION);
+  sealloc_free(&arena, ptr);
+}
+
+TEST_F(TryExpandTest, HugeGrowsInPlace) {
+  size_t size = 2 * LARGE_SIZE_MAX_REGION;
+  char *ptr = (char *)sealloc_malloc(&arena, size);
+  ASSERT_NE(ptr, nullptr);
+  std::memset(ptr, 0x41, size);
+  size_t usable = sealloc_expand_in_place(&arena, ptr, 2 * size, 4 * size);
+  // Nothing is placed after the newest mapping
+  EXPECT_EQ(usable, 4 * size);
+  EXPECT_EQ(sealloc_usable_size(&arena, ptr), usable);
+  for (size_t i = 0; i < size; i++) ASSERT_EQ(ptr[i], 0x41);
+  std::memset(ptr, 0x42, usable);
+
+  char *next = (char *)sealloc_malloc(&arena, size);
+  ASSERT_NE(next, nullptr);
+  EXPECT_TRUE(next + size <= ptr || next >= ptr + usable + PAGE_SIZE);
+  // Grown mapping keeps one page gap to its neighbour
+  size_t usable_next = sealloc_expand_in_place(&arena, ptr, usable + 1,
+                                               usable + 8 * size);
+  EXPECT_TRUE(usable_next == usable || next >= ptr + usable_next + PAGE_SIZE);
+  sealloc_free(&arena, next);
+  sealloc_free(&arena, ptr);
+}
+
+TEST_F(TryExpandTest, Invalid) {
+  char *ptr = (char *)sealloc_malloc(&arena, 64);
+  ASSERT_NE(ptr, nullptr);
+  EXPECT_DEATH({ sealloc_expand_in_place(&arena, ptr + 16, 64, 64); },
+               ".*Invalid call to sealloc_try_expand().*");
+  sealloc_free(&arena, ptr);
+  EXPECT_DEATH({ sealloc_expand_in_place(&arena, ptr, 64, 64); },
+               ".*Invalid call to sealloc_try_expand().*");
+}
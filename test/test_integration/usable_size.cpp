@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+extern "C" {
+#include <sealloc/arena.h>
+#include <sealloc/sealloc.h>
+#include <sealloc/size_class.h>
+#include <sealloc/utils.h>
+}
+
+class UsableSizeTest : public ::testing::TestWithParam<size_t> {
+ protected:
+  arena_t arena;
+  void SetUp() override {
+    arena.is_initialized = 0;
+    arena_init(&arena);
+  }
+};
+
+TEST_P(UsableSizeTest, MatchesRoundedSize) {
+  size_t size = GetParam();
+  void *ptr = sealloc_malloc(&arena, size);
+  ASSERT_NE(ptr, nullptr);
+  size_t usable = sealloc_usable_size(&arena, ptr);
+  EXPECT_EQ(usable, sealloc_round_size(size));
+  EXPECT_GE(usable, size);
+  // Whole usable size can be written to
+  std::memset(ptr, 0x41, usable);
+  sealloc_free(&arena, ptr);
+}
+
+INSTANTIATE_TEST_SUITE_P(UsableSize, UsableSizeTest,
+                         ::testing::Values(0, 1, 16, 497, 513, 3000,
+                                           LARGE_SIZE_MIN_REGION + 1,
+                                           LARGE_SIZE_MAX_REGION,
+                                           LARGE_SIZE_MAX_REGION + 1));
+
+TEST(MallocApiTest, RoundSize) {
+  EXPECT_EQ(sealloc_round_size(0), 16);
+  EXPECT_EQ(sealloc_round_size(497), 512);
+  EXPECT_EQ(sealloc_round_size(513), 1024);
+  EXPECT_EQ(sealloc_round_size(LARGE_SIZE_MAX_REGION + 1),
+            LARGE_SIZE_MAX_REGION + PAGE_SIZE);
+  EXPECT_EQ(sealloc_round_size(SIZE_MAX), 0);
+}
+
+TEST(MallocApiTest, UsableSizeInvalid) {
+  arena_t arena;
+  arena.is_initialized = 0;
+  arena_init(&arena);
+  EXPECT_EQ(sealloc_usable_size(&arena, nullptr), 0);
+  char *ptr = (char *)sealloc_malloc(&arena, 64);
+  ASSERT_NE(ptr, nullptr);
+  EXPECT_DEATH({ sealloc_usable_size(&arena, ptr + 16); },
+               ".*Invalid call to malloc_usable_size().*");
+  char *large = (char *)sealloc_malloc(&arena, LARGE_SIZE_MIN_REGION);
+  ASSERT_NE(large, nullptr);
+  EXPECT_DEATH({ sealloc_usable_size(&arena, large + PAGE_SIZE); },
+               ".*Invalid call to malloc_usable_size().*");
+  int stack_var;
+  EXPECT_DEATH({ sealloc_usable_size(&arena, &stack_var); },
+               ".*Invalid call to malloc_usable_size().*");
+}
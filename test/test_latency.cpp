@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <string>
+
+extern "C" {
+#include <sealloc/latency.h>
+}
+
+static std::string read_fd(int fd) {
+  std::string out;
+  char buf[256];
+  ssize_t len;
+  lseek(fd, 0, SEEK_SET);
+  while ((len = read(fd, buf, sizeof(buf))) > 0) out.append(buf, len);
+  return out;
+}
+
+TEST(Latency, BucketLinearBelowSubBuckets) {
+  for (unsigned i = 0; i < LAT_SUB_BUCKETS; i++) {
+    EXPECT_EQ(lat_bucket(i), i);
+    EXPECT_EQ(lat_bucket_lower(i), i);
+  }
+}
+
+TEST(Latency, BucketLogLinear) {
+  EXPECT_EQ(lat_bucket(LAT_SUB_BUCKETS), LAT_SUB_BUCKETS);
+  EXPECT_EQ(lat_bucket(2 * LAT_SUB_BUCKETS - 1), 2 * LAT_SUB_BUCKETS - 1);
+  // From the next power of two on, each bucket spans more than one value
+  EXPECT_EQ(lat_bucket(2 * LAT_SUB_BUCKETS), 2 * LAT_SUB_BUCKETS);
+  EXPECT_EQ(lat_bucket(2 * LAT_SUB_BUCKETS + 1), 2 * LAT_SUB_BUCKETS);
+  EXPECT_EQ(lat_bucket(2 * LAT_SUB_BUCKETS + 2), 2 * LAT_SUB_BUCKETS + 1);
+  EXPECT_EQ(lat_bucket(UINT64_MAX), LAT_NO_BUCKETS - 1);
+}
+
+TEST(Latency, BucketBoundsContainValues) {
+  const uint64_t values[] = {9, 100, 1000, 4095, 4096, 123456789,
+                             UINT64_C(1) << 40, UINT64_MAX / 3};
+  for (uint64_t val : values) {
+    unsigned bucket = lat_bucket(val);
+    EXPECT_LE(lat_bucket_lower(bucket), val);
+    // Bounds of consecutive buckets meet
+    EXPECT_GT(lat_bucket_lower(bucket + 1), val);
+    EXPECT_EQ(lat_bucket(lat_bucket_lower(bucket)), bucket);
+    // Relative error is bounded by width of sub bucket
+    EXPECT_LE(val - lat_bucket_lower(bucket), val / LAT_SUB_BUCKETS);
+  }
+}
+
+TEST(Latency, Record) {
+  static lat_hist_t hist;
+  lat_init(&hist);
+  lat_record(&hist, LAT_MORECORE, 1000);
+  lat_record(&hist, LAT_MORECORE, 1001);
+  lat_record(&hist, LAT_FREE_LOCATE, 5);
+  EXPECT_EQ(hist.count[LAT_MORECORE][lat_bucket(1000)], 2);
+  EXPECT_EQ(hist.count[LAT_FREE_LOCATE][5], 1);
+  EXPECT_EQ(hist.count[LAT_MALLOC_SIZE_CLASS][5], 0);
+}
+
+TEST(Latency, WriteJson) {
+  static lat_hist_t hist;
+  FILE *fp = tmpfile();
+  ASSERT_NE(fp, nullptr);
+  lat_init(&hist);
+  lat_record(&hist, LAT_MALLOC_SIZE_CLASS, 3);
+  lat_record(&hist, LAT_MALLOC_SIZE_CLASS, 3);
+  lat_record(&hist, LAT_MALLOC_SIZE_CLASS, 100);
+  lat_write_json(&hist, fileno(fp));
+  std::string out = read_fd(fileno(fp));
+  fclose(fp);
+
+  EXPECT_EQ(out.rfind("{\"version\":1,\"pid\":", 0), 0);
+  EXPECT_NE(out.find("\"ticks_per_sec\":"), std::string::npos);
+  std::string lower = std::to_string(lat_bucket_lower(lat_bucket(100)));
+  EXPECT_NE(out.find("\"malloc_size_class\":{\"buckets\":[[3,2],[" + lower +
+                     ",1]],\"count\":3}"),
+            std::string::npos);
+  EXPECT_NE(out.find("\"chunk_init\":{\"buckets\":[],\"count\":0}"),
+            std::string::npos);
+  EXPECT_EQ(out.find('\n'), out.size() - 1);
+}
+
+TEST(Latency, DumpAppends) {
+  static lat_hist_t hist;
+  char path[] = "/tmp/sealloc_latency_XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_GE(fd, 0);
+  lat_init(&hist);
+  ASSERT_TRUE(lat_dump(&hist, path));
+  ASSERT_TRUE(lat_dump(&hist, path));
+  std::string out = read_fd(fd);
+  close(fd);
+  unlink(path);
+
+  size_t first = out.find('\n');
+  ASSERT_NE(first, std::string::npos);
+  EXPECT_EQ(out.find('\n', first + 1), out.size() - 1);
+  EXPECT_FALSE(lat_dump(&hist, "/nonexistent/dir/latency"));
+}
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+
+extern "C" {
+#include <sealloc/bin.h>
+#include <sealloc/pool.h>
+#include <sealloc/random.h>
+#include <sealloc/run.h>
+#include <sealloc/utils.h>
+}
+
+TEST(PoolUtils, RegSize) {
+  EXPECT_EQ(pool_reg_size(24, 8), 24);
+  EXPECT_EQ(pool_reg_size(24, 0), 24);
+  EXPECT_EQ(pool_reg_size(24, 16), 32);
+  EXPECT_EQ(pool_reg_size(200, 8), 200);
+  EXPECT_EQ(pool_reg_size(1, 1), POOL_MIN_OBJ_SIZE);
+  EXPECT_EQ(pool_reg_size(0, 8), 0);
+  EXPECT_EQ(pool_reg_size(24, 12), 0);
+  EXPECT_EQ(pool_reg_size(24, 2 * PAGE_SIZE), 0);
+  EXPECT_EQ(pool_reg_size(POOL_MAX_OBJ_SIZE, 8), POOL_MAX_OBJ_SIZE);
+  EXPECT_EQ(pool_reg_size(POOL_MAX_OBJ_SIZE + 1, 8), 0);
+}
+
+TEST(PoolUtils, RunSizeTuned) {
+  for (unsigned reg_size = POOL_MIN_OBJ_SIZE; reg_size <= POOL_MAX_OBJ_SIZE;
+       reg_size += 8) {
+    unsigned run_size = pool_run_size_pages(reg_size) * PAGE_SIZE;
+    EXPECT_GE(run_size, CHUNK_LEAST_REGION_SIZE_BYTES);
+    EXPECT_LE(run_size, POOL_RUN_SIZE_MAX_BYTES);
+    // Chunk allocates only power of 2 runs
+    EXPECT_EQ(run_size & (run_size - 1), 0);
+    if (run_size < POOL_RUN_SIZE_MAX_BYTES) {
+      EXPECT_GE(run_size / reg_size, POOL_MIN_REGIONS_PER_RUN);
+      EXPECT_LE(run_size % reg_size, run_size >> POOL_MAX_WASTE_SHIFT);
+    }
+  }
+  // 3000 bytes waste too much in smaller runs
+  EXPECT_EQ(pool_run_size_pages(3000) * PAGE_SIZE, POOL_RUN_SIZE_MAX_BYTES);
+}
+
+TEST(PoolUtils, RunVisitsEveryRegion) {
+  init_splitmix32(42);
+  for (unsigned reg_size : {24, 40, 200, 3000}) {
+    bin_t bin;
+    bin_init_pool(&bin, reg_size, pool_run_size_pages(reg_size));
+    unsigned nregs = bin.reg_mask_size_bits / 2;
+    uintptr_t heap = 0x1000000;
+    for (int r = 0; r < 10; r++) {
+      run_t *run = (run_t *)malloc(run_metadata_size(&bin));
+      run_init(run, &bin, (void *)heap);
+      // Generator must be coprime with number of regions
+      EXPECT_EQ(gcd(run->gen, nregs), 1);
+      // Run returns every region exactly once, run_allocate aborts otherwise
+      for (unsigned i = 0; i < nregs; i++) {
+        uintptr_t ptr = (uintptr_t)run_allocate(run, &bin);
+        EXPECT_EQ((ptr - heap) % reg_size, 0);
+      }
+      EXPECT_TRUE(run_is_depleted(run));
+      free(run);
+    }
+  }
+}
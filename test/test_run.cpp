@@ -29,13 +29,6 @@ $9 = 2737271936
 using random_bytes_engine =
     std::independent_bits_engine<std::default_random_engine, 8, unsigned char>;
 
-// Get state of a region from bitmap
-static bstate_t get_bitmap_item(uint8_t *mem, size_t idx) {
-  size_t word = idx / 4;
-  size_t off = idx % 4;
-  return (bstate_t)(mem[word] >> (2 * off) & 3);
-}
-
 namespace {
 class RunUtilsTestSmall : public ::testing::Test {
  protected:
@@ -45,17 +38,9 @@ class RunUtilsTestSmall : public ::testing::Test {
   void SetUp() override {
     init_splitmix32(1);
     bin = (bin_t *)malloc(sizeof(bin_t));
-    ll_init(&bin->run_list_inactive);
-    ll_init(&bin->run_list_active);
-    bin->run_list_active_cnt = 0;
-    bin->avail_regs = 0;
-    bin->reg_size = SMALL_SIZE_MIN_REGION;
-    bin->run_size_pages = RUN_SIZE_SMALL_PAGES;
-    bin->reg_mask_size_bits =
-        ((bin->run_size_pages * PAGE_SIZE) / bin->reg_size) * 2;
+    bin_init(bin, SMALL_SIZE_MIN_REGION);
     heap = malloc(bin->run_size_pages * PAGE_SIZE);
-    run = (run_t *)malloc(sizeof(run_t) +
-                          BITS2BYTES_CEIL(bin->reg_mask_size_bits));
+    run = (run_t *)malloc(run_metadata_size(bin));
   }
 };
 
@@ -66,7 +51,7 @@ TEST_F(RunUtilsTestSmall, RunInit) {
   EXPECT_EQ(run->nfreed, 0);
   EXPECT_EQ(run->gen, 741);
   EXPECT_EQ(run->current_idx, 240);
-  for (int i = 0; i < BITS2BYTES_CEIL(bin->reg_mask_size_bits); i++) {
+  for (size_t i = 0; i < 2 * run_bitset_words(bin); i++) {
     EXPECT_EQ(run->reg_bitmap[i], 0x0);
   }
 }
@@ -80,7 +65,7 @@ TEST_F(RunUtilsTestSmall, RunAllocate) {
   }
   EXPECT_TRUE(run_is_depleted(run));
   for (int i = 0; i < elems; i++) {
-    EXPECT_EQ(get_bitmap_item(run->reg_bitmap, i), STATE_ALLOC);
+    EXPECT_EQ(run_get_region_state(run, bin, i), STATE_ALLOC);
   }
 }
 
@@ -100,6 +85,62 @@ TEST_F(RunUtilsTestSmall, RunDeallocate) {
   EXPECT_TRUE(run_is_freeable(run, bin));
 }
 
+TEST_F(RunUtilsTestSmall, LiveRegionsWalk) {
+  run_init(run, bin, heap);
+  int elems = run->navail;
+  void *chunks[elems];
+  for (int i = 0; i < elems / 2; i++) {
+    chunks[i] = run_allocate(run, bin);
+  }
+  // Free every third allocated region
+  for (int i = 0; i < elems / 2; i += 3) {
+    EXPECT_TRUE(run_deallocate(run, bin, chunks[i]));
+  }
+  size_t live = 0;
+  for (size_t idx = run_next_live(run, bin, 0); idx != SIZE_MAX;
+       idx = run_next_live(run, bin, idx + 1)) {
+    EXPECT_EQ(run_get_region_state(run, bin, idx), STATE_ALLOC);
+    live++;
+  }
+  EXPECT_EQ(live, run_count_live(run, bin));
+  EXPECT_EQ(live, (size_t)(elems / 2 - run->nfreed));
+}
+
+TEST_F(RunUtilsTestSmall, CompactRetiredRun) {
+  run_init(run, bin, heap);
+  int elems = run->navail;
+  void *chunks[elems];
+  for (int i = 0; i < elems; i++) {
+    chunks[i] = run_allocate(run, bin);
+  }
+  for (int i = 0; i < elems; i += 2) {
+    EXPECT_TRUE(run_deallocate(run, bin, chunks[i]));
+  }
+  run_t *compact = (run_t *)malloc(run_metadata_size(bin));
+  EXPECT_LT(run_compact_metadata_size(bin), run_metadata_size(bin));
+  memcpy(compact, run, run_metadata_size(bin));
+  run_compact(compact, bin);
+  EXPECT_TRUE(run_is_compact(compact));
+  EXPECT_FALSE(run_is_compact(run));
+  EXPECT_EQ(compact->entry.key, heap);
+  EXPECT_EQ(compact->nfreed, run->nfreed);
+  EXPECT_EQ(run_count_live(compact, bin), run_count_live(run, bin));
+  for (int i = 0; i < elems; i++) {
+    EXPECT_EQ(run_get_region_state(compact, bin, i),
+              run_get_region_state(run, bin, i));
+  }
+  // Freed regions stay rejected, live ones can still be freed once
+  EXPECT_FALSE(run_deallocate(compact, bin, chunks[0]));
+  for (int i = 1; i < elems; i += 2) {
+    EXPECT_FALSE(run_is_freeable(compact, bin));
+    EXPECT_TRUE(run_deallocate(compact, bin, chunks[i]));
+    EXPECT_FALSE(run_deallocate(compact, bin, chunks[i]));
+  }
+  EXPECT_TRUE(run_is_freeable(compact, bin));
+  EXPECT_EQ(run_next_live(compact, bin, 0), SIZE_MAX);
+  free(compact);
+}
+
 TEST_F(RunUtilsTestSmall, MemoryIntegrity) {
   void *heap = malloc(RUN_SIZE_SMALL_BYTES);
   run_init(run, bin, heap);
@@ -145,17 +186,9 @@ class RunUtilsTestMedium : public ::testing::Test {
   void SetUp() override {
     init_splitmix32(1);
     bin = (bin_t *)malloc(sizeof(bin_t));
-    ll_init(&bin->run_list_inactive);
-    ll_init(&bin->run_list_active);
-    bin->run_list_active_cnt = 0;
-    bin->avail_regs = 0;
-    bin->reg_size = MEDIUM_SIZE_MIN_REGION;
-    bin->run_size_pages = RUN_SIZE_MEDIUM_PAGES;
-    bin->reg_mask_size_bits =
-        ((bin->run_size_pages * PAGE_SIZE) / bin->reg_size) * 2;
+    bin_init(bin, MEDIUM_SIZE_MIN_REGION);
     heap = malloc(bin->run_size_pages * PAGE_SIZE);
-    run = (run_t *)malloc(sizeof(run_t) +
-                          BITS2BYTES_CEIL(bin->reg_mask_size_bits));
+    run = (run_t *)malloc(run_metadata_size(bin));
   }
 };
 
@@ -166,7 +199,7 @@ TEST_F(RunUtilsTestMedium, RunInit) {
   EXPECT_EQ(run->nfreed, 0);
   EXPECT_EQ(run->gen, 5);
   EXPECT_EQ(run->current_idx, 0);
-  for (int i = 0; i < BITS2BYTES_CEIL(bin->reg_mask_size_bits); i++) {
+  for (size_t i = 0; i < 2 * run_bitset_words(bin); i++) {
     EXPECT_EQ(run->reg_bitmap[i], 0x0);
   }
 }
@@ -180,7 +213,7 @@ TEST_F(RunUtilsTestMedium, RunAllocate) {
   }
   EXPECT_TRUE(run_is_depleted(run));
   for (int i = 0; i < elems; i++) {
-    EXPECT_EQ(get_bitmap_item(run->reg_bitmap, i), STATE_ALLOC);
+    EXPECT_EQ(run_get_region_state(run, bin, i), STATE_ALLOC);
   }
 }
 
@@ -246,16 +279,9 @@ class RunUtilsTestLarge : public ::testing::Test {
   void SetUp() override {
     init_splitmix32(1);
     bin = (bin_t *)malloc(sizeof(bin_t));
-    ll_init(&bin->run_list_inactive);
-    ll_init(&bin->run_list_active);
-    bin->run_list_active_cnt = 0;
-    bin->avail_regs = 0;
-    bin->reg_size = LARGE_SIZE_MIN_REGION;
-    bin->run_size_pages = 4;
-    bin->reg_mask_size_bits = 2;
+    bin_init(bin, LARGE_SIZE_MIN_REGION);
     heap = malloc(bin->run_size_pages * PAGE_SIZE);
-    run = (run_t *)malloc(sizeof(run_t) +
-                          BITS2BYTES_CEIL(bin->reg_mask_size_bits));
+    run = (run_t *)malloc(run_metadata_size(bin));
   }
 };
 
@@ -265,7 +291,7 @@ TEST_F(RunUtilsTestLarge, RunInit) {
   EXPECT_EQ(run->entry.key, heap);
   EXPECT_EQ(run->nfreed, 0);
   EXPECT_EQ(run->current_idx, 0);
-  for (int i = 0; i < BITS2BYTES_CEIL(bin->reg_mask_size_bits); i++) {
+  for (size_t i = 0; i < 2 * run_bitset_words(bin); i++) {
     EXPECT_EQ(run->reg_bitmap[i], 0x0);
   }
 }
@@ -278,7 +304,7 @@ TEST_F(RunUtilsTestLarge, RunAllocate) {
     chunks[i] = run_allocate(run, bin);
   }
   EXPECT_TRUE(run_is_depleted(run));
-  EXPECT_EQ((bstate_t)run->reg_bitmap[0], STATE_ALLOC);
+  EXPECT_EQ(run_get_region_state(run, bin, 0), STATE_ALLOC);
 }
 
 TEST_F(RunUtilsTestLarge, RunDeallocate) {
@@ -310,3 +336,47 @@ TEST_F(RunUtilsTestLarge, DoubleFree) {
 }
 
 }  // namespace
+
+class RunUtilsTestAllClasses : public ::testing::TestWithParam<unsigned> {};
+
+TEST_P(RunUtilsTestAllClasses, ValidateIndexMatchesDivision) {
+  unsigned reg_size = GetParam();
+  bin_t bin;
+  init_splitmix32(1);
+  bin_init(&bin, reg_size);
+  void *heap = malloc(bin.run_size_pages * PAGE_SIZE);
+  run_t *run = (run_t *)malloc(run_metadata_size(&bin));
+  run_init(run, &bin, heap);
+  unsigned elems = run->navail;
+  for (unsigned i = 0; i < elems; i++) {
+    (void)run_allocate(run, &bin);
+  }
+  for (unsigned i = 0; i < elems; i++) {
+    uintptr_t reg = (uintptr_t)heap + i * reg_size;
+    EXPECT_EQ(run_validate_ptr(run, &bin, (void *)reg), i);
+    EXPECT_EQ(run_validate_ptr(run, &bin, (void *)(reg + 8)), SIZE_MAX);
+    EXPECT_EQ(run_validate_ptr(run, &bin, (void *)(reg + reg_size - 1)),
+              SIZE_MAX);
+  }
+  // Region-aligned pointer in the unused tail of the run
+  EXPECT_EQ(run_validate_ptr(run, &bin,
+                             (void *)((uintptr_t)heap + elems * reg_size)),
+            SIZE_MAX);
+  free(run);
+  free(heap);
+}
+
+static std::vector<unsigned> all_regular_classes() {
+  std::vector<unsigned> classes;
+  for (unsigned i = SMALL_SIZE_MIN_REGION; i <= SMALL_SIZE_MAX_REGION;
+       i += SMALL_SIZE_CLASS_ALIGNMENT)
+    classes.push_back(i);
+  for (unsigned i = MEDIUM_SIZE_MIN_REGION; i <= MEDIUM_SIZE_MAX_REGION; i *= 2)
+    classes.push_back(i);
+  for (unsigned i = LARGE_SIZE_MIN_REGION; i <= LARGE_SIZE_MAX_REGION; i *= 2)
+    classes.push_back(i);
+  return classes;
+}
+
+INSTANTIATE_TEST_SUITE_P(RunUtils, RunUtilsTestAllClasses,
+                         ::testing::ValuesIn(all_regular_classes()));
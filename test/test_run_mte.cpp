@@ -42,8 +42,7 @@ class RunUtilsMTESmall : public ::testing::Test {
     heap = mmap(NULL, bin->run_size_pages * PAGE_SIZE,
                 PROT_READ | PROT_WRITE | PROT_MTE, MAP_PRIVATE | MAP_ANONYMOUS,
                 -1, 0);
-    run = (run_t *)malloc(sizeof(run_t) +
-                          BITS2BYTES_CEIL(bin->reg_mask_size_bits));
+    run = (run_t *)malloc(run_metadata_size(bin));
     run_init(run, bin, heap);
   }
 };
@@ -61,7 +60,7 @@ TEST_P(RunUtilsMTEParametrized, DifferentTagsForNeighbors) {
                     PROT_READ | PROT_WRITE | PROT_MTE,
                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
   run_t *run =
-      (run_t *)malloc(sizeof(run_t) + BITS2BYTES_CEIL(bin->reg_mask_size_bits));
+      (run_t *)malloc(run_metadata_size(bin));
   run_init(run, bin, heap);
   unsigned elems = run->navail;
   std::vector<void *> chunks = get_chunks(run, bin);
@@ -123,8 +122,7 @@ class RunUtilsMTEMedium : public ::testing::Test {
     heap = mmap(NULL, bin->run_size_pages * PAGE_SIZE,
                 PROT_READ | PROT_WRITE | PROT_MTE, MAP_PRIVATE | MAP_ANONYMOUS,
                 -1, 0);
-    run = (run_t *)malloc(sizeof(run_t) +
-                          BITS2BYTES_CEIL(bin->reg_mask_size_bits));
+    run = (run_t *)malloc(run_metadata_size(bin));
     run_init(run, bin, heap);
   }
 };
@@ -171,8 +169,7 @@ class RunUtilsMTEDeathLarge : public ::testing::Test {
     heap = mmap(NULL, bin->run_size_pages * PAGE_SIZE,
                 PROT_READ | PROT_WRITE | PROT_MTE, MAP_PRIVATE | MAP_ANONYMOUS,
                 -1, 0);
-    run = (run_t *)malloc(sizeof(run_t) +
-                          BITS2BYTES_CEIL(bin->reg_mask_size_bits));
+    run = (run_t *)malloc(run_metadata_size(bin));
     run_init(run, bin, heap);
   }
 };
@@ -16,6 +16,14 @@ TEST(SizeClass, Small) {
       2 * SMALL_SIZE_CLASS_ALIGNMENT);
 }
 
+TEST(SizeClass, AlignupAnyClass) {
+  EXPECT_EQ(alignup_size(1), SMALL_SIZE_MIN_REGION);
+  EXPECT_EQ(alignup_size(SMALL_SIZE_MAX_REGION), SMALL_SIZE_MAX_REGION);
+  EXPECT_EQ(alignup_size(SMALL_SIZE_MAX_REGION + 1), MEDIUM_SIZE_MIN_REGION);
+  EXPECT_EQ(alignup_size(MEDIUM_SIZE_MAX_REGION + 1), LARGE_SIZE_MIN_REGION);
+  EXPECT_EQ(alignup_size(LARGE_SIZE_MAX_REGION), LARGE_SIZE_MAX_REGION);
+}
+
 TEST(SizeClass, Medium) {
   EXPECT_TRUE(IS_SIZE_MEDIUM(MEDIUM_SIZE_MIN_REGION));
   EXPECT_TRUE(IS_SIZE_MEDIUM(MEDIUM_SIZE_MAX_REGION));
@@ -51,3 +59,25 @@ TEST(SizeClass, LargeSizeToIdx) {
     EXPECT_EQ(size_to_idx_large(next), i);
   }
 }
+
+TEST(SizeClass, IdxToSize) {
+  unsigned size;
+  for (unsigned i = 0; i < NO_SMALL_SIZE_CLASSES; i++) {
+    size = idx_to_size(i);
+    ASSERT_TRUE(IS_SIZE_SMALL(size));
+    EXPECT_EQ(SIZE_TO_IDX_SMALL(size), i);
+  }
+  for (unsigned i = 0; i < NO_MEDIUM_SIZE_CLASSES; i++) {
+    size = idx_to_size(NO_SMALL_SIZE_CLASSES + i);
+    ASSERT_TRUE(IS_SIZE_MEDIUM(size));
+    EXPECT_EQ(size_to_idx_medium(size), i);
+  }
+  for (unsigned i = 0; i < NO_LARGE_SIZE_CLASSES; i++) {
+    size = idx_to_size(NO_SMALL_SIZE_CLASSES + NO_MEDIUM_SIZE_CLASSES + i);
+    ASSERT_TRUE(IS_SIZE_LARGE(size));
+    EXPECT_EQ(size_to_idx_large(size), i);
+  }
+  EXPECT_EQ(idx_to_size(NO_SMALL_SIZE_CLASSES + NO_MEDIUM_SIZE_CLASSES +
+                        NO_LARGE_SIZE_CLASSES - 1),
+            LARGE_SIZE_MAX_REGION);
+}
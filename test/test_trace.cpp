@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+extern "C" {
+#include <sealloc/trace.h>
+}
+
+class TraceTest : public ::testing::Test {
+ protected:
+  char path[32] = "/tmp/sealloc_trace_XXXXXX";
+  trace_t trace;
+  void SetUp() override {
+    int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    close(fd);
+    trace_init(&trace);
+  }
+  void TearDown() override { unlink(path); }
+
+  std::vector<trace_record_t> read_records(trace_header_t *header) {
+    std::vector<trace_record_t> recs;
+    trace_record_t rec;
+    FILE *fp = fopen(path, "rb");
+    EXPECT_NE(fp, nullptr);
+    EXPECT_EQ(fread(header, sizeof(*header), 1, fp), 1);
+    while (fread(&rec, sizeof(rec), 1, fp) == 1) recs.push_back(rec);
+    fclose(fp);
+    return recs;
+  }
+};
+
+TEST_F(TraceTest, ClosedByDefault) {
+  trace_t zeroed;
+  memset(&zeroed, 0, sizeof(zeroed));
+  EXPECT_FALSE(trace_is_open(&zeroed));
+  EXPECT_FALSE(trace_is_open(&trace));
+  // Closing closed trace does nothing
+  trace_close(&zeroed);
+  trace_close(&trace);
+  EXPECT_FALSE(trace_open(&trace, "/nonexistent/dir/trace"));
+  EXPECT_FALSE(trace_is_open(&trace));
+}
+
+TEST_F(TraceTest, HeaderAndRecords) {
+  trace_header_t header;
+  int x, y;
+  ASSERT_TRUE(trace_open(&trace, path));
+  ASSERT_TRUE(trace_is_open(&trace));
+  trace_record(&trace, TRACE_OP_MALLOC, &x, 16, 0);
+  trace_record(&trace, TRACE_OP_REALLOC, &y, 32, (uintptr_t)&x);
+  trace_record(&trace, TRACE_OP_FREE, &y, 0, 0);
+  trace_close(&trace);
+  EXPECT_FALSE(trace_is_open(&trace));
+
+  std::vector<trace_record_t> recs = read_records(&header);
+  EXPECT_EQ(memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)), 0);
+  EXPECT_EQ(header.version, TRACE_FORMAT_VERSION);
+  EXPECT_EQ(header.record_size, sizeof(trace_record_t));
+  EXPECT_EQ(header.pid, (uint32_t)getpid());
+  ASSERT_EQ(recs.size(), 3);
+  EXPECT_EQ(recs[0].op, TRACE_OP_MALLOC);
+  EXPECT_EQ(recs[0].id, (uintptr_t)&x);
+  EXPECT_EQ(recs[0].size, 16);
+  EXPECT_EQ(recs[1].op, TRACE_OP_REALLOC);
+  EXPECT_EQ(recs[1].arg, (uintptr_t)&x);
+  EXPECT_EQ(recs[2].op, TRACE_OP_FREE);
+  EXPECT_LE(recs[0].timestamp, recs[1].timestamp);
+  EXPECT_LE(recs[1].timestamp, recs[2].timestamp);
+  EXPECT_NE(recs[0].tid, 0);
+  EXPECT_EQ(recs[0].tid, recs[2].tid);
+}
+
+TEST_F(TraceTest, CrossesWindows) {
+  trace_header_t header;
+  const size_t n = 3 * TRACE_WINDOW_RECORDS;
+  ASSERT_TRUE(trace_open(&trace, path));
+  for (size_t i = 0; i < n; i++)
+    trace_record(&trace, TRACE_OP_MALLOC, (void *)(i + 1), i, 0);
+  // Unused tail of the last window is still part of the file
+  struct stat st;
+  ASSERT_EQ(stat(path, &st), 0);
+  EXPECT_EQ((size_t)st.st_size,
+            4 * TRACE_WINDOW_RECORDS * sizeof(trace_record_t));
+  trace_close(&trace);
+
+  std::vector<trace_record_t> recs = read_records(&header);
+  ASSERT_EQ(recs.size(), n);
+  for (size_t i = 0; i < n; i++) {
+    ASSERT_EQ(recs[i].id, i + 1);
+    ASSERT_EQ(recs[i].size, i);
+  }
+}